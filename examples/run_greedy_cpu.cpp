@@ -2,6 +2,7 @@
 #include "infer_engine/model/weights.hpp"
 #include "infer_engine/runtime/runtime_ctx.hpp"
 #include "infer_engine/core/tensor.hpp"
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <vector>
@@ -3,15 +3,18 @@
 #include "infer_engine/model/weights.hpp"
 #include "infer_engine/runtime/runtime_ctx.hpp"
 #include "infer_engine/core/tensor.hpp"
+#include "infer_engine/layers/ops/linear.hpp"
 
 #include <algorithm>
 #include <cctype>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -117,7 +120,9 @@ private:
 
 class Model {
 public:
-    explicit Model(const std::string& model_dir, int64_t max_seq_len = 2048) {
+    explicit Model(const std::string& model_dir, int64_t max_seq_len = 2048,
+                   const ie::LoadOptions& load_opts = {}, ie::DType kv_dtype = ie::DType::F16,
+                   ie::KVLayout kv_layout = ie::KVLayout::SeqMajor) {
         {
             std::ifstream f(model_dir + "/config.json");
             if (f) {
@@ -125,30 +130,41 @@ public:
                 eos_token_id_ = parse_int_field(content, "eos_token_id", 2);
             }
         }
-        ie::load_mistral_safetensors(model_dir, cfg_, weights_);
-        ctx_ = std::make_unique<ie::RuntimeCtx>(cfg_, weights_, max_seq_len);
+        ie::load_mistral_safetensors(model_dir, cfg_, weights_, load_opts);
+        ctx_ = std::make_unique<ie::RuntimeCtx>(cfg_, weights_, max_seq_len, kv_dtype, kv_layout);
         const int64_t head_dim = cfg_.d_model / cfg_.n_heads;
+        const double row_bytes = static_cast<double>(head_dim * static_cast<int64_t>(ie::dtype_bytes(kv_dtype)))
+            + (ie::kv_dtype_scaled(kv_dtype) ? sizeof(float) : 0.0);
         const double kv_gb = 2.0 * static_cast<double>(cfg_.n_layers) * static_cast<double>(max_seq_len)
-            * static_cast<double>(cfg_.n_kv_heads) * static_cast<double>(head_dim) * 2.0
+            * static_cast<double>(cfg_.n_kv_heads) * row_bytes
             / (1024.0 * 1024.0 * 1024.0);
         std::cout << "[Config] layers=" << cfg_.n_layers
                   << " n_heads=" << cfg_.n_heads
                   << " n_kv_heads=" << cfg_.n_kv_heads
                   << " head_dim=" << head_dim
                   << " max_seq_len=" << max_seq_len
-                  << " kv_dtype=F16 expected_kv_gb~" << std::fixed << std::setprecision(2) << kv_gb << "\n";
+                  << " kv_dtype=" << ie::dtype_name(kv_dtype) << " expected_kv_gb~" << std::fixed << std::setprecision(2) << kv_gb << "\n";
     }
 
-    std::vector<float> forward_tokens(const std::vector<int64_t>& token_ids) {
-        if (token_ids.empty()) return {};
-        std::vector<float> last_logits;
-        for (int64_t pos = 0; pos < static_cast<int64_t>(token_ids.size()); ++pos) {
-            const int64_t tok = token_ids[static_cast<size_t>(pos)];
-            ie::Tensor logits = ctx_->forward_decode(static_cast<int32_t>(tok), pos);
-            const float* lp = logits.view.ptr<const float>();
-            last_logits.assign(lp, lp + cfg_.vocab_size);
+    // Feed tokens at the next positions; returns the top_k candidates for
+    // the token after the last one (full logits are never materialized).
+    // Several tokens (the prompt) run as one batched prefill.
+    std::vector<ie::ops::TopKEntry> forward_tokens(const std::vector<int64_t>& token_ids, int64_t top_k) {
+        if (token_ids.size() == 1) {
+            return ctx_->forward_decode_topk(static_cast<int32_t>(token_ids[0]), pos_++, top_k);
         }
-        return last_logits;
+        std::vector<int32_t> tokens(token_ids.begin(), token_ids.end());
+        std::vector<ie::ops::TopKEntry> cands = ctx_->forward_prefill_topk(tokens, pos_, top_k);
+        pos_ += static_cast<int64_t>(tokens.size());
+        return cands;
+    }
+
+    // KV memory actually backed so far vs. reserved for max_seq_len
+    void report_kv_memory() {
+        const ie::KVCache& kv = ctx_->kv();
+        std::cout << "[KVCache] committed " << std::fixed << std::setprecision(1)
+                  << static_cast<double>(kv.committed_bytes()) / (1024.0 * 1024.0) << " MB of "
+                  << static_cast<double>(kv.reserved_bytes()) / (1024.0 * 1024.0) << " MB reserved\n";
     }
 
     int64_t eos_token_id() const { return eos_token_id_; }
@@ -159,15 +175,19 @@ private:
     ie::ModelWeights weights_{};
     std::unique_ptr<ie::RuntimeCtx> ctx_{};
     int64_t eos_token_id_{2};
+    int64_t pos_{0};
 };
 
-static int64_t argmax_id(const std::vector<float>& logits) {
-    if (logits.empty()) return 0;
-    size_t best = 0; float bestv = logits[0];
-    for (size_t i = 1; i < logits.size(); ++i) {
-        if (logits[i] > bestv) { bestv = logits[i]; best = i; }
+// Greedy when top_k == 1, otherwise sample from the softmax over the candidates
+static int64_t pick_token(const std::vector<ie::ops::TopKEntry>& cands, float temperature, std::mt19937& rng) {
+    if (cands.empty()) return 0;
+    if (cands.size() == 1 || temperature <= 0.0f) return cands[0].id;
+    std::vector<double> w(cands.size());
+    for (size_t i = 0; i < cands.size(); ++i) {
+        w[i] = std::exp(static_cast<double>(cands[i].value - cands[0].value) / temperature);
     }
-    return static_cast<int64_t>(best);
+    std::discrete_distribution<size_t> dist(w.begin(), w.end());
+    return cands[dist(rng)].id;
 }
 
 } // namespace iegen
@@ -175,7 +195,9 @@ static int64_t argmax_id(const std::vector<float>& logits) {
 int main(int argc, char** argv) {
     using namespace iegen;
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <model_dir> [--max_new_tokens N] [--prompt \"text...\"]\n";
+        std::cerr << "Usage: " << argv[0] << " <model_dir> [--max_new_tokens N] [--prompt \"text...\"] [--pack_weights] [--fuse_qkv]"
+                     " [--top_k K] [--temperature T] [--seed S] [--isa scalar|avx2|avx512]"
+                     " [--quantize i8|q4] [--group_size G] [--zero_points] [--quant_act] [--kv_dtype f16|i8|f8] [--kv_layout seq|head]\n";
         return 1;
     }
 
@@ -183,6 +205,13 @@ int main(int argc, char** argv) {
     int max_new_tokens = 50;
     int64_t max_seq_len = 2048;
     std::string prompt;
+    int64_t top_k = 1;
+    float temperature = 1.0f;
+    unsigned seed = 0;
+    std::string isa;
+    ie::LoadOptions load_opts;
+    ie::DType kv_dtype = ie::DType::F16;
+    ie::KVLayout kv_layout = ie::KVLayout::SeqMajor;
     for (int i = 2; i < argc; ++i) {
         std::string a = argv[i];
         if (a == "--max_new_tokens" && i + 1 < argc) {
@@ -191,6 +220,40 @@ int main(int argc, char** argv) {
             max_seq_len = std::atoll(argv[++i]);
         } else if (a == "--prompt" && i + 1 < argc) {
             prompt = argv[++i];
+        } else if (a == "--pack_weights") {
+            load_opts.pack_weights = true;
+        } else if (a == "--fuse_qkv") {
+            load_opts.fuse_qkv = true;
+        } else if (a == "--top_k" && i + 1 < argc) {
+            top_k = std::max<int64_t>(1, std::atoll(argv[++i]));
+        } else if (a == "--temperature" && i + 1 < argc) {
+            temperature = static_cast<float>(std::atof(argv[++i]));
+        } else if (a == "--seed" && i + 1 < argc) {
+            seed = static_cast<unsigned>(std::atoll(argv[++i]));
+        } else if (a == "--quantize" && i + 1 < argc) {
+            const std::string q = argv[++i];
+            if (q == "i8") load_opts.quantize = ie::WeightQuant::I8;
+            else if (q == "q4") load_opts.quantize = ie::WeightQuant::Q4;
+            else { std::cerr << "Unknown --quantize scheme: " << q << "\n"; return 1; }
+        } else if (a == "--group_size" && i + 1 < argc) {
+            load_opts.quant_group_size = std::atoll(argv[++i]);
+        } else if (a == "--zero_points") {
+            load_opts.quant_zero_points = true;
+        } else if (a == "--quant_act") {
+            load_opts.quant_activations = true;
+        } else if (a == "--kv_dtype" && i + 1 < argc) {
+            const std::string k = argv[++i];
+            if (k == "f16") kv_dtype = ie::DType::F16;
+            else if (k == "i8") kv_dtype = ie::DType::I8;
+            else if (k == "f8") kv_dtype = ie::DType::F8;
+            else { std::cerr << "Unknown --kv_dtype: " << k << "\n"; return 1; }
+        } else if (a == "--kv_layout" && i + 1 < argc) {
+            const std::string l = argv[++i];
+            if (l == "seq") kv_layout = ie::KVLayout::SeqMajor;
+            else if (l == "head") kv_layout = ie::KVLayout::HeadMajor;
+            else { std::cerr << "Unknown --kv_layout: " << l << "\n"; return 1; }
+        } else if (a == "--isa" && i + 1 < argc) {
+            isa = argv[++i];
         }
     }
     if (prompt.empty()) {
@@ -198,6 +261,10 @@ int main(int argc, char** argv) {
     }
 
     try {
+        // Kernel level must be fixed before --pack_weights lays out the panels
+        if (!isa.empty()) ie::ops::set_linear_isa(ie::parse_isa(isa));
+        std::cout << "[Kernels] cpu: " << ie::cpu_features_string()
+                  << " | linear isa=" << ie::isa_name(ie::ops::linear_isa()) << "\n";
         std::cout << "Loading tokenizer...\n";
         Tokenizer tokenizer(model_dir);
         std::cout << "Encoding prompt...\n";
@@ -205,20 +272,22 @@ int main(int argc, char** argv) {
         if (input_ids.empty()) { std::cerr << "Empty encoded prompt.\n"; return 1; }
 
         std::cout << "Loading model...\n";
-        Model model(model_dir, max_seq_len);
+        Model model(model_dir, max_seq_len, load_opts, kv_dtype, kv_layout);
 
         std::cout << "Prefill on " << input_ids.size() << " tokens...\n";
-        std::vector<float> logits = model.forward_tokens(input_ids);
+        std::vector<ie::ops::TopKEntry> cands = model.forward_tokens(input_ids, top_k);
 
         const int64_t eos_id = model.eos_token_id();
+        std::mt19937 rng(seed);
         std::cout << "Generating up to " << max_new_tokens << " tokens (eos=" << eos_id << ")...\n";
         for (int step = 0; step < max_new_tokens; ++step) {
-            int64_t next_id = argmax_id(logits);
+            int64_t next_id = pick_token(cands, temperature, rng);
             input_ids.push_back(next_id);
             if (next_id == eos_id) { std::cout << "EOS at step " << step << "\n"; break; }
-            logits = model.forward_tokens({next_id});
+            cands = model.forward_tokens({next_id}, top_k);
         }
 
+        model.report_kv_memory();
         std::cout << "Decoding...\n";
         std::string out = tokenizer.decode(input_ids);
         std::cout << "\n=== OUTPUT ===\n" << out << "\n";
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+
+namespace ie {
+
+constexpr size_t kCacheLineBytes = 64;
+constexpr size_t kHugePageBytes = size_t(2) << 20;
+
+struct AlignedDeleter {
+    void operator()(void* p) const;
+};
+
+/** Owning pointer for memory from alloc_aligned. */
+using AlignedPtr = std::unique_ptr<void, AlignedDeleter>;
+
+/**
+ * Allocate `bytes` of uninitialized host memory aligned to `alignment`.
+ * With huge_pages the block is 2 MB aligned, padded to whole 2 MB pages and
+ * advised for transparent huge pages, which keeps large read-mostly buffers
+ * (packed weights) to a handful of TLB entries.
+ */
+AlignedPtr alloc_aligned(size_t bytes, size_t alignment = kCacheLineBytes, bool huge_pages = false);
+
+/**
+ * Zero-initialized memory that is reserved up front but committed lazily:
+ * an anonymous MAP_NORESERVE mapping whose pages the kernel backs on first
+ * write, so a large buffer that is filled front to back (the KV cache) costs
+ * RSS only for what has been written. huge_pages advises transparent huge
+ * pages (2 MB aligned, whole pages). Falls back to calloc where mmap is
+ * unavailable.
+ */
+class LazyRegion {
+public:
+    LazyRegion() = default;
+    explicit LazyRegion(size_t bytes, bool huge_pages = false);
+    ~LazyRegion();
+    LazyRegion(LazyRegion&& other) noexcept;
+    LazyRegion& operator=(LazyRegion&& other) noexcept;
+    LazyRegion(const LazyRegion&) = delete;
+    LazyRegion& operator=(const LazyRegion&) = delete;
+
+    void* data() const { return data_; }
+    size_t reserved_bytes() const { return bytes_; }
+    // Bytes currently backed by physical pages (mincore; reserved_bytes
+    // without mmap)
+    size_t committed_bytes() const;
+    // Give the backing pages back to the kernel; the region reads as zeros
+    // again and is recommitted on the next write
+    void decommit();
+
+private:
+    void* data_ = nullptr;
+    size_t bytes_ = 0;
+    bool mapped_ = false;
+};
+
+} // namespace ie
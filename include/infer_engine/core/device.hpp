@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace ie {
+
+/** Host CPU features relevant to the kernels, detected once via CPUID. */
+struct CpuFeatures {
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+    bool avx512_vnni = false;
+    bool avx512_bf16 = false;
+    bool avx_vnni = false;
+    bool amx_tile = false;
+    bool amx_bf16 = false;
+    bool amx_int8 = false;
+};
+
+const CpuFeatures& cpu_features();
+
+/**
+ * Instruction-set levels the kernels are built for. Each level lives in its
+ * own translation unit compiled with matching flags; the rest of the engine
+ * is built for the baseline target so one binary runs on every host.
+ */
+enum class Isa : uint8_t { Scalar = 0, AVX2 = 1, AVX512 = 2 };
+
+const char* isa_name(Isa isa);
+
+/** Parse "scalar" / "avx2" / "avx512"; throws std::invalid_argument otherwise. */
+Isa parse_isa(const std::string& name);
+
+/** True if the kernels for isa were compiled in and the host can run them. */
+bool isa_supported(Isa isa);
+
+/** Highest supported level. */
+Isa best_isa();
+
+/** One-line summary of the detected features, for startup logs. */
+std::string cpu_features_string();
+
+} // namespace ie
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+
+namespace ie {
+namespace half {
+
+// Scalar 16-bit float conversions shared by kernels that need a tail/fallback
+// path. Vectorized widening lives next to the kernels that use it.
+
+inline float bf16_to_f32(uint16_t h) {
+    uint32_t u = static_cast<uint32_t>(h) << 16;
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+inline float f16_to_f32(uint16_t h) {
+    uint32_t sign = (h & 0x8000u) << 16;
+    uint32_t exp = (h & 0x7C00u) >> 10;
+    uint32_t mant = (h & 0x03FFu);
+    uint32_t u;
+    if (exp == 0) {
+        if (mant == 0) { u = sign; }
+        else {
+            // subnormal: renormalize
+            exp = 127 - 15 + 1;
+            while ((mant & 0x0400u) == 0) { mant <<= 1; exp--; }
+            mant &= 0x03FFu;
+            u = sign | (exp << 23) | (mant << 13);
+        }
+    } else if (exp == 0x1F) {
+        u = sign | 0x7F800000u | (mant << 13); // inf/NaN
+    } else {
+        u = sign | ((exp - 15 + 127) << 23) | (mant << 13);
+    }
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// Round-to-nearest-even F32 -> F16 (same behaviour as the KV cache writer)
+inline uint16_t f32_to_f16(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    uint32_t sign = (x >> 31) & 0x1;
+    int32_t exp = (int32_t)((x >> 23) & 0xFF) - 127 + 15;
+    uint32_t mant = x & 0x7FFFFF;
+    if (((x >> 23) & 0xFF) == 0xFF) {
+        return (uint16_t)((sign << 15) | (0x1F << 10) | (mant ? 0x200 : 0));
+    }
+    if (exp <= 0) {
+        if (exp < -10) return (uint16_t)(sign << 15);
+        mant |= 0x800000;
+        uint32_t t = mant >> (1 - exp + 13);
+        if ((mant >> (1 - exp + 12)) & 1) t += 1;
+        return (uint16_t)((sign << 15) | t);
+    }
+    if (exp >= 31) return (uint16_t)((sign << 15) | (0x1F << 10));
+    uint32_t e = (uint32_t)exp;
+    uint32_t m = mant >> 13;
+    uint32_t rem = mant & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (m & 1))) {
+        m += 1;
+        if (m == 0x400) { m = 0; e += 1; if (e >= 31) return (uint16_t)((sign << 15) | (0x1F << 10)); }
+    }
+    return (uint16_t)((sign << 15) | (e << 10) | m);
+}
+
+inline uint16_t f32_to_bf16(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    if ((x & 0x7FFFFFFFu) > 0x7F800000u) return (uint16_t)((x >> 16) | 0x40); // quiet NaN
+    x += 0x7FFFu + ((x >> 16) & 1u);
+    return (uint16_t)(x >> 16);
+}
+
+// FP8 E4M3 (bias 7, no infinities, 0x7F/0xFF are NaN, max finite 448).
+// Encoding rounds to nearest even and saturates to +-448.
+inline float e4m3_to_f32(uint8_t v) {
+    const float sign = (v & 0x80u) ? -1.0f : 1.0f;
+    const int e = (v >> 3) & 0xF, m = v & 0x7;
+    if (e == 0xF && m == 0x7) return std::nanf("");
+    if (e == 0) return sign * std::ldexp(static_cast<float>(m), -9); // subnormal: m * 2^-9
+    return sign * std::ldexp(1.0f + static_cast<float>(m) / 8.0f, e - 7);
+}
+
+inline uint8_t f32_to_e4m3(float f) {
+    const uint8_t sign = std::signbit(f) ? 0x80 : 0x00;
+    const float a = std::fabs(f);
+    if (std::isnan(f)) return static_cast<uint8_t>(sign | 0x7F);
+    if (a >= 448.0f) return static_cast<uint8_t>(sign | 0x7E);
+    if (a < 0.015625f) {
+        // Subnormal range (below 2^-6): steps of 2^-9; 8 rounds up to the smallest normal
+        return static_cast<uint8_t>(sign | static_cast<int>(std::nearbyint(a * 512.0f)));
+    }
+    int e;
+    const float fr = std::frexp(a, &e); // a = fr * 2^e, fr in [0.5, 1)
+    int m = static_cast<int>(std::nearbyint((fr * 2.0f - 1.0f) * 8.0f));
+    int biased = e - 1 + 7;
+    if (m == 8) { m = 0; ++biased; }
+    if (biased > 15 || (biased == 15 && m == 7)) return static_cast<uint8_t>(sign | 0x7E);
+    return static_cast<uint8_t>(sign | (biased << 3) | m);
+}
+
+} // namespace half
+} // namespace ie
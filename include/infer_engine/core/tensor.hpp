@@ -25,6 +25,9 @@ namespace ie{
         DType dt = DType::F32; 
         std::vector<int64_t> shape;
         std::vector<int64_t> stride; 
+        Layout layout = Layout::RowMajor;
+        int64_t pack_k = 0;                 // PackedPanels: chunk depth the panels were packed with
+        QuantParams quant;                  // set for quantized weights only
 
         bool defined() const { return data != nullptr; }
         int64_t rank() const { return (int64_t)shape.size();}
@@ -32,9 +35,9 @@ namespace ie{
             int64_t n=1; for (auto d: shape) n*=d; return n; 
         }
         size_t itemsize() const { return dtype_bytes(dt); }
-        size_t nbytes() const {return (size_t)numel() * itemsize();}
+        size_t nbytes() const {return dtype_nbytes(dt, numel());}
         bool is_contiguous()  const{
-           return stride == row_major_strides(shape);
+           return layout == Layout::RowMajor && stride == row_major_strides(shape);
         }  
 
         template <typename T> T* ptr() { return reinterpret_cast<T*>(data);}
@@ -49,7 +52,7 @@ namespace ie{
 
         static Tensor empty(const std::vector<int64_t>& shape, DType dt){
             Tensor t; 
-            size_t bytes = (size_t)ie::Shape{shape}.numel()*dtype_bytes(dt);
+            size_t bytes = dtype_nbytes(dt, ie::Shape{shape}.numel());
             t.storage = std::unique_ptr<uint8_t[]>(new uint8_t[bytes]());
             t.view.data = t.storage.get();
             t.view.dt = dt;
@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ie {
+
+struct ThreadPoolOptions {
+    int num_threads = 0;      // total participants including the caller; 0 = all usable cores
+    int spin_us = 100;        // how long an idle worker spins before parking
+    bool pin_threads = false; // pin worker k to the k-th CPU of the process affinity mask
+
+    /** Defaults overridden by IE_NUM_THREADS, IE_SPIN_US and IE_PIN_THREADS. */
+    static ThreadPoolOptions from_env();
+};
+
+/**
+ * Persistent fork/join pool used by every parallel kernel in the engine.
+ *
+ * run(n, ...) executes tasks 0..n-1. Each participant (the calling thread plus
+ * the workers) starts with a contiguous share of the index range in its own
+ * deque, pops from the front of it and, once empty, steals the back half of a
+ * victim's range. Idle workers spin for spin_us and then park, so the pool
+ * trades CPU burn for wake-up latency in one place.
+ *
+ * Calls made from inside a task, or while another thread is using the pool,
+ * run inline on the calling thread.
+ */
+class ThreadPool {
+public:
+    using TaskFn = void (*)(void* ctx, int64_t i);
+
+    explicit ThreadPool(const ThreadPoolOptions& opts = ThreadPoolOptions::from_env());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** Participants per parallel region (workers + caller). */
+    int num_threads() const { return static_cast<int>(workers_.size()) + 1; }
+
+    /** Run fn(ctx, i) for every i in [0, n) and return once all have finished. */
+    void run(int64_t n, TaskFn fn, void* ctx);
+
+    /** Process-wide pool, created on first use from ThreadPoolOptions::from_env(). */
+    static ThreadPool& global();
+
+private:
+    // [lo, hi) packed into one word so pop and steal are a single CAS
+    struct alignas(64) Range {
+        std::atomic<uint64_t> bits{0};
+    };
+
+    void worker_loop(int id);
+    void participate(int id);
+    bool pop(int id, int64_t& i);
+    bool steal(int id);
+    void execute(int64_t i);
+
+    ThreadPoolOptions opts_;
+    std::vector<std::thread> workers_;
+    std::unique_ptr<Range[]> ranges_;
+    std::mutex submit_mu_;
+
+    // Current job; written by the submitting thread before epoch_ is bumped
+    TaskFn fn_ = nullptr;
+    void* ctx_ = nullptr;
+    std::exception_ptr error_;
+    std::atomic<bool> error_set_{false};
+
+    alignas(64) std::atomic<uint64_t> epoch_{0};
+    alignas(64) std::atomic<int64_t> pending_{0};
+    alignas(64) std::atomic<int> busy_{0};
+    std::atomic<bool> closed_{true};
+    std::atomic<bool> stop_{false};
+};
+
+/**
+ * Run body(i) for i in [0, n) on the global pool. Each index is one task, so
+ * callers pass block indices sized to amortize scheduling (a few microseconds
+ * of work or more).
+ */
+template <class F>
+void parallel_for(int64_t n, F&& body) {
+    using Fn = std::remove_reference_t<F>;
+    ThreadPool::global().run(n, [](void* ctx, int64_t i) { (*static_cast<Fn*>(ctx))(i); },
+                             const_cast<void*>(static_cast<const void*>(&body)));
+}
+
+} // namespace ie
@@ -9,21 +9,64 @@ namespace ie{
 
     //Basic status macro 
 
-enum class DType : uint8_t { F32 = 0, F16 = 1, BF16 = 2, I8 = 3};
+// Q4: 4-bit group-quantized weights. Each row is stored as blocks of 32
+// elements in 16 bytes; byte i of a block holds element i in its low nibble
+// and element i + 16 in its high nibble (so one unpack yields two contiguous
+// halves). Sizes of sub-byte dtypes go through dtype_bits / dtype_nbytes.
+// F8: FP8 E4M3 ("fn" variant: exponent bias 7, no infinities, max 448).
+enum class DType : uint8_t { F32 = 0, F16 = 1, BF16 = 2, I8 = 3, Q4 = 4, F8 = 5 };
+
+// Physical arrangement of a rank-2 weight. PackedPanels is produced by
+// ops::pack_weight and is only understood by ops::linear.
+enum class Layout : uint8_t { RowMajor = 0, PackedPanels = 1 };
+
+// Dequantization parameters of a quantized weight view. The pointed-to
+// storage is owned by whoever owns the view's data.
+//   I8 (group_size 0): w[j, k] = scales[j] * q[j, k]
+//   Q4 (group_size G): w[j, k] = scales[j, k / G] * (q[j, k] - z), with
+//       z = zeros[j, k / G] when zeros is set, else the midpoint 8
+// I8 weights may also carry SmoothQuant migration scales: q encodes
+// W[j, k] * smooth[k], so the input is divided by smooth before the product.
+// dynamic_act asks linear to quantize each input row to int8 at run time and
+// use the int8 x int8 kernels instead of widening q to F32.
+struct QuantParams {
+    const float* scales = nullptr;
+    const float* zeros = nullptr;
+    int64_t group_size = 0;
+    const float* smooth = nullptr;   // [D_in], I8 only
+    bool dynamic_act = false;        // I8 only
+
+    bool defined() const { return scales != nullptr; }
+};
 
 inline const char* dtype_name(DType dt){
 
-    switch(dt){ case DType::F32: return "f32"; case DType::F16: return "f16"; case DType::BF16: return "BF16"; case DType::I8: return "I8"; }
+    switch(dt){ case DType::F32: return "f32"; case DType::F16: return "f16"; case DType::BF16: return "BF16"; case DType::I8: return "I8"; case DType::Q4: return "Q4"; case DType::F8: return "F8"; }
     return "unknown";
 }
 
-inline size_t dtype_bytes(DType dt){
+inline size_t dtype_bits(DType dt){
 
-    switch(dt){ case DType::F32: return 4; case DType::F16: return 2; 
-                case DType::BF16: return 2; case DType::I8: return 1;}
+    switch(dt){ case DType::F32: return 32; case DType::F16: return 16;
+                case DType::BF16: return 16; case DType::I8: return 8; case DType::Q4: return 4;
+                case DType::F8: return 8;}
     throw std::runtime_error("bad dtype");
 }
 
+// Bytes per element; only defined for whole-byte dtypes
+inline size_t dtype_bytes(DType dt){
+
+    const size_t bits = dtype_bits(dt);
+    if (bits % 8 != 0) throw std::runtime_error(std::string("dtype_bytes: ") + dtype_name(dt) + " is sub-byte, use dtype_nbytes");
+    return bits / 8;
+}
+
+// Storage bytes for n elements, rounded up to whole bytes
+inline size_t dtype_nbytes(DType dt, int64_t n){
+
+    return ((size_t)n * dtype_bits(dt) + 7) / 8;
+}
+
 struct Shape {
 
     std::vector<int64_t> dims; 
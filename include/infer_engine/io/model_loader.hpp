@@ -1,15 +1,85 @@
 #pragma once
+#include "infer_engine/core/types.hpp"
 #include <string>
 
 namespace ie {
 struct ModelCfg;
 class ModelWeights;
+namespace ops { struct QuantScheme; }
 
 // Load simple .bin export created by tools/download_tiny_gpt2.py into ModelCfg+ModelWeights.
 void load_tiny_bins(const std::string& dir, ModelCfg& cfg, ModelWeights& weights);
 
-// Load Mistral model from HuggingFace safetensors format
+// Weight-only quantization applied to the projections at load time
+enum class WeightQuant : uint8_t { None = 0, I8 = 1, Q4 = 2 };
+
+struct LoadOptions {
+    bool pack_weights{false};   // repack projections into the linear kernels' panel layout
+    bool fuse_qkv{false};       // build fused [Wq; Wk; Wv] so attention runs one projection
+    WeightQuant quantize{WeightQuant::None};
+    int64_t quant_group_size{32};   // Q4: elements per scale
+    bool quant_zero_points{false};  // Q4: asymmetric groups with zero points
+    bool use_prequantized{true};    // bind <model_dir>/quantized.safetensors when present
+    bool quant_activations{false};  // I8 projections: int8 activations + int8 x int8 kernels
+};
+
+// File written by export_quantized_safetensors next to the original checkpoint
+inline constexpr const char* kQuantizedSafetensors = "quantized.safetensors";
+
+// consolidated.safetensors if present, else model.safetensors
+std::string source_safetensors_path(const std::string& model_dir);
+
+// Load Mistral model from HuggingFace safetensors format. Both Mistral's
+// tensor names and HF transformers names (model.layers.N.self_attn.q_proj...)
+// are accepted; HF q/k rows are reordered for the engine's interleaved RoPE.
+// 4-bit GPTQ/AWQ checkpoints (a quantization_config in config.json and
+// qweight/qzeros/scales per projection) are repacked once into Q4 views with
+// zero points, without re-quantizing; act-order g_idx is rejected.
 void load_mistral_safetensors(const std::string& model_dir, ModelCfg& cfg, ModelWeights& weights);
+void load_mistral_safetensors(const std::string& model_dir, ModelCfg& cfg, ModelWeights& weights,
+                              const LoadOptions& opts);
+
+// Concatenate each layer's Wq, Wk and Wv rows into one Wqkv matrix so
+// attention computes Q, K and V with a single projection; any of bq, bk, bv
+// are concatenated the same way into bqkv (zeros for a missing part) so the
+// bias is added by the projection itself. The fused copies live in buffers
+// owned by `weights`; layers whose three matrices do not share dtype and
+// D_in, or whose biases are not F32 vectors of the projection width, are
+// left unfused.
+void fuse_qkv_weights(ModelWeights& weights);
+
+// Quantize every layer projection of bound weights (I8 per output channel or
+// Q4 per group). Quantized copies and their scales live in one buffer owned by
+// `weights`; lm_head keeps its checkpoint dtype. Projections the scheme does
+// not fit (e.g. D_in not a multiple of the group) are left as they are.
+void quantize_model_weights(ModelWeights& weights, const ops::QuantScheme& scheme);
+
+// Offline counterpart of quantize_model_weights: read src_path, quantize every
+// layer projection with `scheme` and write dst_path. Quantized values are
+// stored under the original name (I8, or U8 holding the packed Q4 nibbles),
+// scales and zero points as F32 "<name>.scales" / "<name>.zeros", and the
+// scheme in the header metadata; all other tensors are copied unchanged.
+// load_mistral_safetensors binds such a file zero-copy. Returns the number of
+// projections quantized.
+// With smooth set (I8 only), projections whose "<name>.act_absmax" [D_in] is
+// found in the calibration file get SmoothQuant scales folded into the
+// weights and stored as "<name>.smooth".
+struct SmoothQuantStats {
+    std::string path;      // safetensors with F32 "<name>.act_absmax" per projection
+    float alpha{0.5f};     // migration strength
+};
+size_t export_quantized_safetensors(const std::string& src_path, const std::string& dst_path,
+                                    const ops::QuantScheme& scheme, const SmoothQuantStats* smooth = nullptr);
+
+// Mark every I8 layer projection for dynamic int8 activation quantization
+// (QuantParams::dynamic_act), so ops::linear runs them as int8 x int8 GEMMs.
+// Run before pack_model_weights: those projections stay row-major.
+void enable_activation_quant(ModelWeights& weights);
+
+// Repack every projection (and lm_head) of bound weights into the panel layout
+// used by ops::linear. Packed copies live in one huge-page aligned buffer owned
+// by `weights`; matrices that cannot be packed are left as they are.
+void pack_model_weights(ModelWeights& weights);
 
 } // namespace ie
 
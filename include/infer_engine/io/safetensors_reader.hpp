@@ -30,6 +30,12 @@ public:
     // List all tensor names
     std::vector<std::string> get_tensor_names() const;
 
+    // Raw bytes of a tensor in the mapping (any dtype, bounds checked)
+    const void* get_tensor_data(const std::string& name) const;
+
+    // String pairs from the header's "__metadata__" object (empty if absent)
+    const std::map<std::string, std::string>& metadata() const;
+
 private:
     class Impl;
     std::unique_ptr<Impl> impl_;
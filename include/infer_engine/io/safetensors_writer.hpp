@@ -0,0 +1,44 @@
+#pragma once
+#include "infer_engine/core/tensor.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ie {
+
+/**
+ * Minimal safetensors writer. Tensors are registered by pointer and written
+ * in one pass by write(); the data must stay valid until then.
+ *
+ * The data section starts on a 64-byte boundary (the header is padded with
+ * spaces) and tensors are laid out widest element first with no gaps, so a
+ * reader that mmaps the file gets naturally aligned views without copying.
+ */
+class SafeTensorWriter {
+public:
+    // dtype is the safetensors name ("F32", "F16", "BF16", "I8", "U8", ...)
+    void add_tensor(const std::string& name, const std::string& dtype,
+                    const std::vector<int64_t>& shape, const void* data, size_t nbytes);
+
+    // Convenience for F32/F16/BF16/I8 views
+    void add_tensor(const std::string& name, const TensorView& tv);
+
+    // String key/value pair stored under "__metadata__"
+    void set_metadata(const std::string& key, const std::string& value);
+
+    // Write the file (via a temporary and rename); returns the bytes written
+    size_t write(const std::string& path) const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::string dtype;
+        std::vector<int64_t> shape;
+        const void* data;
+        size_t nbytes;
+    };
+    std::vector<Entry> entries_;
+    std::map<std::string, std::string> metadata_;
+};
+
+} // namespace ie
@@ -1,5 +1,6 @@
 #pragma once
 #include "infer_engine/core/tensor.hpp"
+#include "infer_engine/layers/ops/rope.hpp"
 #include "infer_engine/runtime/kv_cache.hpp"
 
 namespace ie {
@@ -10,12 +11,15 @@ struct AttentionWeights {
     TensorView Wk;    // [d_model, n_kv_heads * head_dim] - GQA: fewer heads
     TensorView Wv;    // [d_model, n_kv_heads * head_dim] - GQA: fewer heads
     TensorView Wo;    // [n_q_heads * head_dim, d_model]
+    TensorView Wqkv;  // Optional fused [(n_q_heads + 2 * n_kv_heads) * head_dim, d_model]
+                      // = [Wq; Wk; Wv]; when defined it replaces the three projections
     
     // Optional biases
     TensorView* bq = nullptr;
     TensorView* bk = nullptr;
     TensorView* bv = nullptr;
     TensorView* bo = nullptr;
+    TensorView* bqkv = nullptr;  // [bq; bk; bv] for Wqkv (zeros where a part has no bias)
 };
 
 struct AttentionConfig {
@@ -25,6 +29,8 @@ struct AttentionConfig {
     int64_t head_dim{0};
     float rope_theta{10000.0f};
     int64_t rope_dim{0};  // 0 = use full head_dim
+    const ops::RopeTable* rope_table{nullptr};  // Optional shared cos/sin; used when it matches
+                                                // rope_dim/rope_theta and covers the position
     
     // Computed properties
     int64_t gqa_group_size() const { return n_q_heads / n_kv_heads; }
@@ -34,11 +40,13 @@ struct AttentionConfig {
  * Single-layer attention forward pass for one token.
  * 
  * Steps:
- * 1. q,k,v projections from input
+ * 1. q,k,v projections from input (one fused projection if Wqkv is bound)
  * 2. Apply RoPE to q,k  
  * 3. Retrieve past K,V from cache + append current k,v
  * 4. Compute attention: scores = q @ K^T / sqrt(d), apply causal mask, softmax
  * 5. Context: ctx = softmax @ V
+ *    (4-5 run as one streaming pass with an online softmax: each cached K/V
+ *    row is read once and no [heads, seq_len] scores buffer is allocated)
  * 6. Output projection: out = ctx @ Wo
  * 
  * @param x Input token [1, d_model] or [d_model]
@@ -58,5 +66,45 @@ Tensor attn_forward(
     int64_t seq_pos
 );
 
+/**
+ * attn_forward writing the Wo projection into a caller-provided [1, d_model]
+ * F32 destination. With accumulate the result is added to `out`, so the
+ * residual stream can be passed directly and no output tensor is allocated.
+ * workspace, if given, is reused for the [n_q_heads, head_dim] context and,
+ * past a few hundred positions, the scratch of the split-sequence merge.
+ */
+void attn_forward_into(
+    const TensorView& x,
+    const AttentionWeights& weights,
+    const AttentionConfig& config,
+    KVCache& cache,
+    int64_t layer_idx,
+    int64_t seq_pos,
+    const TensorView& out,
+    bool accumulate,
+    Tensor* workspace = nullptr
+);
+
+/**
+ * Attention for a chunk of prompt tokens x [T, d_model] at positions
+ * [start_pos, start_pos + T): the projections run as [T, d_model] GEMMs, K/V
+ * of all T positions go into the cache with one bulk append, and each row
+ * attends causally over the cache (earlier chunks included). Writes (or with
+ * accumulate adds) the [T, d_model] Wo projection into out. workspace, if
+ * given, is reused for the [T, n_q_heads, head_dim] context and the
+ * per-task query / context scratch of the causal attention.
+ */
+void attn_prefill_into(
+    const TensorView& x,
+    const AttentionWeights& weights,
+    const AttentionConfig& config,
+    KVCache& cache,
+    int64_t layer_idx,
+    int64_t start_pos,
+    const TensorView& out,
+    bool accumulate,
+    Tensor* workspace = nullptr
+);
+
 } // namespace layers
 } // namespace ie
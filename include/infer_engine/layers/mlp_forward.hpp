@@ -24,7 +24,8 @@ struct MLPConfig {
 /**
  * Gated MLP forward pass (SwiGLU/GeGLU style).
  * 
- * Standard gated MLP computation:
+ * Standard gated MLP computation (gate, activation and up run as one fused
+ * kernel when W1/W3 have no biases and share dtype and layout):
  * gate = activation(linear(x, W1, b1))     // [1, d_ff] 
  * up   = linear(x, W3, b3)                 // [1, d_ff]
  * hidden = gate * up                       // Element-wise multiply
@@ -33,6 +34,8 @@ struct MLPConfig {
  * @param x Input tensor [1, d_model] or [d_model]
  * @param weights MLP weight matrices
  * @param config MLP configuration
+ * @param workspace Optional reused buffer for the [N, d_ff] hidden activations;
+ *        grown on demand and left allocated for the next call
  * @return MLP output, same shape as input
  */
 Tensor mlp_forward(
@@ -40,6 +43,26 @@ Tensor mlp_forward(
     const MLPWeights& weights,
     const MLPConfig& config
 );
+Tensor mlp_forward(
+    const TensorView& x,
+    const MLPWeights& weights,
+    const MLPConfig& config,
+    Tensor* workspace
+);
+
+/**
+ * mlp_forward writing the W2 projection into a caller-provided [N, d_model]
+ * F32 destination; with accumulate the result is added to `out` (residual add
+ * fused into the down projection).
+ */
+void mlp_forward_into(
+    const TensorView& x,
+    const MLPWeights& weights,
+    const MLPConfig& config,
+    Tensor* workspace,
+    const TensorView& out,
+    bool accumulate
+);
 
 } // namespace layers  
 } // namespace ie
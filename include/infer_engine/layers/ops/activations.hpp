@@ -4,6 +4,12 @@
 namespace ie {
 namespace ops {
 
+/** Activations that fused kernels can apply in their epilogue. */
+enum class Activation : uint8_t {
+    SiLU = 0,
+    GELU = 1,   // tanh approximation
+};
+
 /**
  * SiLU (Swish) activation: x * sigmoid(x)
  * 
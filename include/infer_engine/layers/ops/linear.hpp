@@ -1,5 +1,8 @@
 #pragma once
+#include "infer_engine/core/device.hpp"
 #include "infer_engine/core/tensor.hpp"
+#include "infer_engine/layers/ops/activations.hpp"
+#include <vector>
 
 namespace ie {
 namespace ops {
@@ -14,5 +17,162 @@ namespace ops {
  */
 Tensor linear(const TensorView& x, const TensorView& W, const TensorView* bias = nullptr);
 
+/** Work fused into linear_into's store of each output element. */
+struct LinearEpilogue {
+    const TensorView* bias = nullptr;   // [D_out], F32
+    float scale = 1.0f;                 // applied to (x @ W.T + bias)
+    bool accumulate = false;            // add into out instead of overwriting (residual add)
+};
+
+/**
+ * Linear into a caller-provided destination:
+ *   out = (accumulate ? out : 0) + scale * (x @ W.T + bias)
+ *
+ * @param x Input tensor [N, D_in]
+ * @param W Weight tensor [D_out, D_in]
+ * @param out Destination, F32 with N * D_out contiguous elements
+ * @param ep Optional bias / scale / residual-accumulate epilogue
+ */
+void linear_into(const TensorView& x, const TensorView& W, const TensorView& out,
+                 const LinearEpilogue& ep = {});
+
+/** One surviving output row of linear_topk. */
+struct TopKEntry {
+    int32_t id;
+    float value;
+};
+
+/**
+ * Top-k rows of x @ W.T for a single input row, without materializing the
+ * [D_out] result: W is split by row range across the thread pool, each task
+ * keeps a local top-k of its slice and only the candidates are merged.
+ * Intended for the vocab projection at decode time (k = 1 is greedy argmax).
+ *
+ * @param x Input tensor [1, D_in] or [D_in]
+ * @param W Weight tensor [D_out, D_in]
+ * @param k Number of candidates, clamped to [1, D_out]
+ * @return Candidates sorted by value, highest first (ties: lower id first)
+ */
+std::vector<TopKEntry> linear_topk(const TensorView& x, const TensorView& W, int64_t k);
+
+/**
+ * Fused gated projection (SwiGLU/GeGLU front half):
+ *   hidden = act(x @ W_gate.T) * (x @ W_up.T)
+ *
+ * Gate and up are computed together, one block of d_ff columns at a time, and
+ * the activation is applied before hidden is stored. No d_ff-sized
+ * temporaries are allocated: N == 1 fuses both dot products in registers,
+ * N > 1 keeps each [N, block] of gate values in a per-thread buffer that is
+ * reused across calls.
+ *
+ * @param x Input tensor [N, D_in]
+ * @param W_gate Gate weights [D_ff, D_in]
+ * @param W_up Up weights [D_ff, D_in], same dtype and layout as W_gate
+ * @param act Activation applied to the gate
+ * @param out (into variant) Destination, F32 with N * D_ff elements
+ * @return hidden [N, D_ff]
+ */
+Tensor gated_linear(const TensorView& x, const TensorView& W_gate, const TensorView& W_up, Activation act);
+void gated_linear_into(const TensorView& x, const TensorView& W_gate, const TensorView& W_up,
+                       Activation act, const TensorView& out);
+
+/**
+ * Instruction-set level of the linear kernels. The first linear call picks
+ * IE_ISA from the environment when the host supports it, else best_isa().
+ * set_linear_isa overrides that (e.g. from a config flag); call it before
+ * weights are packed, since the panel depth depends on the level (packed
+ * views record their depth, and linear throws on one packed for another).
+ * The attention tile and KV row conversion kernels follow the same level.
+ * Throws if the host cannot run isa.
+ */
+Isa linear_isa();
+void set_linear_isa(Isa isa);
+
+/**
+ * Weight pre-packing into the micro-kernel's panel layout (Layout::PackedPanels).
+ * Packed weights are read by linear as one sequential stream per panel.
+ *
+ * can_pack_weight: W is rank-2 F32/F16/BF16/I8 and D_in fits the panel depth;
+ *                  I8 weights marked dynamic_act stay row-major for the int8 kernels
+ * packed_weight_bytes: size of the buffer pack_weight writes (rows padded)
+ * pack_weight: repack row-major W into dst and return a view over it
+ */
+bool can_pack_weight(const TensorView& W);
+size_t packed_weight_bytes(const TensorView& W);
+TensorView pack_weight(const TensorView& W, void* dst);
+
+/** Target of weight-only quantization. */
+struct QuantScheme {
+    DType dt = DType::I8;       // I8: symmetric, one scale per output row
+                                // Q4: 4-bit, one scale per group of group_size
+    int64_t group_size = 32;    // Q4 only; multiple of 32 that divides D_in
+    bool zero_points = false;   // Q4 only; asymmetric groups with a zero point each
+    const float* smooth = nullptr;  // I8 only; [D_in] SmoothQuant scales folded into W
+};
+
+/**
+ * Weight-only quantization, done once at load time (or offline). linear
+ * dequantizes in registers: I8 rows are widened and scaled per row as each
+ * output is stored, Q4 nibbles are unpacked and scaled per group. Setting
+ * quant.dynamic_act on an I8 view switches linear to W8A8: each input row is
+ * quantized to int8 with its own scale and multiplied in int8 x int8 -> int32
+ * (vpdpbusd where the host has VNNI), for compute-bound prefill.
+ *
+ * can_quantize_weight: W is a row-major F32/F16/BF16 matrix the scheme fits
+ * quantized_weight_bytes: size of the buffer quantize_weight writes (values, scales, zeros)
+ * quantize_weight: quantize W into dst and return a view with quant params set
+ */
+bool can_quantize_weight(const TensorView& W, const QuantScheme& scheme);
+size_t quantized_weight_bytes(const TensorView& W, const QuantScheme& scheme);
+TensorView quantize_weight(const TensorView& W, const QuantScheme& scheme, void* dst);
+
+/** Packed 4-bit checkpoint layouts repack_q4 understands (int32 words of 8 nibbles). */
+enum class PackedQ4Format : uint8_t {
+    GPTQ = 0,     // qweight [D_in / 8, D_out], packed along D_in; zeros stored minus one
+    GPTQv2 = 1,   // as GPTQ, zeros stored as is
+    AWQ = 2,      // qweight [D_in, D_out / 8], packed along D_out in AWQ's nibble order
+};
+
+/** One pre-quantized projection as found in a GPTQ/AWQ checkpoint. */
+struct PackedQ4Source {
+    PackedQ4Format format = PackedQ4Format::GPTQ;
+    const int32_t* qweight = nullptr;
+    const int32_t* qzeros = nullptr;   // [D_in / G, D_out / 8], packed like an AWQ qweight row (GPTQ: in order)
+    const void* scales = nullptr;      // [D_in / G, D_out]
+    DType scales_dt = DType::F16;      // F16, BF16 or F32
+    int64_t D_out = 0;
+    int64_t D_in = 0;
+    int64_t group_size = 0;
+    const int64_t* row_map = nullptr;  // optional: output row j is source column row_map[j]
+};
+
+/**
+ * Repack a GPTQ/AWQ projection into the engine's Q4 layout (DType::Q4 with
+ * zero points), so checkpoints quantized elsewhere run on the Q4 kernels
+ * without re-quantizing: nibbles move, values do not. Groups whose zero is
+ * the midpoint 8 everywhere drop the zeros array.
+ *
+ * can_repack_q4: shapes fit (D_out % 8, group a multiple of 32 dividing D_in)
+ * repacked_q4_bytes: size of the buffer repack_q4 writes
+ * repack_q4: write values | scales | zeros into dst and return the Q4 view
+ */
+bool can_repack_q4(const PackedQ4Source& src);
+size_t repacked_q4_bytes(const PackedQ4Source& src);
+TensorView repack_q4(const PackedQ4Source& src, void* dst);
+
+/**
+ * SmoothQuant migration scales for one projection, from calibration:
+ *   smooth[k] = max|x_k|^alpha / max_j |W[j, k]|^(1 - alpha)
+ * Dividing x by smooth and multiplying W's columns by it leaves x @ W.T
+ * unchanged but moves outlier channels from x into W, so both quantize to
+ * int8 with less error. Pass the result as QuantScheme::smooth.
+ *
+ * @param act_absmax Per-channel max |x| seen during calibration [D_in]
+ * @param W Row-major weight [D_out, D_in] (F32/F16/BF16)
+ * @param alpha Migration strength, typically 0.5
+ * @param smooth Output [D_in]
+ */
+void smooth_quant_scales(const float* act_absmax, const TensorView& W, float alpha, float* smooth);
+
 } // namespace ops
 } // namespace ie
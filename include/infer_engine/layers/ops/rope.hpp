@@ -1,6 +1,7 @@
 #pragma once
 #include "infer_engine/core/tensor.hpp"
 #include <tuple>
+#include <vector>
 
 namespace ie {
 namespace ops {
@@ -23,5 +24,52 @@ std::tuple<Tensor, Tensor> rope_apply(
     float theta_base = 10000.0f
 );
 
+/**
+ * cos/sin of every (position, rotary pair): pair i at position p rotates by
+ * p * theta^(-2i / rotary_dim). Rows are [pairs][2] = (cos, sin), stored
+ * position after position, so a range of positions is one contiguous block.
+ * ModelWeights::rope_table builds one per model and shares it with every
+ * context, layer and head. reserve grows the table geometrically, up to
+ * max_pos when that is set; call it before reading rows from several threads.
+ */
+class RopeTable {
+public:
+    RopeTable() = default;
+    /** Positions [0, n_pos) up front; max_pos (0 = none) caps later growth. */
+    RopeTable(int64_t rotary_dim, float theta, int64_t n_pos = 0, int64_t max_pos = 0);
+
+    /** Make positions [0, n_pos) available; throws past max_pos. */
+    void reserve(int64_t n_pos);
+
+    int64_t rotary_dim() const { return rotary_dim_; }
+    float theta() const { return theta_; }
+    int64_t size() const { return n_pos_; }
+
+    /** cos/sin rows of positions pos, pos + 1, ... (pos < size()) */
+    const float* row(int64_t pos) const { return cs_.data() + pos * rotary_dim_; }
+
+    /** One row computed without a table, into out[rotary_dim]. */
+    static void compute_row(int64_t rotary_dim, float theta, int64_t pos, float* out);
+
+private:
+    int64_t rotary_dim_ = 0;
+    float theta_ = 10000.0f;
+    int64_t n_pos_ = 0;
+    int64_t max_pos_ = 0;
+    std::vector<float> cs_;
+};
+
+/**
+ * Rotate Q or K heads in place with interleaved pairs (x[2i], x[2i+1]).
+ *
+ * @param x Rows [n_pos, n_heads, head_dim], F32; row p is at position pos0 + p
+ * @param cs cos/sin rows for those positions, e.g. table.row(pos0)
+ * @param rotary_dim Leading dims of each head that rotate; the rest are kept
+ * @param row_stride Floats from one position's row to the next (0: n_heads *
+ *                   head_dim), e.g. to rotate Q or K inside fused QKV rows
+ */
+void rope_rotate_inplace(float* x, int64_t n_pos, int64_t n_heads, int64_t head_dim,
+                         int64_t rotary_dim, const float* cs, int64_t row_stride = 0);
+
 } // namespace ops
 } // namespace ie
@@ -6,15 +6,19 @@
 
 namespace ie {
 
+namespace ops { class RopeTable; }
+
 struct AttentionWeightsCXX {
     TensorView Wq;
     TensorView Wk;
     TensorView Wv;
     TensorView Wo;
+    TensorView Wqkv;  // optional fused [Wq; Wk; Wv] rows, see fuse_qkv_weights
     TensorView* bq = nullptr;
     TensorView* bk = nullptr;
     TensorView* bv = nullptr;
     TensorView* bo = nullptr;
+    TensorView* bqkv = nullptr;  // fused [bq; bk; bv] for Wqkv, see fuse_qkv_weights
 };
 
 struct MLPWeightsCXX {
@@ -58,6 +62,13 @@ public:
 
     // Keep backing storage alive (e.g., safetensors mmaps)
     void set_owner(const std::shared_ptr<void>& owner) { owner_ = owner; }
+    // Keep extra storage alive that views were rebound to (e.g., packed copies)
+    void add_storage(const std::shared_ptr<void>& buf) { storage_.push_back(buf); }
+
+    // RoPE cos/sin covering positions [0, n_pos), built once per model and
+    // shared by every context (and copy of these weights) asking for the same
+    // rotary_dim/theta; a longer request replaces it with a larger table
+    std::shared_ptr<const ops::RopeTable> rope_table(int64_t rotary_dim, float theta, int64_t n_pos) const;
 
 private:
     TensorView token_embeddings_{};
@@ -65,6 +76,10 @@ private:
     TensorView final_norm_{};
     std::vector<LayerWeightsCXX> layers_{};
     std::shared_ptr<void> owner_{}; // holds reader/mmap lifetime
+    std::vector<std::shared_ptr<void>> storage_{}; // buffers owned by the model itself
+    struct RopeTables;
+    std::shared_ptr<RopeTables> rope_tables_ = make_rope_tables(); // shared across copies
+    static std::shared_ptr<RopeTables> make_rope_tables();
 };
 
 } // namespace ie
@@ -1,38 +1,213 @@
 #pragma once
+#include "infer_engine/core/allocator.hpp"
 #include "infer_engine/core/tensor.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 #include <cstdint>
 
 namespace ie {
 
+// Row order of one layer's cache. SeqMajor keeps the KV heads of a position
+// together ([seq][kv_heads][d], one write per position); HeadMajor keeps each
+// KV head's history together ([kv_heads][seq][d]), so attention streams one
+// contiguous run per head instead of striding by kv_heads * d. Paged caches
+// apply the same order within each block.
+enum class KVLayout : uint8_t {
+    SeqMajor = 0,
+    HeadMajor = 1,
+};
+
 struct KVCacheConfig {
     int64_t num_layers{0};
     int64_t max_seq_len{0};
     int64_t num_q_heads{0};       // Query heads
     int64_t num_kv_heads{0};      // Key/Value heads (for GQA)
     int64_t head_dim{0};
-    DType dtype{DType::F16};      // Store KV in fp16 to reduce memory
+    DType dtype{DType::F16};      // Store KV in fp16 to reduce memory; I8 / F8 (E4M3) halve
+                                  // it again with one scale per (layer, position, kv_head)
+    bool huge_pages{false};       // Back the stores with transparent huge pages
+    KVLayout layout{KVLayout::SeqMajor};
+};
+
+// K/V stores and I8 / F8 scales carved from one lazily committed region:
+// the whole size is reserved, pages are backed as positions are written
+struct KVStorage {
+    LazyRegion mem;
+    TensorView k, v;
+    TensorView k_scale, v_scale;  // undefined unless the dtype is scaled
+};
+
+// KV dtypes that store codes plus a per-row scale
+inline bool kv_dtype_scaled(DType dt) { return dt == DType::I8 || dt == DType::F8; }
+
+// How KVCache::save writes a snapshot
+struct KVSnapshotOptions {
+    bool quantize{false};           // Store F32 / F16 rows as quant_dtype codes plus a
+    DType quant_dtype{DType::I8};   // per-row scale (I8 or F8, ~half the size of F16)
+    std::vector<int32_t> tokens{};  // Token ids of the saved positions, kept alongside
+};
+
+/**
+ * Shared storage for paged KV caches: num_blocks fixed-size blocks of
+ * block_size token positions, each holding those positions for every layer,
+ * [num_blocks][layers][block_size][kv_heads][head_dim] (scales
+ * [num_blocks][layers][block_size][kv_heads] for I8 / F8). Sequences take
+ * blocks from a free list as they grow and give them back when cleared, so
+ * many sequences of different lengths share one budget and none reserves
+ * max_seq_len up front. allocate/release are thread-safe.
+ */
+class KVBlockPool {
+public:
+    // cfg.max_seq_len is ignored; block_size is rounded up to a power of two
+    KVBlockPool(const KVCacheConfig& cfg, int64_t block_size, int64_t num_blocks);
+
+    // A free block id with one reference, or -1 when the pool is exhausted
+    int32_t allocate();
+    // Blocks are reference counted so several sequences (and a prefix cache)
+    // can share one; the block is free again when the last reference goes
+    void retain(int32_t block);
+    void release(int32_t block);
+    int32_t ref_count(int32_t block) const;
+
+    int64_t block_size() const { return block_size_; }
+    int64_t num_blocks() const { return num_blocks_; }
+    int64_t num_free() const;
+    const KVCacheConfig& config() const { return cfg_; }
+
+    // Bytes of address space held vs. backed by memory (blocks are handed out
+    // lowest id first, so the committed part grows with peak usage)
+    size_t reserved_bytes() const { return store_.mem.reserved_bytes(); }
+    size_t committed_bytes() const { return store_.mem.committed_bytes(); }
+
+private:
+    friend class KVCache;
+    KVCacheConfig cfg_{};
+    int64_t block_size_ = 0;
+    int64_t block_shift_ = 0;  // log2(block_size)
+    int64_t num_blocks_ = 0;
+    KVStorage store_;
+    mutable std::mutex mu_;
+    std::vector<int32_t> free_;
+    std::vector<int32_t> refs_;
 };
 
 class KVCache {
 public:
     explicit KVCache(const KVCacheConfig& cfg);
 
+    // Paged cache drawing blocks from a shared pool on demand; max_seq_len 0
+    // means the pool's whole capacity. Block references are dropped on clear()
+    // and destruction.
+    explicit KVCache(std::shared_ptr<KVBlockPool> pool, int64_t max_seq_len = 0);
+    ~KVCache();
+    KVCache(const KVCache&) = delete;
+    KVCache& operator=(const KVCache&) = delete;
+
     // Append K and V for a given layer and sequence position.
-    // K,V are expected as TensorView with shapes: [num_kv_heads, head_dim]
+    // K,V are expected as TensorView with shapes: [num_kv_heads, head_dim],
+    // either already in the cache dtype (copied) or F32 (converted; for I8 /
+    // F8 each head row is quantized with scale max|row| / 127 or / 448)
     void append(int64_t layer_idx, int64_t seq_pos, const TensorView& K, const TensorView& V);
 
+    // Bulk append for prefill: K,V [n_pos, num_kv_heads, head_dim] fill positions
+    // [start_pos, start_pos + n_pos) of one layer (one copy per position when
+    // no conversion is needed). Each position's heads must be contiguous, but
+    // positions may be strided (stride[0]), e.g. K and V inside fused QKV rows
+    void append_range(int64_t layer_idx, int64_t start_pos, const TensorView& K, const TensorView& V);
+
     // Accessors to underlying storage views for inspection/testing
-    // Layout is [layers][seq][kv_heads][d_head] 
+    // Layout is [layers][seq][kv_heads][d_head], or [layers][kv_heads][seq][d_head]
+    // for KVLayout::HeadMajor (paged: the pool's blocks; use row_index to
+    // locate a position)
     TensorView k_view() const;
     TensorView v_view() const;
 
+    // Per-row dequantization scales [layers][seq][kv_heads] (ordered like the
+    // rows, so also indexed by row_index), F32; undefined
+    // views unless the cache dtype is I8 or F8. Element d of a row is
+    // scale * code[d] (I8) or scale * e4m3(code[d]) (F8).
+    TensorView k_scales() const;
+    TensorView v_scales() const;
+
     const KVCacheConfig& config() const { return cfg_; }
 
+    // Bytes of address space reserved for the stores vs. backed by memory so
+    // far; a dense cache commits pages only as positions are appended, so a
+    // generous max_seq_len costs address space, not RSS (paged: the pool's)
+    size_t reserved_bytes() const;
+    size_t committed_bytes() const;
+
+    // Index of the [head_dim] row of (layer, pos, kv_head) in k_view / v_view,
+    // and of its scale in k_scales / v_scales; paged caches go through the
+    // block table. pos must have been appended (or reserved).
+    size_t row_index(int64_t layer_idx, int64_t pos, int64_t kv_head) const {
+        const int64_t KVH = cfg_.num_kv_heads;
+        const bool head_major = cfg_.layout == KVLayout::HeadMajor;
+        if (!pool_) {
+            const int64_t S = cfg_.max_seq_len;
+            return static_cast<size_t>(head_major ? (layer_idx * KVH + kv_head) * S + pos
+                                                  : (layer_idx * S + pos) * KVH + kv_head);
+        }
+        const int64_t B = pool_->block_size_;
+        const int64_t first = (block_table_[static_cast<size_t>(pos >> pool_->block_shift_)] * cfg_.num_layers + layer_idx)
+                              * B * KVH;  // first row of this layer in the block
+        const int64_t p = pos & (B - 1);
+        return static_cast<size_t>(first + (head_major ? kv_head * B + p : p * KVH + kv_head));
+    }
+
+    // Paged caches: make positions [0, n_pos) writable, taking blocks from the
+    // pool (throws std::runtime_error when it is exhausted); no-op when dense
+    void reserve(int64_t n_pos);
+    // Forget every position: paged caches drop this sequence's reference to
+    // every block, dense caches give their committed pages back
+    void clear();
+    // Forget positions [n_pos, ...), e.g. to roll back a forward pass that
+    // failed part way; paged caches give back the blocks past n_pos
+    void truncate(int64_t n_pos);
+    // Paged caches: start an empty sequence on already-filled shared blocks
+    // (e.g. a cached prompt prefix), taking a reference to each; positions
+    // [0, blocks.size() * block_size) are then readable. Writing into a block
+    // another holder still references (refcount > 1: attached, or published
+    // to a prefix cache) first copies it to a block of this sequence's own.
+    void attach_blocks(const std::vector<int32_t>& blocks);
+    // Same, but takes over references the caller already holds (the blocks
+    // returned by PrefixCache::match) instead of adding new ones; on error
+    // they stay with the caller
+    void adopt_blocks(const std::vector<int32_t>& blocks);
+
+    bool paged() const { return pool_ != nullptr; }
+    const std::shared_ptr<KVBlockPool>& pool() const { return pool_; }
+    const std::vector<int32_t>& block_table() const { return block_table_; }
+    // Positions [0, filled()) have been written in every layer (appended
+    // contiguously from 0, attached, or loaded)
+    int64_t filled() const;
+
+    // Snapshot positions [0, n_pos) of every layer to a safetensors file:
+    // layers.{l}.k / .v [n_pos, kv_heads, head_dim] in position order whatever
+    // the layout or paging, layers.{l}.k_scale / .v_scale [n_pos, kv_heads]
+    // for I8 / F8 rows, and the shape in the metadata. Returns bytes written.
+    size_t save(const std::string& path, int64_t n_pos, const KVSnapshotOptions& opts = {}) const;
+    // Restore a snapshot into this cache, which must match its layer / head
+    // shape (any layout, dtype, dense or paged). Rows are copied straight from
+    // the file mapping when the dtypes agree and converted otherwise; for a
+    // paged cache the existing blocks are dropped first. Returns the number
+    // of positions restored; tokens receives the saved token ids.
+    int64_t load(const std::string& path, std::vector<int32_t>* tokens = nullptr);
+
 private:
+    // Store already-validated rows [start_pos, start_pos + n_pos) of one layer
+    void write_rows(int64_t layer_idx, int64_t start_pos, int64_t n_pos, const TensorView& K, const TensorView& V);
+    // Paged: copy-on-write for the shared blocks among those holding
+    // positions [start_pos, start_pos + n_pos), all layers at once
+    void unshare_blocks(int64_t start_pos, int64_t n_pos);
+
     KVCacheConfig cfg_{};
-    Tensor k_store_{}; // owns memory
-    Tensor v_store_{}; // owns memory
+    KVStorage store_;                      // dense only
+    std::shared_ptr<KVBlockPool> pool_{};  // paged: storage lives in the pool
+    std::vector<int32_t> block_table_{};   // paged: block of positions [i * B, (i + 1) * B)
+    std::vector<int64_t> filled_{};        // per layer: end of the contiguously written prefix
 };
 
 } // namespace ie
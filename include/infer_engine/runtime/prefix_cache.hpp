@@ -0,0 +1,73 @@
+#pragma once
+#include "infer_engine/runtime/kv_cache.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ie {
+
+/**
+ * Index from token-id prefixes to filled KV blocks of a KVBlockPool, so
+ * requests that share a prompt prefix (system prompts) reuse its K/V instead
+ * of recomputing it. The tree is a radix tree whose edges are whole blocks:
+ * a node holds the block_size tokens of one block and the block that stores
+ * their K/V, and its children continue the prefix by one more block. Only
+ * full blocks are shared; a sequence attached to a cached prefix appends
+ * into blocks of its own.
+ *
+ * The cache holds one pool reference per node. When more than max_blocks are
+ * cached, or on evict(), least recently used leaves that no sequence still
+ * references are dropped. All methods are thread-safe.
+ */
+class PrefixCache {
+public:
+    PrefixCache(std::shared_ptr<KVBlockPool> pool, int64_t max_blocks);
+    ~PrefixCache();
+    PrefixCache(const PrefixCache&) = delete;
+    PrefixCache& operator=(const PrefixCache&) = delete;
+
+    /**
+     * Longest cached prefix of tokens[0, max_tokens) in whole blocks; blocks
+     * receives their ids in order, each with a reference taken for the
+     * caller before the lock is dropped, so a concurrent evict() cannot free
+     * them (hand them to KVCache::adopt_blocks, or release them).
+     * @return Number of tokens covered, a multiple of the block size
+     */
+    int64_t match(const std::vector<int32_t>& tokens, int64_t max_tokens, std::vector<int32_t>& blocks);
+
+    /**
+     * Publish the full blocks of a paged sequence whose positions
+     * [0, tokens.size()) hold the K/V of tokens; blocks beyond
+     * cache.filled() are left out. Prefix blocks already cached are kept
+     * (and touched); new ones are referenced by the cache.
+     */
+    void insert(const std::vector<int32_t>& tokens, const KVCache& cache);
+
+    /** Drop up to n_blocks least recently used unreferenced leaves; returns how many went. */
+    int64_t evict(int64_t n_blocks);
+
+    int64_t cached_blocks() const;
+    int64_t block_size() const { return pool_->block_size(); }
+    const std::shared_ptr<KVBlockPool>& pool() const { return pool_; }
+
+private:
+    struct Node {
+        int32_t block = -1;
+        uint64_t last_use = 0;
+        Node* parent = nullptr;
+        std::map<std::vector<int32_t>, std::unique_ptr<Node>> children;  // keyed by the child's block tokens
+    };
+
+    int64_t evict_locked(int64_t n_blocks);
+
+    std::shared_ptr<KVBlockPool> pool_;
+    int64_t max_blocks_ = 0;
+    int64_t n_nodes_ = 0;
+    uint64_t tick_ = 0;
+    Node root_;
+    mutable std::mutex mu_;
+};
+
+} // namespace ie
@@ -2,8 +2,12 @@
 #include "infer_engine/model/config.hpp"
 #include "infer_engine/model/weights.hpp"
 #include "infer_engine/runtime/kv_cache.hpp"
+#include "infer_engine/runtime/prefix_cache.hpp"
 #include "infer_engine/core/tensor.hpp"
+#include "infer_engine/layers/ops/linear.hpp"
+#include "infer_engine/layers/ops/rope.hpp"
 #include <memory>
+#include <vector>
 
 namespace ie {
 
@@ -11,18 +15,60 @@ class RuntimeCtx {
 public:
     RuntimeCtx(const ModelCfg& cfg, const ModelWeights& weights);
     RuntimeCtx(const ModelCfg& cfg, const ModelWeights& weights, int64_t max_seq_len);
+    // kv_dtype: F16 (default), F32, or I8 / F8 for a half-size quantized cache;
+    // kv_layout: HeadMajor streams each KV head's history contiguously
+    RuntimeCtx(const ModelCfg& cfg, const ModelWeights& weights, int64_t max_seq_len, DType kv_dtype,
+               KVLayout kv_layout = KVLayout::SeqMajor);
+    // Paged KV: the sequence takes blocks from a pool shared with other
+    // contexts as it grows (max_seq_len 0 = up to the pool's capacity)
+    RuntimeCtx(const ModelCfg& cfg, const ModelWeights& weights, std::shared_ptr<KVBlockPool> kv_pool,
+               int64_t max_seq_len = 0);
 
     // Forward one decode step: input token_id at position pos -> logits [vocab_size]
     Tensor forward_decode(int32_t token_id, int64_t pos);
 
+    // Same step, but returns only the k highest-scoring vocab ids (k = 1 for
+    // greedy); the lm_head is reduced per thread and full logits are never
+    // written
+    std::vector<ops::TopKEntry> forward_decode_topk(int32_t token_id, int64_t pos, int64_t k);
+
+    // Prefill: tokens at positions [start_pos, start_pos + tokens.size()) run
+    // through each layer together ([T, d_model] GEMMs, causal attention over
+    // the chunk, one bulk KV append per layer) in chunks of a few hundred.
+    // Returns logits [vocab_size] (or the top k) for the token after the last.
+    Tensor forward_prefill(const std::vector<int32_t>& tokens, int64_t start_pos);
+    std::vector<ops::TopKEntry> forward_prefill_topk(const std::vector<int32_t>& tokens, int64_t start_pos, int64_t k);
+
+    // Prefix caching (paged contexts): attach_prefix starts this empty
+    // sequence on the longest cached prefix of tokens, always leaving at least
+    // one token to compute, evicts cached blocks if the rest would not fit the
+    // pool, and returns the positions reused; forward_prefill the remaining
+    // tokens from there. publish_prefix offers the full blocks holding
+    // tokens (positions 0..) to the cache for later requests; positions not
+    // yet run through the model are left out.
+    int64_t attach_prefix(PrefixCache& cache, const std::vector<int32_t>& tokens);
+    void publish_prefix(PrefixCache& cache, const std::vector<int32_t>& tokens) const;
+
     // Accessors
     const ModelCfg& cfg() const { return cfg_; }
     KVCache& kv() { return *kv_; }
 
 private:
+    // Embedding + all layers for n_tokens tokens at pos.. + final norm of the
+    // last one -> [d_model]
+    Tensor forward_hidden(const int32_t* tokens, int64_t n_tokens, int64_t pos);
+    void init_rope();
+    Tensor prefill_hidden(const std::vector<int32_t>& tokens, int64_t start_pos);
+    // lm_head on a final hidden state: full logits, or top k candidates
+    Tensor logits(const Tensor& x_final);
+    std::vector<ops::TopKEntry> topk(const Tensor& x_final, int64_t k);
+
     ModelCfg cfg_;
     ModelWeights weights_;
     std::unique_ptr<KVCache> kv_;
+    Tensor mlp_hidden_;   // reused [N, d_ff] MLP workspace
+    Tensor attn_ctx_;     // reused [n_heads, head_dim] attention context
+    std::shared_ptr<const ops::RopeTable> rope_; // the model's cos/sin table, up to kv max_seq_len
 };
 
 } // namespace ie
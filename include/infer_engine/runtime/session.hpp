@@ -0,0 +1,43 @@
+#pragma once
+#include "infer_engine/runtime/runtime_ctx.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ie {
+
+/**
+ * One conversation on a RuntimeCtx: the tokens fed so far and their KV.
+ * An idle session can be suspended to a snapshot file, releasing its KV
+ * memory, and resumed later (or in another process with the same model)
+ * without recomputing the history.
+ */
+class Session {
+public:
+    // Takes a context whose KV cache is empty
+    explicit Session(std::unique_ptr<RuntimeCtx> ctx);
+
+    // Run tokens after the history (prefill, or a single decode step) and
+    // return the k most likely next tokens. If it throws (e.g. the block pool
+    // is exhausted part way), KV rows written for tokens are dropped and the
+    // session is as before the call.
+    std::vector<ops::TopKEntry> feed(const std::vector<int32_t>& tokens, int64_t k);
+
+    // Write the history and its KV to path (KVCache::save; opts.tokens is
+    // replaced by the history), then drop the KV. Returns bytes written.
+    size_t suspend(const std::string& path, const KVSnapshotOptions& opts = {});
+    // Replace the history with a suspended session's; feed continues after it
+    void resume(const std::string& path);
+
+    bool suspended() const { return suspended_; }
+    int64_t pos() const { return static_cast<int64_t>(tokens_.size()); }
+    const std::vector<int32_t>& tokens() const { return tokens_; }
+    RuntimeCtx& ctx() { return *ctx_; }
+
+private:
+    std::unique_ptr<RuntimeCtx> ctx_;
+    std::vector<int32_t> tokens_;
+    bool suspended_ = false;
+};
+
+} // namespace ie
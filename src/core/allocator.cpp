@@ -0,0 +1,110 @@
+#include "infer_engine/core/allocator.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace ie {
+
+void AlignedDeleter::operator()(void* p) const {
+    std::free(p);
+}
+
+AlignedPtr alloc_aligned(size_t bytes, size_t alignment, bool huge_pages) {
+    if (huge_pages && alignment < kHugePageBytes) alignment = kHugePageBytes;
+    if (alignment < sizeof(void*)) alignment = sizeof(void*);
+    // aligned_alloc requires the size to be a multiple of the alignment
+    size_t padded = (bytes + alignment - 1) / alignment * alignment;
+    if (padded == 0) padded = alignment;
+    void* p = std::aligned_alloc(alignment, padded);
+    if (!p) throw std::bad_alloc();
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (huge_pages) madvise(p, padded, MADV_HUGEPAGE); // best effort
+#endif
+    return AlignedPtr(p);
+}
+
+LazyRegion::LazyRegion(size_t bytes, bool huge_pages) {
+    bytes_ = bytes;
+    if (bytes == 0) return;
+#if defined(__linux__)
+    const size_t align = huge_pages ? kHugePageBytes : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    bytes_ = (bytes + align - 1) / align * align;
+    // Over-reserve by one huge page so the start can be 2 MB aligned
+    const size_t span = huge_pages ? bytes_ + kHugePageBytes : bytes_;
+    void* p = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) throw std::bad_alloc();
+    auto* base = static_cast<uint8_t*>(p);
+    if (huge_pages) {
+        auto* aligned = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(base) + kHugePageBytes - 1) & ~(kHugePageBytes - 1));
+        if (aligned > base) munmap(base, static_cast<size_t>(aligned - base));
+        const size_t tail = span - static_cast<size_t>(aligned - base) - bytes_;
+        if (tail > 0) munmap(aligned + bytes_, tail);
+        base = aligned;
+#if defined(MADV_HUGEPAGE)
+        madvise(base, bytes_, MADV_HUGEPAGE); // best effort
+#endif
+    }
+    data_ = base;
+    mapped_ = true;
+#else
+    (void)huge_pages;
+    data_ = std::calloc(1, bytes);
+    if (!data_) throw std::bad_alloc();
+#endif
+}
+
+LazyRegion::~LazyRegion() {
+    if (!data_) return;
+#if defined(__linux__)
+    if (mapped_) {
+        munmap(data_, bytes_);
+        return;
+    }
+#endif
+    std::free(data_);
+}
+
+LazyRegion::LazyRegion(LazyRegion&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), bytes_(std::exchange(other.bytes_, 0)),
+      mapped_(std::exchange(other.mapped_, false)) {}
+
+LazyRegion& LazyRegion::operator=(LazyRegion&& other) noexcept {
+    if (this != &other) {
+        LazyRegion old(std::move(*this));
+        data_ = std::exchange(other.data_, nullptr);
+        bytes_ = std::exchange(other.bytes_, 0);
+        mapped_ = std::exchange(other.mapped_, false);
+    }
+    return *this;
+}
+
+size_t LazyRegion::committed_bytes() const {
+    if (!mapped_) return bytes_;
+#if defined(__linux__)
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    std::vector<unsigned char> resident((bytes_ + page - 1) / page);
+    if (mincore(data_, bytes_, resident.data()) != 0) return bytes_;
+    size_t pages = 0;
+    for (unsigned char r : resident) pages += (r & 1);
+    return pages * page;
+#else
+    return bytes_;
+#endif
+}
+
+void LazyRegion::decommit() {
+    if (!data_) return;
+#if defined(__linux__)
+    if (mapped_ && madvise(data_, bytes_, MADV_DONTNEED) == 0) return;
+#endif
+    std::memset(data_, 0, bytes_);
+}
+
+} // namespace ie
@@ -0,0 +1,138 @@
+#include "infer_engine/core/device.hpp"
+#include <stdexcept>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <cpuid.h>
+#define IE_X86 1
+#endif
+
+namespace ie {
+
+namespace {
+
+#if defined(IE_X86)
+// XCR0 via xgetbv without requiring -mxsave on the baseline build
+uint64_t read_xcr0() {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+#endif
+
+CpuFeatures detect() {
+    CpuFeatures f;
+#if defined(IE_X86)
+    uint32_t a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return f;
+    const bool osxsave = (c >> 27) & 1;
+    const bool fma = (c >> 12) & 1;
+    const bool f16c = (c >> 29) & 1;
+    if (!osxsave) return f;
+
+    // The OS must save the vector state before any of it is usable
+    const uint64_t xcr0 = read_xcr0();
+    const bool ymm_os = (xcr0 & 0x6) == 0x6;
+    const bool zmm_os = ymm_os && (xcr0 & 0xE0) == 0xE0;
+    const bool amx_os = (xcr0 & 0x60000) == 0x60000;
+
+    if (__get_cpuid_max(0, nullptr) < 7) return f;
+    __cpuid_count(7, 0, a, b, c, d);
+    const uint32_t b7 = b, c7 = c, d7 = d;
+    __cpuid_count(7, 1, a, b, c, d);
+    const uint32_t a71 = a;
+
+    f.fma = ymm_os && fma;
+    f.f16c = ymm_os && f16c;
+    f.avx2 = ymm_os && ((b7 >> 5) & 1);
+    f.avx_vnni = ymm_os && ((a71 >> 4) & 1);
+    f.avx512f = zmm_os && ((b7 >> 16) & 1);
+    f.avx512bw = zmm_os && ((b7 >> 30) & 1);
+    f.avx512vl = zmm_os && ((b7 >> 31) & 1);
+    f.avx512_vnni = zmm_os && ((c7 >> 11) & 1);
+    f.avx512_bf16 = zmm_os && ((a71 >> 5) & 1);
+    f.amx_bf16 = amx_os && ((d7 >> 22) & 1);
+    f.amx_tile = amx_os && ((d7 >> 24) & 1);
+    f.amx_int8 = amx_os && ((d7 >> 25) & 1);
+#endif
+    return f;
+}
+
+// Which kernel translation units were built with their ISA flags (set by
+// CMake on x86-64; a build without them only has the scalar kernels)
+constexpr bool compiled_in(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return true;
+#if defined(IE_KERNELS_AVX2)
+        case Isa::AVX2: return true;
+#endif
+#if defined(IE_KERNELS_AVX512)
+        case Isa::AVX512: return true;
+#endif
+        default: return false;
+    }
+}
+
+} // namespace
+
+const CpuFeatures& cpu_features() {
+    static const CpuFeatures f = detect();
+    return f;
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::AVX2: return "avx2";
+        case Isa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+Isa parse_isa(const std::string& name) {
+    if (name == "scalar") return Isa::Scalar;
+    if (name == "avx2") return Isa::AVX2;
+    if (name == "avx512") return Isa::AVX512;
+    throw std::invalid_argument("unknown ISA '" + name + "' (expected scalar, avx2 or avx512)");
+}
+
+bool isa_supported(Isa isa) {
+    if (!compiled_in(isa)) return false;
+    const CpuFeatures& f = cpu_features();
+    switch (isa) {
+        case Isa::Scalar: return true;
+        case Isa::AVX2: return f.avx2 && f.fma && f.f16c;
+        case Isa::AVX512: return f.avx512f && f.avx2 && f.fma && f.f16c;
+    }
+    return false;
+}
+
+Isa best_isa() {
+    for (Isa isa : {Isa::AVX512, Isa::AVX2}) {
+        if (isa_supported(isa)) return isa;
+    }
+    return Isa::Scalar;
+}
+
+std::string cpu_features_string() {
+    const CpuFeatures& f = cpu_features();
+    std::string s;
+    auto add = [&](bool on, const char* name) {
+        if (!on) return;
+        if (!s.empty()) s += ' ';
+        s += name;
+    };
+    add(f.avx2, "avx2");
+    add(f.fma, "fma");
+    add(f.f16c, "f16c");
+    add(f.avx_vnni, "avx_vnni");
+    add(f.avx512f, "avx512f");
+    add(f.avx512bw, "avx512bw");
+    add(f.avx512vl, "avx512vl");
+    add(f.avx512_vnni, "avx512_vnni");
+    add(f.avx512_bf16, "avx512_bf16");
+    add(f.amx_tile, "amx_tile");
+    add(f.amx_bf16, "amx_bf16");
+    add(f.amx_int8, "amx_int8");
+    return s.empty() ? std::string("baseline") : s;
+}
+
+} // namespace ie
@@ -56,8 +56,25 @@ Tensor astype_copy(const TensorView& src, DType dst) {
       const uint16_t* p = src.ptr<const uint16_t>();
       for (int64_t i = 0; i < N; ++i) o[i] = bf16_to_f32(p[i]);
     } else if (src.dt == DType::I8) {
+      // Quantized weights dequantize with their per-row scales
       const int8_t* p = src.ptr<const int8_t>();
-      for (int64_t i = 0; i < N; ++i) o[i] = (float)p[i];
+      if (src.quant.defined() && src.rank() == 2) {
+        const int64_t cols = src.shape[1];
+        for (int64_t i = 0; i < N; ++i) o[i] = src.quant.scales[i / cols] * (float)p[i];
+      } else {
+        for (int64_t i = 0; i < N; ++i) o[i] = (float)p[i];
+      }
+    } else if (src.dt == DType::Q4 && src.quant.defined() && src.rank() == 2) {
+      // Blocks of 32: low nibbles are elements 0..15, high nibbles 16..31
+      const uint8_t* p = src.ptr<const uint8_t>();
+      const int64_t cols = src.shape[1], G = src.quant.group_size, groups = cols / G;
+      for (int64_t i = 0; i < N; ++i) {
+        const int64_t r = i / cols, k = i % cols, g = r * groups + k / G;
+        const uint8_t b = p[(size_t)(r * cols + (k & ~int64_t(31))) / 2 + (size_t)(k & 15)];
+        const int q = (k & 16) ? (b >> 4) : (b & 0x0F);
+        const float z = src.quant.zeros ? src.quant.zeros[g] : 8.0f;
+        o[i] = src.quant.scales[g] * ((float)q - z);
+      }
     } else {
       throw std::runtime_error("unsupported src->f32");
     }
@@ -0,0 +1,217 @@
+#include "infer_engine/core/thread_pool.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ie {
+
+namespace {
+
+thread_local bool tl_in_pool = false;
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(_M_X64)
+    _mm_pause();
+#endif
+}
+
+inline uint64_t pack_range(int64_t lo, int64_t hi) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(lo)) << 32) | static_cast<uint32_t>(hi);
+}
+inline int64_t range_lo(uint64_t r) { return static_cast<int64_t>(r >> 32); }
+inline int64_t range_hi(uint64_t r) { return static_cast<int64_t>(r & 0xFFFFFFFFu); }
+
+int env_int(const char* name, int fallback) {
+    const char* s = std::getenv(name);
+    if (!s || !*s) return fallback;
+    try { return std::stoi(s); } catch (...) { return fallback; }
+}
+
+std::vector<int> usable_cpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+        }
+    }
+#endif
+    return cpus;
+}
+
+} // namespace
+
+ThreadPoolOptions ThreadPoolOptions::from_env() {
+    ThreadPoolOptions o;
+    o.num_threads = env_int("IE_NUM_THREADS", 0);
+    o.spin_us = env_int("IE_SPIN_US", o.spin_us);
+    o.pin_threads = env_int("IE_PIN_THREADS", 0) != 0;
+    return o;
+}
+
+ThreadPool::ThreadPool(const ThreadPoolOptions& opts) : opts_(opts) {
+    const std::vector<int> cpus = usable_cpus();
+    int n = opts_.num_threads;
+    if (n <= 0) {
+        n = cpus.empty() ? static_cast<int>(std::thread::hardware_concurrency()) : static_cast<int>(cpus.size());
+    }
+    if (n < 1) n = 1;
+    ranges_.reset(new Range[static_cast<size_t>(n)]);
+    workers_.reserve(static_cast<size_t>(n - 1));
+    for (int id = 1; id < n; ++id) {
+        workers_.emplace_back([this, id] { worker_loop(id); });
+#if defined(__linux__)
+        // Workers take CPUs 1..n-1 of the mask; the caller keeps its own placement
+        if (opts_.pin_threads && !cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[static_cast<size_t>(id) % cpus.size()], &set);
+            pthread_setaffinity_np(workers_.back().native_handle(), sizeof(set), &set);
+        }
+#endif
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    stop_.store(true);
+    epoch_.fetch_add(1);
+    epoch_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::run(int64_t n, TaskFn fn, void* ctx) {
+    if (n <= 0) return;
+    if (n > INT32_MAX) {
+        // Ranges are packed as 32-bit halves; split very large index spaces
+        for (int64_t base = 0; base < n; base += INT32_MAX) {
+            const int64_t len = (n - base < INT32_MAX) ? n - base : INT32_MAX;
+            struct Shift { TaskFn fn; void* ctx; int64_t base; } s{fn, ctx, base};
+            run(len, [](void* c, int64_t i) { auto* sh = static_cast<Shift*>(c); sh->fn(sh->ctx, sh->base + i); }, &s);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(submit_mu_, std::try_to_lock);
+    if (n == 1 || workers_.empty() || tl_in_pool || !lock.owns_lock()) {
+        for (int64_t i = 0; i < n; ++i) fn(ctx, i);
+        return;
+    }
+
+    // Publish the job: contiguous initial shares, then open it and wake workers
+    const int P = num_threads();
+    fn_ = fn;
+    ctx_ = ctx;
+    error_ = nullptr;
+    error_set_.store(false, std::memory_order_relaxed);
+    pending_.store(n, std::memory_order_relaxed);
+    for (int p = 0; p < P; ++p) {
+        ranges_[p].bits.store(pack_range(n * p / P, n * (p + 1) / P), std::memory_order_relaxed);
+    }
+    closed_.store(false);
+    epoch_.fetch_add(1);
+    epoch_.notify_all();
+
+    tl_in_pool = true;
+    participate(0);
+    tl_in_pool = false;
+
+    // Tasks still running on workers; then make sure no worker is left
+    // holding the job before returning (fn/ctx live on the caller's stack)
+    while (pending_.load(std::memory_order_acquire) != 0) cpu_relax();
+    closed_.store(true);
+    while (busy_.load() != 0) cpu_relax();
+
+    if (error_) std::rethrow_exception(error_);
+}
+
+void ThreadPool::worker_loop(int id) {
+    tl_in_pool = true;
+    uint64_t seen = 0;
+    for (;;) {
+        // Spin for a while so back-to-back regions of one decode step do not
+        // pay a futex wake each, then park
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(opts_.spin_us);
+        uint32_t spins = 0;
+        while (epoch_.load(std::memory_order_acquire) == seen) {
+            cpu_relax();
+            if ((++spins & 63) == 0 && std::chrono::steady_clock::now() >= deadline) {
+                epoch_.wait(seen);
+            }
+        }
+        if (stop_.load()) return;
+
+        // Register before touching the job; the submitter closes the job and
+        // waits for busy_ to drain, so a late registrant either sees it closed
+        // or is waited for
+        busy_.fetch_add(1);
+        seen = epoch_.load();
+        if (!closed_.load()) participate(id);
+        busy_.fetch_sub(1);
+    }
+}
+
+void ThreadPool::participate(int id) {
+    int64_t i;
+    for (;;) {
+        while (pop(id, i)) execute(i);
+        if (!steal(id)) return;
+    }
+}
+
+bool ThreadPool::pop(int id, int64_t& i) {
+    std::atomic<uint64_t>& r = ranges_[id].bits;
+    uint64_t cur = r.load(std::memory_order_acquire);
+    for (;;) {
+        const int64_t lo = range_lo(cur), hi = range_hi(cur);
+        if (lo >= hi) return false;
+        if (r.compare_exchange_weak(cur, pack_range(lo + 1, hi), std::memory_order_acq_rel)) {
+            i = lo;
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::steal(int id) {
+    const int P = num_threads();
+    for (int k = 1; k < P; ++k) {
+        std::atomic<uint64_t>& victim = ranges_[(id + k) % P].bits;
+        uint64_t cur = victim.load(std::memory_order_acquire);
+        for (;;) {
+            const int64_t lo = range_lo(cur), hi = range_hi(cur);
+            if (lo >= hi) break;
+            const int64_t take = (hi - lo + 1) / 2; // back half
+            if (victim.compare_exchange_weak(cur, pack_range(lo, hi - take), std::memory_order_acq_rel)) {
+                // Own range is empty here, so no thief can be mid-CAS on a
+                // different value of it
+                ranges_[id].bits.store(pack_range(hi - take, hi), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::execute(int64_t i) {
+    try {
+        fn_(ctx_, i);
+    } catch (...) {
+        if (!error_set_.exchange(true)) error_ = std::current_exception();
+    }
+    pending_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+} // namespace ie
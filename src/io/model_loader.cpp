@@ -1,12 +1,20 @@
 #include "infer_engine/io/model_loader.hpp"
 #include "infer_engine/io/safetensors_reader.hpp"
+#include "infer_engine/io/safetensors_writer.hpp"
 #include "infer_engine/model/config.hpp"
 #include "infer_engine/model/weights.hpp"
 #include "infer_engine/core/tensor.hpp"
+#include "infer_engine/core/allocator.hpp"
+#include "infer_engine/core/thread_pool.hpp"
+#include "infer_engine/layers/ops/linear.hpp"
+#include <algorithm>
 #include <fstream>
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <cstring>
 
 namespace ie {
 
@@ -49,52 +57,73 @@ void load_tiny_bins(const std::string& dir, ModelCfg& cfg, ModelWeights& weights
     }
 }
 
+// quantization_config of a GPTQ/AWQ checkpoint (HF transformers layout)
+struct PackedQuantConfig {
+    bool present = false;
+    ops::PackedQ4Format format = ops::PackedQ4Format::GPTQ;
+    int64_t group_size = 0;     // 0: one group per row (config value -1)
+};
+
 // Simple JSON parser for config.json
-static void parse_mistral_config(const std::string& config_path, ModelCfg& cfg) {
+static void parse_mistral_config(const std::string& config_path, ModelCfg& cfg, PackedQuantConfig* packed = nullptr) {
     std::ifstream f(config_path);
     if (!f) {
         throw std::runtime_error("Failed to open config.json: " + config_path);
     }
-    
+
     std::string content((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
-    
-    // Simple parsing for Mistral config
-    auto find_int_value = [&](const std::string& key) -> int64_t {
+
+    // Simple parsing for Mistral config; `from` restricts the search to a nested object
+    auto find_int_value = [&](const std::string& key, size_t from = 0) -> int64_t {
         std::string search = "\"" + key + "\"";
-        size_t pos = content.find(search);
+        size_t pos = content.find(search, from);
         if (pos == std::string::npos) return 0;
-        
+
         size_t colon = content.find(':', pos);
         if (colon == std::string::npos) return 0;
-        
+
         size_t start = colon + 1;
         while (start < content.length() && (content[start] == ' ' || content[start] == '\t')) start++;
-        
+
         size_t end = start;
+        if (end < content.length() && content[end] == '-') end++;
         while (end < content.length() && std::isdigit(content[end])) end++;
-        
-        if (start == end) return 0;
+
+        if (end == start || (end == start + 1 && content[start] == '-')) return 0;
         return std::stoll(content.substr(start, end - start));
     };
-    
+
     auto find_float_value = [&](const std::string& key) -> float {
         std::string search = "\"" + key + "\"";
         size_t pos = content.find(search);
         if (pos == std::string::npos) return 0.0f;
-        
+
         size_t colon = content.find(':', pos);
         if (colon == std::string::npos) return 0.0f;
-        
+
         size_t start = colon + 1;
         while (start < content.length() && (content[start] == ' ' || content[start] == '\t')) start++;
-        
+
         size_t end = start;
         while (end < content.length() && (std::isdigit(content[end]) || content[end] == '.' || content[end] == 'e' || content[end] == '-' || content[end] == '+')) end++;
-        
+
         if (start == end) return 0.0f;
         return std::stof(content.substr(start, end - start));
     };
-    
+
+    auto find_string_value = [&](const std::string& key, size_t from = 0) -> std::string {
+        std::string search = "\"" + key + "\"";
+        size_t pos = content.find(search, from);
+        if (pos == std::string::npos) return "";
+        size_t colon = content.find(':', pos);
+        if (colon == std::string::npos) return "";
+        size_t open = content.find_first_not_of(" \t", colon + 1);
+        if (open == std::string::npos || content[open] != '"') return "";
+        size_t close = content.find('"', open + 1);
+        if (close == std::string::npos) return "";
+        return content.substr(open + 1, close - open - 1);
+    };
+
     cfg.d_model = find_int_value("hidden_size");
     cfg.n_layers = find_int_value("num_hidden_layers");
     cfg.n_heads = find_int_value("num_attention_heads");
@@ -102,78 +131,651 @@ static void parse_mistral_config(const std::string& config_path, ModelCfg& cfg)
     cfg.vocab_size = find_int_value("vocab_size");
     cfg.rope_theta = find_float_value("rope_theta");
     cfg.rope_dim = cfg.d_model / cfg.n_heads;  // Standard for Mistral
+
+    const size_t qc = content.find("\"quantization_config\"");
+    if (!packed || qc == std::string::npos) return;
+    const std::string method = find_string_value("quant_method", qc);
+    if (method != "gptq" && method != "awq") {
+        throw std::runtime_error("Unsupported quantization_config quant_method '" + method + "' (expected gptq or awq)");
+    }
+    if (find_int_value("bits", qc) != 4) {
+        throw std::runtime_error("Only 4-bit " + method + " checkpoints are supported");
+    }
+    packed->present = true;
+    packed->group_size = std::max<int64_t>(find_int_value("group_size", qc), 0);
+    if (method == "awq") {
+        std::string version = find_string_value("version", qc);
+        std::transform(version.begin(), version.end(), version.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (!version.empty() && version != "gemm") {
+            throw std::runtime_error("Unsupported AWQ version '" + version + "' (only the GEMM packing is)");
+        }
+        packed->format = ops::PackedQ4Format::AWQ;
+    } else {
+        packed->format = (find_string_value("checkpoint_format", qc) == "gptq_v2") ? ops::PackedQ4Format::GPTQv2
+                                                                                  : ops::PackedQ4Format::GPTQ;
+    }
+}
+
+// Tensor names of one checkpoint layout: Mistral's consolidated export, or HF
+// transformers (which GPTQ/AWQ exports use). Projections are stems that take
+// ".weight", or ".qweight"/".qzeros"/".scales" when packed.
+struct CheckpointNames {
+    const char* embeddings;
+    const char* lm_head;
+    const char* final_norm;
+    const char* layers;                     // followed by "<index>."
+    const char* wq; const char* wk; const char* wv; const char* wo;
+    const char* w1; const char* w2; const char* w3;
+    const char* attn_norm;
+    const char* ffn_norm;
+    bool rope_halves;                       // q/k rows ordered for rotate-half RoPE
+};
+
+static const CheckpointNames kMistralNames{
+    "tok_embeddings.weight", "output.weight", "norm.weight", "layers.",
+    "attention.wq", "attention.wk", "attention.wv", "attention.wo",
+    "feed_forward.w1", "feed_forward.w2", "feed_forward.w3",
+    "attention_norm.weight", "ffn_norm.weight", false};
+
+static const CheckpointNames kHfNames{
+    "model.embed_tokens.weight", "lm_head.weight", "model.norm.weight", "model.layers.",
+    "self_attn.q_proj", "self_attn.k_proj", "self_attn.v_proj", "self_attn.o_proj",
+    "mlp.gate_proj", "mlp.down_proj", "mlp.up_proj",
+    "input_layernorm.weight", "post_attention_layernorm.weight", true};
+
+static const CheckpointNames& checkpoint_names(const SafeTensorReader& reader) {
+    if (!reader.has_tensor(kMistralNames.embeddings) && reader.has_tensor(kHfNames.embeddings)) return kHfNames;
+    return kMistralNames;
+}
+
+// Projection tensors of a checkpoint (the ones quantization applies to)
+static bool is_projection_name(const std::string& name) {
+    static const char* suffixes[] = {
+        ".attention.wq.weight", ".attention.wk.weight", ".attention.wv.weight", ".attention.wo.weight",
+        ".feed_forward.w1.weight", ".feed_forward.w2.weight", ".feed_forward.w3.weight",
+        ".self_attn.q_proj.weight", ".self_attn.k_proj.weight", ".self_attn.v_proj.weight", ".self_attn.o_proj.weight",
+        ".mlp.gate_proj.weight", ".mlp.down_proj.weight", ".mlp.up_proj.weight",
+    };
+    for (const char* suf : suffixes) {
+        const size_t n = std::strlen(suf);
+        if (name.size() > n && name.compare(name.size() - n, n, suf) == 0) return true;
+    }
+    return false;
+}
+
+// Row m of the engine's interleaved-pair RoPE layout is this row of an HF
+// rotate-half projection: within a head, pair i's two halves sit D/2 apart
+static std::vector<int64_t> rope_halves_row_map(int64_t n_heads, int64_t head_dim) {
+    std::vector<int64_t> map(static_cast<size_t>(n_heads * head_dim));
+    for (int64_t m = 0; m < n_heads * head_dim; ++m) {
+        const int64_t h = m / head_dim, r = m % head_dim;
+        map[static_cast<size_t>(m)] = h * head_dim + (r % 2) * (head_dim / 2) + r / 2;
+    }
+    return map;
+}
+
+// Describe "<stem>.qweight/.qzeros/.scales" as a repack source, checking the
+// shapes and that g_idx (if any) is the trivial k / group_size ordering
+static ops::PackedQ4Source packed_source(const SafeTensorReader& reader, const std::string& stem,
+                                         const PackedQuantConfig& qc, const int64_t* row_map) {
+    auto bad = [&](const std::string& why) { return std::runtime_error("Packed tensor " + stem + ": " + why); };
+    if (!qc.present) throw bad("qweight without a quantization_config in config.json");
+    const SafeTensorInfo& wi = reader.get_tensor_info(stem + ".qweight");
+    const SafeTensorInfo& zi = reader.get_tensor_info(stem + ".qzeros");
+    const SafeTensorInfo& si = reader.get_tensor_info(stem + ".scales");
+    if (wi.dtype != "I32" || zi.dtype != "I32" || wi.shape.size() != 2 || zi.shape.size() != 2 || si.shape.size() != 2) {
+        throw bad("expected rank-2 I32 qweight/qzeros and rank-2 scales");
+    }
+
+    ops::PackedQ4Source src;
+    src.format = qc.format;
+    src.D_out = si.shape[1];
+    src.D_in = (qc.format == ops::PackedQ4Format::AWQ) ? wi.shape[0] : wi.shape[0] * 8;
+    const int64_t n_groups = si.shape[0];
+    const std::vector<int64_t> want_w = (qc.format == ops::PackedQ4Format::AWQ)
+        ? std::vector<int64_t>{src.D_in, src.D_out / 8} : std::vector<int64_t>{src.D_in / 8, src.D_out};
+    if (src.D_out % 8 != 0 || n_groups <= 0 || src.D_in % n_groups != 0 || wi.shape != want_w ||
+        zi.shape != std::vector<int64_t>{n_groups, src.D_out / 8}) {
+        throw bad("qweight/qzeros/scales shapes do not agree");
+    }
+    src.group_size = src.D_in / n_groups;
+    if (qc.group_size > 0 && qc.group_size != src.group_size) throw bad("group size differs from quantization_config");
+    if (si.dtype == "F16") src.scales_dt = DType::F16;
+    else if (si.dtype == "BF16") src.scales_dt = DType::BF16;
+    else if (si.dtype == "F32") src.scales_dt = DType::F32;
+    else throw bad("scales must be F16, BF16 or F32, got " + si.dtype);
+    src.qweight = static_cast<const int32_t*>(reader.get_tensor_data(stem + ".qweight"));
+    src.qzeros = static_cast<const int32_t*>(reader.get_tensor_data(stem + ".qzeros"));
+    src.scales = reader.get_tensor_data(stem + ".scales");
+    src.row_map = row_map;
+
+    const std::string g_idx = stem + ".g_idx";
+    if (reader.has_tensor(g_idx)) {
+        const SafeTensorInfo& gi = reader.get_tensor_info(g_idx);
+        if (gi.dtype != "I32" || gi.shape != std::vector<int64_t>{src.D_in}) throw bad("g_idx must be I32 [D_in]");
+        const auto* g = static_cast<const uint8_t*>(reader.get_tensor_data(g_idx));
+        for (int64_t k = 0; k < src.D_in; ++k) {
+            int32_t gk;
+            std::memcpy(&gk, g + k * sizeof(gk), sizeof(gk));
+            if (gk != k / src.group_size) throw bad("act-order (desc_act) g_idx is not supported");
+        }
+    }
+    if (!ops::can_repack_q4(src)) throw bad("group size must be a multiple of 32 dividing D_in");
+    return src;
+}
+
+// Copy the rows of a row-major (optionally I8/Q4 quantized) matrix in
+// row_map order; per-row scales and zeros move with their rows
+static size_t align_line(size_t bytes) {
+    return (bytes + kCacheLineBytes - 1) / kCacheLineBytes * kCacheLineBytes;
+}
+
+static int64_t quant_params_per_row(const TensorView& W) {
+    if (!W.quant.defined()) return 0;
+    return W.dt == DType::Q4 ? W.shape[1] / W.quant.group_size : 1;
+}
+
+static size_t permuted_rows_bytes(const TensorView& W) {
+    const size_t params = static_cast<size_t>(W.shape[0] * quant_params_per_row(W)) * sizeof(float);
+    return align_line(W.nbytes()) + align_line(params) + (W.quant.zeros ? params : 0);
+}
+
+static TensorView permute_rows(const TensorView& W, const int64_t* row_map, void* dst) {
+    if (W.shape.size() != 2 || W.layout != Layout::RowMajor || !W.is_contiguous()) {
+        throw std::runtime_error("permute_rows: expected a row-major matrix");
+    }
+    const int64_t D_out = W.shape[0], per_row = quant_params_per_row(W);
+    const size_t row_bytes = dtype_nbytes(W.dt, W.shape[1]);
+    auto* base = static_cast<uint8_t*>(dst);
+    auto* scales = reinterpret_cast<float*>(base + align_line(W.nbytes()));
+    float* zeros = scales + D_out * per_row;
+    const auto* src = static_cast<const uint8_t*>(W.data);
+    for (int64_t j = 0; j < D_out; ++j) {
+        const int64_t r = row_map[j];
+        std::memcpy(base + static_cast<size_t>(j) * row_bytes, src + static_cast<size_t>(r) * row_bytes, row_bytes);
+        for (int64_t g = 0; g < per_row; ++g) {
+            scales[j * per_row + g] = W.quant.scales[r * per_row + g];
+            if (W.quant.zeros) zeros[j * per_row + g] = W.quant.zeros[r * per_row + g];
+        }
+    }
+    TensorView v = W;
+    v.data = base;
+    if (per_row > 0) {
+        v.quant.scales = scales;
+        if (W.quant.zeros) v.quant.zeros = zeros;
+    }
+    return v;
+}
+
+// Bind a projection; if the checkpoint stores "<name>.scales" next to it (see
+// export_quantized_safetensors) the view is quantized and its params point
+// into the mapping as well
+static TensorView bind_projection(const SafeTensorReader& reader, const std::string& name) {
+    const std::string scales_name = name + ".scales";
+    if (!reader.has_tensor(scales_name)) return reader.get_tensor(name);
+
+    auto bad = [&](const std::string& why) { return std::runtime_error("Quantized tensor " + name + ": " + why); };
+    const SafeTensorInfo& vi = reader.get_tensor_info(name);
+    const SafeTensorInfo& si = reader.get_tensor_info(scales_name);
+    if (vi.shape.size() != 2 || si.shape.size() != 2 || si.dtype != "F32" || si.shape[0] != vi.shape[0]) {
+        throw bad("expected [D_out, *] values with F32 [D_out, groups] scales");
+    }
+    const int64_t D_out = vi.shape[0], groups = si.shape[1];
+    DType dt;
+    int64_t D_in, group_size;
+    if (vi.dtype == "I8") {
+        dt = DType::I8;
+        D_in = vi.shape[1];
+        group_size = 0;
+        if (groups != 1) throw bad("I8 takes one scale per row");
+    } else if (vi.dtype == "U8") {
+        dt = DType::Q4; // two nibbles per byte
+        D_in = vi.shape[1] * 2;
+        if (groups <= 0 || D_in % groups != 0 || (D_in / groups) % 32 != 0) throw bad("Q4 groups must be multiples of 32");
+        group_size = D_in / groups;
+    } else {
+        throw bad("values must be I8 or U8 (packed Q4), got " + vi.dtype);
+    }
+    if (vi.data_size != dtype_nbytes(dt, D_out * D_in) ||
+        si.data_size != static_cast<size_t>(D_out * groups) * sizeof(float)) {
+        throw bad("size mismatch");
+    }
+
+    TensorView v = make_view(const_cast<void*>(reader.get_tensor_data(name)), dt, {D_out, D_in});
+    v.quant.scales = static_cast<const float*>(reader.get_tensor_data(scales_name));
+    v.quant.group_size = group_size;
+    const std::string zeros_name = name + ".zeros";
+    if (reader.has_tensor(zeros_name)) {
+        const SafeTensorInfo& zi = reader.get_tensor_info(zeros_name);
+        if (dt != DType::Q4 || zi.dtype != "F32" || zi.shape != si.shape) throw bad("zeros must match the Q4 scales");
+        v.quant.zeros = static_cast<const float*>(reader.get_tensor_data(zeros_name));
+    }
+    const std::string smooth_name = name + ".smooth";
+    if (reader.has_tensor(smooth_name)) {
+        const SafeTensorInfo& mi = reader.get_tensor_info(smooth_name);
+        if (dt != DType::I8 || mi.dtype != "F32" || mi.shape != std::vector<int64_t>{D_in}) {
+            throw bad("smooth must be F32 [D_in] on an I8 weight");
+        }
+        v.quant.smooth = static_cast<const float*>(reader.get_tensor_data(smooth_name));
+    }
+    return v;
+}
+
+std::string source_safetensors_path(const std::string& model_dir) {
+    const std::string consolidated = model_dir + "/consolidated.safetensors";
+    if (std::ifstream(consolidated).good()) return consolidated;
+    return model_dir + "/model.safetensors";
 }
 
 // No global upcast: keep weights as stored (BF16/F16/F32). Matmuls upcast on-the-fly.
 
 void load_mistral_safetensors(const std::string& model_dir, ModelCfg& cfg, ModelWeights& weights) {
+    load_mistral_safetensors(model_dir, cfg, weights, LoadOptions{});
+}
+
+void load_mistral_safetensors(const std::string& model_dir, ModelCfg& cfg, ModelWeights& weights,
+                              const LoadOptions& opts) {
     // Parse config.json
     std::string config_path = model_dir + "/config.json";
-    parse_mistral_config(config_path, cfg);
+    PackedQuantConfig packed_cfg;
+    parse_mistral_config(config_path, cfg, &packed_cfg);
     
-    // Open safetensors file (try consolidated first, then fall back to model.safetensors)
-    std::string safetensors_path = model_dir + "/consolidated.safetensors";
-    std::ifstream test_file(safetensors_path);
-    if (!test_file.good()) {
-        safetensors_path = model_dir + "/model.safetensors";
+    // Prefer an exported quantized checkpoint; it is self-contained
+    std::string safetensors_path = model_dir + "/" + kQuantizedSafetensors;
+    const bool prequantized = opts.use_prequantized && std::ifstream(safetensors_path).good();
+    if (!prequantized) {
+        safetensors_path = source_safetensors_path(model_dir);
     }
-    test_file.close();
-    
+
     // Keep reader alive by shared_ptr captured into weights
     auto reader_sp = std::make_shared<SafeTensorReader>(safetensors_path);
+    if (prequantized) {
+        const auto& meta = reader_sp->metadata();
+        auto get = [&](const char* k) { auto it = meta.find(k); return it == meta.end() ? std::string("?") : it->second; };
+        std::cout << "[Loader] binding pre-quantized " << kQuantizedSafetensors << " (" << get("quant_dtype");
+        if (get("quant_dtype") == "Q4") {
+            std::cout << " g" << get("quant_group_size") << (get("quant_zero_points") == "true" ? " +zp" : "");
+        }
+        std::cout << ")" << std::endl;
+    }
     
+    const CheckpointNames& names = checkpoint_names(*reader_sp);
+
     // Load embeddings (keep source dtype)
     {
-        TensorView tv = reader_sp->get_tensor("tok_embeddings.weight");
+        TensorView tv = reader_sp->get_tensor(names.embeddings);
         weights.set_token_embeddings(tv);
     }
-    
-    // Load language model head (keep source dtype)
+
+    // Load language model head (keep source dtype); HF checkpoints may tie it
     {
-        TensorView tv = reader_sp->get_tensor("output.weight");
+        TensorView tv = reader_sp->has_tensor(names.lm_head) ? reader_sp->get_tensor(names.lm_head)
+                                                              : reader_sp->get_tensor(names.embeddings);
         weights.set_lm_head(tv);
     }
-    
+
     // Load final norm (keep source dtype)
     {
-        TensorView tv = reader_sp->get_tensor("norm.weight");
+        TensorView tv = reader_sp->get_tensor(names.final_norm);
         weights.set_final_norm(tv);
     }
-    
+
     // Initialize layer storage
     weights.set_num_layers(cfg.n_layers);
-    
-    // Bind layer tensors directly from storage (no global upcast)
-    
+
+    // Bind layer tensors directly from storage (no global upcast). Packed
+    // GPTQ/AWQ projections, and HF q/k rows (rotate-half order), need a
+    // rewritten copy; those are collected and built in one pass below.
+    struct Rewrite {
+        TensorView* slot;
+        bool packed;
+        ops::PackedQ4Source src;   // packed
+        const int64_t* row_map;    // plain: permute the bound rows
+    };
+    const int64_t head_dim = cfg.d_model / cfg.n_heads;
+    const int64_t n_kv_heads = cfg.n_kv_heads > 0 ? cfg.n_kv_heads : cfg.n_heads;
+    std::vector<int64_t> q_rows, k_rows;
+    if (names.rope_halves) {
+        q_rows = rope_halves_row_map(cfg.n_heads, head_dim);
+        k_rows = rope_halves_row_map(n_kv_heads, head_dim);
+    }
+    std::vector<LayerWeightsCXX> layers(static_cast<size_t>(cfg.n_layers));
+    std::vector<Rewrite> rewrites;
+    auto bind = [&](TensorView& slot, const std::string& stem, const std::vector<int64_t>* rows) {
+        const int64_t* row_map = rows ? rows->data() : nullptr;
+        if (reader_sp->has_tensor(stem + ".qweight")) {
+            rewrites.push_back({&slot, true, packed_source(*reader_sp, stem, packed_cfg, row_map), nullptr});
+            return;
+        }
+        slot = bind_projection(*reader_sp, stem + ".weight");
+        if (row_map) {
+            if (slot.shape.size() != 2 || slot.shape[0] != static_cast<int64_t>(rows->size())) {
+                throw std::runtime_error("Projection " + stem + " does not have n_heads * head_dim rows");
+            }
+            rewrites.push_back({&slot, false, {}, row_map});
+        }
+    };
+    auto has_projection = [&](const std::string& stem) {
+        return reader_sp->has_tensor(stem + ".weight") || reader_sp->has_tensor(stem + ".qweight");
+    };
+
     // Load each layer
     for (int64_t layer_idx = 0; layer_idx < cfg.n_layers; ++layer_idx) {
-        LayerWeightsCXX layer_weights;
-        std::string layer_prefix = "layers." + std::to_string(layer_idx) + ".";
-        
+        LayerWeightsCXX& layer_weights = layers[static_cast<size_t>(layer_idx)];
+        std::string layer_prefix = names.layers + std::to_string(layer_idx) + ".";
+
         // Attention weights
-        layer_weights.attn.Wq = reader_sp->get_tensor(layer_prefix + "attention.wq.weight");
-        layer_weights.attn.Wk = reader_sp->get_tensor(layer_prefix + "attention.wk.weight");
-        layer_weights.attn.Wv = reader_sp->get_tensor(layer_prefix + "attention.wv.weight");
-        layer_weights.attn.Wo = reader_sp->get_tensor(layer_prefix + "attention.wo.weight");
-
-        // MLP weights
-        TensorView w1 = reader_sp->get_tensor(layer_prefix + "feed_forward.w1.weight");
-        TensorView w2 = reader_sp->get_tensor(layer_prefix + "feed_forward.w2.weight");
-        layer_weights.mlp.W1 = w1;            // gate/first
-        layer_weights.mlp.W3 = w1;            // reuse if only w1/w2 present
-        layer_weights.mlp.W2 = w2;            // down
+        bind(layer_weights.attn.Wq, layer_prefix + names.wq, names.rope_halves ? &q_rows : nullptr);
+        bind(layer_weights.attn.Wk, layer_prefix + names.wk, names.rope_halves ? &k_rows : nullptr);
+        bind(layer_weights.attn.Wv, layer_prefix + names.wv, nullptr);
+        bind(layer_weights.attn.Wo, layer_prefix + names.wo, nullptr);
+
+        // MLP weights: W1 gate/first, W2 down; W3 is HF's up_proj, else W1 is reused
+        bind(layer_weights.mlp.W1, layer_prefix + names.w1, nullptr);
+        bind(layer_weights.mlp.W2, layer_prefix + names.w2, nullptr);
+        if (names.rope_halves && has_projection(layer_prefix + names.w3)) {
+            bind(layer_weights.mlp.W3, layer_prefix + names.w3, nullptr);
+        }
 
         // Layer norms
-        TensorView attn_norm = reader_sp->get_tensor(layer_prefix + "attention_norm.weight");
-        TensorView ffn_norm = reader_sp->get_tensor(layer_prefix + "ffn_norm.weight");
-        static std::vector<TensorView> attn_norm_views; // persistent holders not needed: we store pointers
+        TensorView attn_norm = reader_sp->get_tensor(layer_prefix + names.attn_norm);
+        TensorView ffn_norm = reader_sp->get_tensor(layer_prefix + names.ffn_norm);
         layer_weights.input_layernorm = new TensorView(attn_norm);
         layer_weights.post_attention_layernorm = new TensorView(ffn_norm);
-        
+    }
+
+    if (!rewrites.empty()) {
+        std::vector<size_t> offsets;
+        size_t total = 0, n_packed = 0;
+        int64_t group_size = 0;
+        for (const Rewrite& r : rewrites) {
+            offsets.push_back(total);
+            total += align_line(r.packed ? ops::repacked_q4_bytes(r.src) : permuted_rows_bytes(*r.slot));
+            if (r.packed) {
+                ++n_packed;
+                group_size = r.src.group_size;
+            }
+        }
+        std::shared_ptr<void> buf(alloc_aligned(total, kCacheLineBytes, /*huge_pages*/ true).release(), AlignedDeleter{});
+        auto* base = static_cast<uint8_t*>(buf.get());
+        parallel_for(static_cast<int64_t>(rewrites.size()), [&](int64_t i) {
+            const Rewrite& r = rewrites[static_cast<size_t>(i)];
+            void* dst = base + offsets[static_cast<size_t>(i)];
+            *r.slot = r.packed ? ops::repack_q4(r.src, dst) : permute_rows(*r.slot, r.row_map, dst);
+        });
+        weights.add_storage(buf);
+        if (n_packed > 0) {
+            std::cout << "[Loader] repacked " << n_packed << " "
+                      << (packed_cfg.format == ops::PackedQ4Format::AWQ ? "AWQ" : "GPTQ") << " projections to Q4 g"
+                      << group_size << " ("
+                      << (static_cast<double>(total) / (1024.0 * 1024.0)) << " MB)" << std::endl;
+        }
+    }
+    for (int64_t layer_idx = 0; layer_idx < cfg.n_layers; ++layer_idx) {
+        LayerWeightsCXX& layer_weights = layers[static_cast<size_t>(layer_idx)];
+        if (!layer_weights.mlp.W3.defined()) layer_weights.mlp.W3 = layer_weights.mlp.W1;
         weights.set_layer_weights(layer_idx, layer_weights);
     }
     // Capture owner to keep memory-mapped data alive
     weights.set_owner(reader_sp);
+
+    // Fuse, then quantize, then pack: each step sees the previous one's matrices
+    if (opts.fuse_qkv) {
+        fuse_qkv_weights(weights);
+    }
+    if (opts.quantize != WeightQuant::None) {
+        ops::QuantScheme scheme;
+        scheme.dt = (opts.quantize == WeightQuant::Q4) ? DType::Q4 : DType::I8;
+        scheme.group_size = opts.quant_group_size;
+        scheme.zero_points = opts.quant_zero_points;
+        quantize_model_weights(weights, scheme);
+    }
+    if (opts.quant_activations) {
+        enable_activation_quant(weights);
+    }
+    if (opts.pack_weights) {
+        pack_model_weights(weights);
+    }
+}
+
+void fuse_qkv_weights(ModelWeights& weights) {
+    auto fusable = [](const AttentionWeightsCXX& a) {
+        const TensorView* parts[] = {&a.Wq, &a.Wk, &a.Wv};
+        for (const TensorView* p : parts) {
+            if (!p->defined() || p->shape.size() != 2 || !p->is_contiguous() || p->quant.defined()) return false;
+            if (p->dt != a.Wq.dt || p->shape[1] != a.Wq.shape[1]) return false;
+        }
+        const TensorView* biases[] = {a.bq, a.bk, a.bv};
+        for (int i = 0; i < 3; ++i) {
+            const TensorView* b = biases[i];
+            if (b && (b->dt != DType::F32 || b->numel() != parts[i]->shape[0] || !b->is_contiguous())) return false;
+        }
+        return true;
+    };
+    auto has_bias = [](const AttentionWeightsCXX& a) { return a.bq || a.bk || a.bv; };
+
+    // Fused biases: one [width] F32 vector per layer and the view attention
+    // points at, kept together so the view addresses stay valid
+    struct FusedBias {
+        std::vector<float> values;
+        TensorView view;
+    };
+
+    std::vector<LayerWeightsCXX> layers;
+    std::vector<size_t> offsets;
+    size_t total = 0;
+    for (int64_t l = 0; l < weights.num_layers(); ++l) {
+        layers.push_back(weights.get_layer_weights(l));
+        const AttentionWeightsCXX& a = layers.back().attn;
+        offsets.push_back(total);
+        if (fusable(a)) {
+            const size_t bytes = a.Wq.nbytes() + a.Wk.nbytes() + a.Wv.nbytes();
+            total += (bytes + kCacheLineBytes - 1) / kCacheLineBytes * kCacheLineBytes;
+        }
+    }
+    if (total == 0) return;
+
+    std::shared_ptr<void> buf(alloc_aligned(total, kCacheLineBytes, /*huge_pages*/ true).release(), AlignedDeleter{});
+    auto* base = static_cast<uint8_t*>(buf.get());
+    const int64_t n_layers = weights.num_layers();
+    auto biases = std::make_shared<std::vector<FusedBias>>(static_cast<size_t>(n_layers));
+    parallel_for(n_layers, [&](int64_t l) {
+        AttentionWeightsCXX& a = layers[static_cast<size_t>(l)].attn;
+        if (!fusable(a)) return;
+        if (has_bias(a)) {
+            FusedBias& fb = (*biases)[static_cast<size_t>(l)];
+            const TensorView* parts[] = {a.bq, a.bk, a.bv};
+            const int64_t rows[] = {a.Wq.shape[0], a.Wk.shape[0], a.Wv.shape[0]};
+            for (int i = 0; i < 3; ++i) {
+                const float* src = parts[i] ? parts[i]->ptr<const float>() : nullptr;
+                for (int64_t j = 0; j < rows[i]; ++j) fb.values.push_back(src ? src[j] : 0.0f);
+            }
+            fb.view = make_view(fb.values.data(), DType::F32, {static_cast<int64_t>(fb.values.size())});
+            a.bqkv = &fb.view;
+        }
+        uint8_t* dst = base + offsets[static_cast<size_t>(l)];
+        std::memcpy(dst, a.Wq.data, a.Wq.nbytes());
+        std::memcpy(dst + a.Wq.nbytes(), a.Wk.data, a.Wk.nbytes());
+        std::memcpy(dst + a.Wq.nbytes() + a.Wk.nbytes(), a.Wv.data, a.Wv.nbytes());
+        a.Wqkv = make_view(dst, a.Wq.dt, {a.Wq.shape[0] + a.Wk.shape[0] + a.Wv.shape[0], a.Wq.shape[1]});
+    });
+    for (int64_t l = 0; l < n_layers; ++l) weights.set_layer_weights(l, layers[static_cast<size_t>(l)]);
+    weights.add_storage(buf);
+    weights.add_storage(biases);
+}
+
+// Rewrite every projection slot of bound weights (and lm_head if asked) into
+// one huge-page aligned buffer owned by `weights`. bytes_fn returns the size a
+// view needs, or 0 to leave it alone; convert writes the new copy. Aliased
+// views (e.g. W1 reused as W3) are converted once and rebound everywhere.
+template <typename BytesFn, typename ConvertFn>
+static size_t rewrite_projections(ModelWeights& weights, bool include_lm_head, BytesFn bytes_fn,
+                                  ConvertFn convert, size_t& total_bytes) {
+    std::vector<LayerWeightsCXX> layers;
+    for (int64_t l = 0; l < weights.num_layers(); ++l) layers.push_back(weights.get_layer_weights(l));
+    TensorView lm_head = weights.get_lm_head();
+
+    std::vector<TensorView*> slots;
+    for (auto& lw : layers) {
+        if (lw.attn.Wqkv.defined()) {
+            slots.push_back(&lw.attn.Wqkv); // attention never reads Wq/Wk/Wv then
+        } else {
+            for (TensorView* tv : {&lw.attn.Wq, &lw.attn.Wk, &lw.attn.Wv}) slots.push_back(tv);
+        }
+        for (TensorView* tv : {&lw.attn.Wo, &lw.mlp.W1, &lw.mlp.W2, &lw.mlp.W3}) {
+            slots.push_back(tv);
+        }
+    }
+    if (include_lm_head) slots.push_back(&lm_head);
+
+    std::map<const void*, size_t> index_of;   // source data -> entry
+    std::vector<TensorView> sources;
+    std::vector<size_t> offsets;
+    size_t total = 0;
+    for (TensorView* tv : slots) {
+        if (!tv->defined() || index_of.count(tv->data)) continue;
+        const size_t bytes = bytes_fn(*tv);
+        if (bytes == 0) continue;
+        index_of[tv->data] = sources.size();
+        sources.push_back(*tv);
+        offsets.push_back(total);
+        total += (bytes + kCacheLineBytes - 1) / kCacheLineBytes * kCacheLineBytes;
+    }
+    total_bytes = total;
+    if (sources.empty()) return 0;
+
+    std::shared_ptr<void> buf(alloc_aligned(total, kCacheLineBytes, /*huge_pages*/ true).release(), AlignedDeleter{});
+    auto* base = static_cast<uint8_t*>(buf.get());
+    std::vector<TensorView> converted(sources.size());
+    const int64_t n_src = static_cast<int64_t>(sources.size());
+    parallel_for(n_src, [&](int64_t i) {
+        converted[static_cast<size_t>(i)] = convert(sources[static_cast<size_t>(i)], base + offsets[static_cast<size_t>(i)]);
+    });
+
+    for (TensorView* tv : slots) {
+        auto it = index_of.find(tv->data);
+        if (it != index_of.end()) *tv = converted[it->second];
+    }
+    for (int64_t l = 0; l < weights.num_layers(); ++l) weights.set_layer_weights(l, layers[static_cast<size_t>(l)]);
+    if (include_lm_head) weights.set_lm_head(lm_head);
+    weights.add_storage(buf);
+    return sources.size();
+}
+
+void quantize_model_weights(ModelWeights& weights, const ops::QuantScheme& scheme) {
+    // lm_head stays in the checkpoint dtype: it is a small share of the
+    // per-token traffic and the most sensitive projection to quantize
+    size_t total = 0;
+    const size_t n = rewrite_projections(weights, /*include_lm_head*/ false,
+        [&](const TensorView& W) { return ops::can_quantize_weight(W, scheme) ? ops::quantized_weight_bytes(W, scheme) : size_t(0); },
+        [&](const TensorView& W, void* dst) { return ops::quantize_weight(W, scheme, dst); },
+        total);
+    if (n == 0) return;
+    std::cout << "[Loader] quantized " << n << " projections to " << dtype_name(scheme.dt);
+    if (scheme.dt == DType::Q4) std::cout << " g" << scheme.group_size << (scheme.zero_points ? " +zp" : "");
+    std::cout << " ("
+              << (static_cast<double>(total) / (1024.0 * 1024.0)) << " MB)" << std::endl;
+}
+
+size_t export_quantized_safetensors(const std::string& src_path, const std::string& dst_path,
+                                    const ops::QuantScheme& scheme, const SmoothQuantStats* smooth) {
+    SafeTensorReader reader(src_path);
+    const std::vector<std::string> names = reader.get_tensor_names();
+    std::unique_ptr<SafeTensorReader> stats;
+    if (smooth && scheme.dt == DType::I8) stats = std::make_unique<SafeTensorReader>(smooth->path);
+
+    // Quantize all projections the scheme fits into one buffer, in parallel
+    std::map<std::string, size_t> index_of;
+    std::vector<TensorView> sources;
+    std::vector<ops::QuantScheme> schemes;
+    std::vector<std::vector<float>> smooth_scales;
+    std::vector<size_t> offsets;
+    size_t total = 0;
+    for (const std::string& name : names) {
+        if (!is_projection_name(name) || reader.has_tensor(name + ".scales")) continue;
+        TensorView W = reader.get_tensor(name);
+        if (!ops::can_quantize_weight(W, scheme)) continue;
+        smooth_scales.emplace_back();
+        const std::string stats_name = name + ".act_absmax";
+        if (stats && stats->has_tensor(stats_name)) {
+            TensorView a = stats->get_tensor(stats_name);
+            if (a.dt != DType::F32 || a.numel() != W.shape[1]) {
+                throw std::runtime_error("Calibration tensor " + stats_name + " must be F32 [D_in]");
+            }
+            smooth_scales.back().resize(static_cast<size_t>(W.shape[1]));
+            ops::smooth_quant_scales(a.ptr<const float>(), W, smooth->alpha, smooth_scales.back().data());
+        }
+        index_of[name] = sources.size();
+        sources.push_back(W);
+        schemes.push_back(scheme);
+        if (!smooth_scales.back().empty()) schemes.back().smooth = smooth_scales.back().data();
+        offsets.push_back(total);
+        total += (ops::quantized_weight_bytes(W, schemes.back()) + kCacheLineBytes - 1) / kCacheLineBytes * kCacheLineBytes;
+    }
+    AlignedPtr buf = alloc_aligned(std::max<size_t>(total, 1), kCacheLineBytes, /*huge_pages*/ true);
+    auto* base = static_cast<uint8_t*>(buf.get());
+    std::vector<TensorView> quantized(sources.size());
+    parallel_for(static_cast<int64_t>(sources.size()), [&](int64_t i) {
+        const size_t k = static_cast<size_t>(i);
+        quantized[k] = ops::quantize_weight(sources[k], schemes[k], base + offsets[k]);
+    });
+
+    SafeTensorWriter writer;
+    for (const auto& [k, v] : reader.metadata()) writer.set_metadata(k, v);
+    writer.set_metadata("quant_dtype", dtype_name(scheme.dt));
+    writer.set_metadata("quant_group_size", std::to_string(scheme.dt == DType::Q4 ? scheme.group_size : 0));
+    writer.set_metadata("quant_zero_points", (scheme.dt == DType::Q4 && scheme.zero_points) ? "true" : "false");
+    for (const std::string& name : names) {
+        auto it = index_of.find(name);
+        if (it == index_of.end()) {
+            const SafeTensorInfo& info = reader.get_tensor_info(name);
+            writer.add_tensor(name, info.dtype, info.shape, reader.get_tensor_data(name), info.data_size);
+            continue;
+        }
+        const TensorView& q = quantized[it->second];
+        const int64_t D_out = q.shape[0], D_in = q.shape[1];
+        const int64_t groups = (q.dt == DType::Q4) ? D_in / q.quant.group_size : 1;
+        const size_t scale_bytes = static_cast<size_t>(D_out * groups) * sizeof(float);
+        if (q.dt == DType::Q4) {
+            writer.add_tensor(name, "U8", {D_out, D_in / 2}, q.data, q.nbytes());
+        } else {
+            writer.add_tensor(name, "I8", q.shape, q.data, q.nbytes());
+        }
+        writer.add_tensor(name + ".scales", "F32", {D_out, groups}, q.quant.scales, scale_bytes);
+        if (q.quant.zeros) writer.add_tensor(name + ".zeros", "F32", {D_out, groups}, q.quant.zeros, scale_bytes);
+        if (q.quant.smooth) {
+            writer.add_tensor(name + ".smooth", "F32", {D_in}, q.quant.smooth, static_cast<size_t>(D_in) * sizeof(float));
+        }
+    }
+    writer.write(dst_path);
+    return sources.size();
+}
+
+void enable_activation_quant(ModelWeights& weights) {
+    size_t n = 0;
+    for (int64_t l = 0; l < weights.num_layers(); ++l) {
+        LayerWeightsCXX lw = weights.get_layer_weights(l);
+        for (TensorView* tv : {&lw.attn.Wq, &lw.attn.Wk, &lw.attn.Wv, &lw.attn.Wqkv, &lw.attn.Wo,
+                               &lw.mlp.W1, &lw.mlp.W2, &lw.mlp.W3}) {
+            if (tv->dt == DType::I8 && tv->quant.defined() && tv->layout == Layout::RowMajor) {
+                tv->quant.dynamic_act = true;
+                ++n;
+            }
+        }
+        weights.set_layer_weights(l, lw);
+    }
+    if (n > 0) std::cout << "[Loader] int8 activations enabled on " << n << " projections" << std::endl;
+}
+
+void pack_model_weights(ModelWeights& weights) {
+    size_t total = 0;
+    const size_t n = rewrite_projections(weights, /*include_lm_head*/ true,
+        [](const TensorView& W) { return ops::can_pack_weight(W) ? ops::packed_weight_bytes(W) : size_t(0); },
+        [](const TensorView& W, void* dst) { return ops::pack_weight(W, dst); },
+        total);
+    if (n == 0) return;
+    std::cout << "[Loader] packed " << n << " projections into "
+              << (static_cast<double>(total) / (1024.0 * 1024.0)) << " MB panel storage" << std::endl;
 }
 
 } // namespace ie
@@ -12,26 +12,26 @@
 
 namespace ie {
 
-// Map safetensors dtype to our DType enum
-static DType parse_dtype(const std::string& dtype_str) {
+// Map safetensors dtype to our DType enum. Integer dtypes used by packed
+// quantized checkpoints (I32 qweight/qzeros, U8, ...) have no TensorView
+// equivalent and are read through get_tensor_data instead.
+static DType parse_dtype(const std::string& dtype_str, const std::string& name) {
     if (dtype_str == "F32") return DType::F32;
     if (dtype_str == "F16") return DType::F16;
     if (dtype_str == "BF16") return DType::BF16;
     if (dtype_str == "I8") return DType::I8;
-    // For now, map unsupported types to closest equivalent
-    if (dtype_str == "I32" || dtype_str == "I64" || dtype_str == "U8" || dtype_str == "U32") {
-        return DType::F32; // Fallback to F32 for quantized weights
-    }
-    throw std::runtime_error("Unsupported dtype: " + dtype_str);
+    throw std::runtime_error("Tensor " + name + " has dtype " + dtype_str +
+                             ", which has no TensorView equivalent; read it with get_tensor_data");
 }
 
-static size_t dtype_size(DType dtype) {
-    switch (dtype) {
-        case DType::F32: return 4;
-        case DType::F16: case DType::BF16: return 2;
-        case DType::I8: return 1;
-        default: throw std::runtime_error("Unknown dtype size");
-    }
+// Element size of any safetensors dtype, 0 if unknown
+static size_t raw_dtype_size(const std::string& dtype_str) {
+    if (dtype_str == "F64" || dtype_str == "I64" || dtype_str == "U64") return 8;
+    if (dtype_str == "F32" || dtype_str == "I32" || dtype_str == "U32") return 4;
+    if (dtype_str == "F16" || dtype_str == "BF16" || dtype_str == "I16" || dtype_str == "U16") return 2;
+    if (dtype_str == "I8" || dtype_str == "U8" || dtype_str == "BOOL" ||
+        dtype_str == "F8_E4M3" || dtype_str == "F8_E5M2") return 1;
+    return 0;
 }
 
 class SafeTensorReader::Impl {
@@ -40,6 +40,7 @@ public:
     void* mapped_data_;
     size_t file_size_;
     std::map<std::string, SafeTensorInfo> tensor_info_;
+    std::map<std::string, std::string> metadata_;
     size_t data_section_offset_;
 
     explicit Impl(const std::string& filepath) {
@@ -100,6 +101,26 @@ private:
         parse_json_metadata(header_json);
     }
 
+    // Flat {"key": "value", ...} object; values are strings per the format
+    void parse_string_pairs(const std::string& obj_str) {
+        auto read_string = [&](size_t& p, std::string& out) {
+            p = obj_str.find('"', p);
+            if (p == std::string::npos) return false;
+            out.clear();
+            for (++p; p < obj_str.size() && obj_str[p] != '"'; ++p) {
+                if (obj_str[p] == '\\' && p + 1 < obj_str.size()) ++p;
+                out += obj_str[p];
+            }
+            ++p;
+            return p <= obj_str.size();
+        };
+        size_t p = 0;
+        std::string key, value;
+        while (read_string(p, key) && read_string(p, value)) {
+            metadata_[key] = value;
+        }
+    }
+
     void parse_json_metadata(const std::string& json_str) {
         // Simple JSON parser for safetensors metadata
         // Format: {"tensor_name": {"dtype": "F32", "shape": [2,3], "data_offsets": [start, end]}, ...}
@@ -129,6 +150,12 @@ private:
             }
             
             std::string obj_str = json_str.substr(obj_start, obj_end - obj_start);
+
+            if (tensor_name == "__metadata__") {
+                parse_string_pairs(obj_str);
+                pos = obj_end;
+                continue;
+            }
             
             // Parse dtype
             size_t dtype_pos = obj_str.find("\"dtype\"");
@@ -214,14 +241,14 @@ TensorView SafeTensorReader::get_tensor(const std::string& name) const {
     }
 
     const auto& info = it->second;
-    DType dtype = parse_dtype(info.dtype);
+    DType dtype = parse_dtype(info.dtype, name);
     
     // Calculate expected size
     size_t expected_size = 1;
     for (int64_t dim : info.shape) {
         expected_size *= static_cast<size_t>(dim);
     }
-    expected_size *= dtype_size(dtype);
+    expected_size *= dtype_bytes(dtype);
 
     if (expected_size != info.data_size) {
         throw std::runtime_error("Tensor size mismatch for: " + name);
@@ -258,4 +285,21 @@ std::vector<std::string> SafeTensorReader::get_tensor_names() const {
     return names;
 }
 
+const void* SafeTensorReader::get_tensor_data(const std::string& name) const {
+    const SafeTensorInfo& info = get_tensor_info(name);
+    size_t expected_size = raw_dtype_size(info.dtype);
+    for (int64_t dim : info.shape) expected_size *= static_cast<size_t>(dim);
+    if (expected_size != info.data_size) {
+        throw std::runtime_error("Tensor size mismatch for: " + name);
+    }
+    if (info.data_offset + info.data_size > impl_->file_size_) {
+        throw std::runtime_error("Tensor data out of bounds: " + name);
+    }
+    return static_cast<const uint8_t*>(impl_->mapped_data_) + info.data_offset;
+}
+
+const std::map<std::string, std::string>& SafeTensorReader::metadata() const {
+    return impl_->metadata_;
+}
+
 } // namespace ie
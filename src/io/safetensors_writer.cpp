@@ -0,0 +1,113 @@
+#include "infer_engine/io/safetensors_writer.hpp"
+#include "infer_engine/core/types.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace ie {
+
+static const char* safetensors_dtype(DType dt) {
+    switch (dt) {
+        case DType::F32: return "F32";
+        case DType::F16: return "F16";
+        case DType::BF16: return "BF16";
+        case DType::I8: return "I8";
+        default: throw std::invalid_argument("SafeTensorWriter: dtype has no safetensors equivalent");
+    }
+}
+
+static size_t element_alignment(const std::string& dtype) {
+    if (dtype == "F64" || dtype == "I64" || dtype == "U64") return 8;
+    if (dtype == "F32" || dtype == "I32" || dtype == "U32") return 4;
+    if (dtype == "F16" || dtype == "BF16" || dtype == "I16" || dtype == "U16") return 2;
+    return 1;
+}
+
+static std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    out += '"';
+    return out;
+}
+
+void SafeTensorWriter::add_tensor(const std::string& name, const std::string& dtype,
+                                  const std::vector<int64_t>& shape, const void* data, size_t nbytes) {
+    if (name == "__metadata__") throw std::invalid_argument("SafeTensorWriter: reserved tensor name");
+    for (const Entry& e : entries_) {
+        if (e.name == name) throw std::invalid_argument("SafeTensorWriter: duplicate tensor " + name);
+    }
+    entries_.push_back(Entry{name, dtype, shape, data, nbytes});
+}
+
+void SafeTensorWriter::add_tensor(const std::string& name, const TensorView& tv) {
+    if (!tv.is_contiguous() || tv.layout != Layout::RowMajor || tv.quant.defined()) {
+        throw std::invalid_argument("SafeTensorWriter: " + name + " must be a plain contiguous tensor");
+    }
+    add_tensor(name, safetensors_dtype(tv.dt), tv.shape, tv.data, tv.nbytes());
+}
+
+void SafeTensorWriter::set_metadata(const std::string& key, const std::string& value) {
+    metadata_[key] = value;
+}
+
+size_t SafeTensorWriter::write(const std::string& path) const {
+    // Widest element first: with a 64-byte aligned data section and no gaps
+    // between tensors every tensor starts on a multiple of its element size
+    std::vector<const Entry*> order;
+    for (const Entry& e : entries_) order.push_back(&e);
+    std::stable_sort(order.begin(), order.end(), [](const Entry* a, const Entry* b) {
+        return element_alignment(a->dtype) > element_alignment(b->dtype);
+    });
+
+    std::ostringstream h;
+    h << '{';
+    bool first = true;
+    if (!metadata_.empty()) {
+        h << "\"__metadata__\":{";
+        for (const auto& [k, v] : metadata_) {
+            if (!first) h << ',';
+            h << json_string(k) << ':' << json_string(v);
+            first = false;
+        }
+        h << '}';
+    }
+    size_t offset = 0;
+    for (const Entry* e : order) {
+        if (!first) h << ',';
+        first = false;
+        h << json_string(e->name) << ":{\"dtype\":" << json_string(e->dtype) << ",\"shape\":[";
+        for (size_t i = 0; i < e->shape.size(); ++i) h << (i ? "," : "") << e->shape[i];
+        h << "],\"data_offsets\":[" << offset << ',' << offset + e->nbytes << "]}";
+        offset += e->nbytes;
+    }
+    h << '}';
+    std::string header = h.str();
+    header.append((64 - (8 + header.size()) % 64) % 64, ' ');
+
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) throw std::runtime_error("SafeTensorWriter: failed to open " + tmp);
+        uint8_t len[8];
+        const uint64_t n = header.size();
+        for (int i = 0; i < 8; ++i) len[i] = static_cast<uint8_t>(n >> (i * 8));
+        f.write(reinterpret_cast<const char*>(len), 8);
+        f.write(header.data(), static_cast<std::streamsize>(header.size()));
+        for (const Entry* e : order) {
+            f.write(static_cast<const char*>(e->data), static_cast<std::streamsize>(e->nbytes));
+        }
+        if (!f) throw std::runtime_error("SafeTensorWriter: failed to write " + tmp);
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("SafeTensorWriter: failed to rename " + tmp + " to " + path);
+    }
+    return 8 + header.size() + offset;
+}
+
+} // namespace ie
@@ -1,43 +1,282 @@
 #include "infer_engine/layers/attention_forward.hpp"
+#include "infer_engine/core/thread_pool.hpp"
 #include "infer_engine/layers/ops/linear.hpp"
-#include "infer_engine/layers/ops/softmax.hpp"
 #include "infer_engine/layers/ops/rope.hpp"
+#include "ops/kv_kernels.hpp"
+#include <algorithm>
+#include <limits>
 #include <stdexcept>
 #include <cmath>
 #include <vector>
 #include <cassert>
-#ifdef IE_OMP
-#include <omp.h>
-#endif
 
 namespace ie {
 namespace layers {
 
-Tensor attn_forward(
-    const TensorView& x,
-    const AttentionWeights& weights,
-    const AttentionConfig& config,
-    KVCache& cache,
-    int64_t layer_idx,
-    int64_t seq_pos
-) {
-    const int64_t n_q_heads = config.n_q_heads;
-    const int64_t n_kv_heads = config.n_kv_heads;
-    const int64_t d_head = config.head_dim;
-    if (n_q_heads <= 0 || n_kv_heads <= 0 || d_head <= 0) {
+namespace {
+
+// One layer's cached K/V rows [0, seq_len), dense or paged, in either
+// KVLayout (rows located through KVCache::row_index), with the tile kernel
+// of the active ISA for the cache dtype
+struct KVHistory {
+    const KVCache& cache;
+    int64_t layer_idx;
+    int64_t seq_len;
+    ops::kernels::AttendTileFn tile;
+};
+
+// Positions scored per step of the streaming loop; the tile's scores live on
+// the stack, so no buffer grows with the sequence
+constexpr int64_t kAttnTile = ops::kernels::kAttnTileRows;
+
+// Query heads evaluated together against one loaded K/V row; larger GQA
+// groups are split into chunks of this many heads
+constexpr int64_t kMaxGroupHeads = ops::kernels::kMaxTileHeads;
+
+// Positions per sequence split: longer histories are cut into splits that
+// run as separate tasks and are merged afterwards (flash-decoding), so a
+// single long sequence keeps every core busy even with few KV heads
+constexpr int64_t kSplitPositions = 8 * kAttnTile;
+
+int64_t attend_splits(int64_t seq_len) {
+    return (seq_len + kSplitPositions - 1) / kSplitPositions;
+}
+
+// Floats of merge scratch attend needs: per split and query head, the
+// unnormalized context [D] followed by its running max and sum
+int64_t attend_scratch_floats(int64_t seq_len, int64_t n_q_heads, int64_t D) {
+    const int64_t splits = attend_splits(seq_len);
+    return splits > 1 ? splits * n_q_heads * (D + 2) : 0;
+}
+
+// Online softmax over rows [t_begin, t_end) for G query heads that share
+// kv_h: each query head is scored against a K row while that row is loaded,
+// and the V row is added into every head's context the same way, so the
+// cache is read and dequantized once per KV head. Per head, each tile of
+// scores updates the running max m and sum l, the context accumulated so far
+// is rescaled by exp(m_old - m_new) and the tile's V rows are added with
+// weights exp(s - m) (see ops::kernels::AttendTileFn). acc [G, D] is left
+// unnormalized. The per-row scale of I8 / F8 rows is applied once per dot
+// product (K) and folded into the weight (V).
+void attend_range(const float* qg, int64_t G, const KVHistory& h, int64_t kv_h, int64_t t_begin, int64_t t_end,
+                  float* acc, float* m, float* l) {
+    const KVCacheConfig& kc = h.cache.config();
+    const int64_t D = kc.head_dim;
+    ops::kernels::AttnTile tile;
+    tile.q = qg;
+    tile.G = G;
+    tile.D = D;
+    tile.scale = 1.0f / std::sqrt(static_cast<float>(D));
+    tile.k = h.cache.k_view().ptr<const uint8_t>();
+    tile.v = h.cache.v_view().ptr<const uint8_t>();
+    tile.k_scales = kv_dtype_scaled(kc.dtype) ? h.cache.k_scales().ptr<const float>() : nullptr;
+    tile.v_scales = kv_dtype_scaled(kc.dtype) ? h.cache.v_scales().ptr<const float>() : nullptr;
+
+    for (int64_t i = 0; i < G * D; ++i) acc[i] = 0.0f;
+    for (int64_t g = 0; g < G; ++g) {
+        m[g] = -std::numeric_limits<float>::infinity();
+        l[g] = 0.0f;
+    }
+
+    // Rows of the tile's positions (consecutive in a head-major cache)
+    size_t rows[kAttnTile];
+    tile.rows = rows;
+    for (int64_t t0 = t_begin; t0 < t_end; t0 += kAttnTile) {
+        tile.n = std::min(kAttnTile, t_end - t0);
+        for (int64_t i = 0; i < tile.n; ++i) rows[i] = h.cache.row_index(h.layer_idx, t0 + i, kv_h);
+        h.tile(tile, acc, m, l);
+    }
+}
+
+// Decode attention for every query head into ctx [n_q_heads, D]. Tasks are
+// (KV head, head chunk, sequence split); with more than one split each task
+// leaves its (acc, m, l) in scratch and a log-sum-exp merge per head combines
+// them: M = max m_i, l = sum l_i e^(m_i - M), ctx = sum acc_i e^(m_i - M) / l.
+void attend(const float* q, const KVHistory& h, int64_t n_q_heads, int64_t gqa_group_size, float* ctx,
+            float* scratch) {
+    const int64_t KV_H = h.cache.config().num_kv_heads, D = h.cache.config().head_dim;
+    const int64_t seq_len = h.seq_len;
+    const int64_t chunks = (gqa_group_size + kMaxGroupHeads - 1) / kMaxGroupHeads;
+    const int64_t splits = attend_splits(seq_len);
+    assert(n_q_heads == KV_H * gqa_group_size);
+
+    // Scratch per split: acc [n_q_heads, D], then m [n_q_heads], then l [n_q_heads]
+    const int64_t block = n_q_heads * (D + 2);
+    auto split_acc = [&](int64_t split) { return scratch + split * block; };
+    auto split_m = [&](int64_t split) { return scratch + split * block + n_q_heads * D; };
+    auto split_l = [&](int64_t split) { return scratch + split * block + n_q_heads * (D + 1); };
+
+    parallel_for(KV_H * chunks * splits, [&](int64_t task) {
+        // Query heads [h0, h0 + G) all map to kv_h (GQA mapping q_h / group)
+        const int64_t split = task % splits;
+        const int64_t kv_h = task / (chunks * splits);
+        const int64_t h0 = kv_h * gqa_group_size + ((task / splits) % chunks) * kMaxGroupHeads;
+        const int64_t G = std::min(kMaxGroupHeads, (kv_h + 1) * gqa_group_size - h0);
+        const int64_t t_begin = split * kSplitPositions;
+        const int64_t t_end = std::min(seq_len, t_begin + kSplitPositions);
+        if (splits > 1) {
+            attend_range(q + h0 * D, G, h, kv_h, t_begin, t_end,
+                             split_acc(split) + h0 * D, split_m(split) + h0, split_l(split) + h0);
+            return;
+        }
+        float m[kMaxGroupHeads], l[kMaxGroupHeads];
+        float* acc = ctx + h0 * D;
+        attend_range(q + h0 * D, G, h, kv_h, t_begin, t_end, acc, m, l);
+        for (int64_t g = 0; g < G; ++g) {
+            const float inv_l = 1.0f / l[g];
+            for (int64_t d = 0; d < D; ++d) acc[g * D + d] *= inv_l;
+        }
+    });
+    if (splits == 1) return;
+
+    parallel_for(n_q_heads, [&](int64_t q_h) {
+        float M = -std::numeric_limits<float>::infinity();
+        for (int64_t i = 0; i < splits; ++i) M = std::max(M, split_m(i)[q_h]);
+        float* out = ctx + q_h * D;
+        for (int64_t d = 0; d < D; ++d) out[d] = 0.0f;
+        float L = 0.0f;
+        for (int64_t i = 0; i < splits; ++i) {
+            const float w = std::exp(split_m(i)[q_h] - M);
+            L += split_l(i)[q_h] * w;
+            const float* acc = split_acc(i) + q_h * D;
+            for (int64_t d = 0; d < D; ++d) out[d] += w * acc[d];
+        }
+        const float inv_l = 1.0f / L;
+        for (int64_t d = 0; d < D; ++d) out[d] *= inv_l;
+    });
+}
+
+// Task split of attend_causal: heads per chunk Gc, query rows per block, and
+// the scratch each (KV head, head chunk, row block) task owns: its stacked
+// queries and context [block_rows * Gc, D] plus one row's diagonal context
+// [Gc, D]
+struct CausalTasks {
+    int64_t Gc, chunks, block_rows, blocks;
+
+    CausalTasks(int64_t n_new, int64_t gqa_group_size)
+        : Gc(std::min(gqa_group_size, kMaxGroupHeads)),
+          chunks((gqa_group_size + Gc - 1) / Gc),
+          block_rows(std::max<int64_t>(1, kMaxGroupHeads / Gc)),
+          blocks((n_new + block_rows - 1) / block_rows) {}
+
+    int64_t slot_floats(int64_t D) const { return (2 * block_rows + 1) * Gc * D; }
+};
+
+int64_t attend_causal_scratch_floats(int64_t n_new, int64_t n_kv_heads, int64_t gqa_group_size, int64_t D) {
+    const CausalTasks ct(n_new, gqa_group_size);
+    return n_kv_heads * ct.chunks * ct.blocks * ct.slot_floats(D);
+}
+
+// Causal attention for n_new query rows q [n_new, n_q_heads, D] (q_stride
+// floats apart) at positions [start_pos, start_pos + n_new), whose K/V rows
+// are already in the cache;
+// row t sees positions [0, start_pos + t]. Tasks are (KV head, head chunk,
+// block of query rows): the rows of a block and the heads of a chunk are
+// stacked as one group, so every K/V row of the shared prefix (up to the
+// block's first position) is loaded once per block. The few diagonal
+// positions each later row also sees are scored per row and merged into its
+// (acc, m, l) like a sequence split. scratch holds
+// attend_causal_scratch_floats floats.
+void attend_causal(const float* q, int64_t q_stride, const KVHistory& h, int64_t start_pos, int64_t n_new,
+                   int64_t n_q_heads, int64_t gqa_group_size, float* ctx, float* scratch) {
+    const int64_t KV_H = h.cache.config().num_kv_heads, D = h.cache.config().head_dim;
+    const CausalTasks ct(n_new, gqa_group_size);
+    const int64_t Gc = ct.Gc, chunks = ct.chunks, block_rows = ct.block_rows, blocks = ct.blocks;
+
+    parallel_for(KV_H * chunks * blocks, [&](int64_t task) {
+        const int64_t block = task % blocks;
+        const int64_t kv_h = task / (chunks * blocks);
+        const int64_t h0 = kv_h * gqa_group_size + ((task / blocks) % chunks) * Gc;
+        const int64_t Gh = std::min(Gc, (kv_h + 1) * gqa_group_size - h0);
+        const int64_t t0 = block * block_rows;
+        const int64_t nb = std::min(block_rows, n_new - t0);
+        const int64_t G = nb * Gh;
+
+        // Group row (i, g) is query row t0 + i, head h0 + g
+        float* qg = scratch + task * ct.slot_floats(D);
+        float* acc = qg + block_rows * Gc * D;
+        float* tail = acc + block_rows * Gc * D;
+        for (int64_t i = 0; i < nb; ++i) {
+            const float* src = q + (t0 + i) * q_stride + h0 * D;
+            std::copy(src, src + Gh * D, qg + i * Gh * D);
+        }
+        float m[kMaxGroupHeads], l[kMaxGroupHeads], tm[kMaxGroupHeads], tl[kMaxGroupHeads];
+        const int64_t shared_end = start_pos + t0 + 1;
+        attend_range(qg, G, h, kv_h, 0, shared_end, acc, m, l);
+
+        for (int64_t i = 0; i < nb; ++i) {
+            float* acc_i = acc + i * Gh * D;
+            float* m_i = m + i * Gh;
+            float* l_i = l + i * Gh;
+            if (i > 0) {
+                attend_range(qg + i * Gh * D, Gh, h, kv_h, shared_end, shared_end + i, tail, tm, tl);
+                for (int64_t g = 0; g < Gh; ++g) {
+                    const float M = std::max(m_i[g], tm[g]);
+                    const float w0 = std::exp(m_i[g] - M), w1 = std::exp(tm[g] - M);
+                    l_i[g] = l_i[g] * w0 + tl[g] * w1;
+                    m_i[g] = M;
+                    for (int64_t d = 0; d < D; ++d) {
+                        acc_i[g * D + d] = acc_i[g * D + d] * w0 + tail[g * D + d] * w1;
+                    }
+                }
+            }
+            float* out = ctx + ((t0 + i) * n_q_heads + h0) * D;
+            for (int64_t g = 0; g < Gh; ++g) {
+                const float inv_l = 1.0f / l_i[g];
+                for (int64_t d = 0; d < D; ++d) out[g * D + d] = acc_i[g * D + d] * inv_l;
+            }
+        }
+    });
+}
+
+void check_config(const AttentionConfig& config) {
+    if (config.n_q_heads <= 0 || config.n_kv_heads <= 0 || config.head_dim <= 0) {
         throw std::invalid_argument("Invalid attention config (n_q_heads/n_kv_heads/head_dim)");
     }
-    if (n_q_heads % n_kv_heads != 0) {
+    if (config.n_q_heads % config.n_kv_heads != 0) {
         throw std::invalid_argument("n_q_heads must be divisible by n_kv_heads for GQA");
     }
-    
-    const int64_t gqa_group_size = n_q_heads / n_kv_heads;
+}
 
-    // Step 1: q, k, v projections
-    // Q: x -> [1, n_q_heads*d_head], K,V: x -> [1, n_kv_heads*d_head]
+// Step 1 for N input rows: q [N, n_q_heads * D], k, v [N, n_kv_heads * D],
+// with consecutive rows q_stride / kv_stride floats apart. A fused Wqkv runs
+// as one projection with the fused bias in its epilogue, and q, k, v are read
+// in place from its [N, q | k | v] rows.
+struct QKVRows {
+    Tensor q, k, v;   // separate projections
+    Tensor qkv;       // fused projection [N, q | k | v]
+    float* q_ptr = nullptr;
+    float* k_ptr = nullptr;
+    float* v_ptr = nullptr;
+    int64_t q_stride = 0;
+    int64_t kv_stride = 0;
+};
+
+QKVRows project_qkv(const TensorView& x, const AttentionWeights& weights, const AttentionConfig& config) {
     // Validate weight shapes early to avoid OOB
-    const int64_t expected_q_out = n_q_heads * d_head;
-    const int64_t expected_kv_out = n_kv_heads * d_head;
+    const int64_t expected_q_out = config.n_q_heads * config.head_dim;
+    const int64_t expected_kv_out = config.n_kv_heads * config.head_dim;
+    QKVRows r;
+    if (weights.Wqkv.defined()) {
+        // One projection and one parallel region for Q, K and V together
+        const int64_t width = expected_q_out + 2 * expected_kv_out;
+        if (weights.Wqkv.shape.size() != 2 || weights.Wqkv.shape[0] != width ||
+            weights.Wqkv.shape[1] != x.shape.back()) {
+            throw std::runtime_error("Wqkv shape mismatch");
+        }
+        if (!weights.bqkv && (weights.bq || weights.bk || weights.bv)) {
+            throw std::invalid_argument("Wqkv with q/k/v biases needs the fused bias bqkv (see fuse_qkv_weights)");
+        }
+        if (weights.bqkv && weights.bqkv->numel() != width) {
+            throw std::runtime_error("bqkv shape mismatch");
+        }
+        r.qkv = ie::ops::linear(x, weights.Wqkv, weights.bqkv);
+        r.q_ptr = r.qkv.view.ptr<float>();
+        r.k_ptr = r.q_ptr + expected_q_out;
+        r.v_ptr = r.k_ptr + expected_kv_out;
+        r.q_stride = r.kv_stride = width;
+        return r;
+    }
     if (weights.Wq.shape.size() != 2 || weights.Wq.shape[0] != expected_q_out || weights.Wq.shape[1] != x.shape.back()) {
         throw std::runtime_error("Wq shape mismatch");
     }
@@ -47,204 +286,151 @@ Tensor attn_forward(
     if (weights.Wv.shape.size() != 2 || weights.Wv.shape[0] != expected_kv_out || weights.Wv.shape[1] != x.shape.back()) {
         throw std::runtime_error("Wv shape mismatch");
     }
-    Tensor q = ie::ops::linear(x, weights.Wq, weights.bq);
-    Tensor k = ie::ops::linear(x, weights.Wk, weights.bk);
-    Tensor v = ie::ops::linear(x, weights.Wv, weights.bv);
-
-    // Create head views: Q has more heads than K,V in GQA
-    TensorView q_heads = make_view(q.view.data, q.view.dt, {n_q_heads, d_head});
-    TensorView k_heads = make_view(k.view.data, k.view.dt, {n_kv_heads, d_head});
-    TensorView v_heads = make_view(v.view.data, v.view.dt, {n_kv_heads, d_head});
-
-    // Step 2: RoPE on q, k (separate for Q and K since they have different head counts)
-    const int64_t rotary_dim = (config.rope_dim > 0) ? config.rope_dim : d_head;
-    const int64_t pairs = rotary_dim / 2;
-    
-    // RoPE for Q heads
-    Tensor pos_q = Tensor::empty({n_q_heads, pairs, 2}, DType::F32);
-    {
-        float* pp = pos_q.view.ptr<float>();
-        for (int64_t h = 0; h < n_q_heads; ++h) {
-            for (int64_t i = 0; i < pairs; ++i) {
-                float exponent = -2.0f * static_cast<float>(i) / static_cast<float>(rotary_dim);
-                float theta_i = std::pow(config.rope_theta, exponent);
-                float angle = static_cast<float>(seq_pos) * theta_i;
-                int64_t base = h * (pairs * 2) + i * 2;
-                pp[base + 0] = std::cos(angle);
-                pp[base + 1] = std::sin(angle);
-            }
-        }
-    }
-    
-    // RoPE for K heads  
-    Tensor pos_k = Tensor::empty({n_kv_heads, pairs, 2}, DType::F32);
-    {
-        float* pp = pos_k.view.ptr<float>();
-        for (int64_t h = 0; h < n_kv_heads; ++h) {
-            for (int64_t i = 0; i < pairs; ++i) {
-                float exponent = -2.0f * static_cast<float>(i) / static_cast<float>(rotary_dim);
-                float theta_i = std::pow(config.rope_theta, exponent);
-                float angle = static_cast<float>(seq_pos) * theta_i;
-                int64_t base = h * (pairs * 2) + i * 2;
-                pp[base + 0] = std::cos(angle);
-                pp[base + 1] = std::sin(angle);
-            }
-        }
-    }
+    r.q = ie::ops::linear(x, weights.Wq, weights.bq);
+    r.k = ie::ops::linear(x, weights.Wk, weights.bk);
+    r.v = ie::ops::linear(x, weights.Wv, weights.bv);
+    r.q_ptr = r.q.view.ptr<float>();
+    r.k_ptr = r.k.view.ptr<float>();
+    r.v_ptr = r.v.view.ptr<float>();
+    r.q_stride = expected_q_out;
+    r.kv_stride = expected_kv_out;
+    return r;
+}
 
-    // Apply RoPE separately to Q and K
-    auto [q_rot_t, q_unused_t] = ie::ops::rope_apply(q_heads, q_heads, pos_q.view, rotary_dim, config.rope_theta);
-    auto [k_unused_t, k_rot_t] = ie::ops::rope_apply(k_heads, k_heads, pos_k.view, rotary_dim, config.rope_theta);
-    TensorView q_rot_v = q_rot_t.view;
-    TensorView k_rot_v = k_rot_t.view;
-
-    // Step 3: Update KV cache with current K,V in FP16 and KVH layout
-    // Sources here are already [n_kv_heads, d_head] in F32 (k_rot_v, v_heads)
-    // Convert rowwise to fp16 and append
-    auto f32_to_f16 = [](float f) -> uint16_t {
-        union { uint32_t u; float f; } in; in.f = f;
-        uint32_t x = in.u;
-        uint32_t sign = (x >> 31) & 0x1;
-        int32_t exp = (int32_t)((x >> 23) & 0xFF) - 127 + 15;
-        uint32_t mant = x & 0x7FFFFF;
-        uint16_t out;
-        if (exp <= 0) {
-            if (exp < -10) {
-                out = (uint16_t)(sign << 15);
-            } else {
-                mant |= 0x800000;
-                uint32_t t = mant >> (1 - exp + 13);
-                if ((mant >> (1 - exp + 12)) & 1) t += 1;
-                out = (uint16_t)((sign << 15) | (t & 0x3FF));
-            }
-        } else if (exp >= 31) {
-            out = (uint16_t)((sign << 15) | (0x1F << 10) | (mant ? 0x200 : 0));
-        } else {
-            uint16_t e = (uint16_t)exp & 0x1F;
-            uint16_t m = (uint16_t)(mant >> 13);
-            if (mant & 0x1000) {
-                m += 1;
-                if (m == 0x400) { m = 0; e += 1; if (e >= 31) { out = (uint16_t)((sign << 15) | (0x1F << 10)); return out; } }
-            }
-            out = (uint16_t)((sign << 15) | (e << 10) | (m & 0x3FF));
-        }
-        return out;
-    };
-
-    assert(n_kv_heads > 0 && d_head > 0);
-    Tensor Kf16 = Tensor::empty({n_kv_heads, d_head}, DType::F16);
-    Tensor Vf16 = Tensor::empty({n_kv_heads, d_head}, DType::F16);
-    const float* ksrc = k_rot_v.ptr<const float>();
-    const float* vsrc = v_heads.ptr<const float>();
-    uint16_t* kdst = Kf16.view.ptr<uint16_t>();
-    uint16_t* vdst = Vf16.view.ptr<uint16_t>();
-    for (int64_t h = 0; h < n_kv_heads; ++h) {
-        const float* krow = ksrc + h * d_head;
-        const float* vrow = vsrc + h * d_head;
-        uint16_t* kdrow = kdst + h * d_head;
-        uint16_t* vdrow = vdst + h * d_head;
-        for (int64_t d = 0; d < d_head; ++d) {
-            kdrow[d] = f32_to_f16(krow[d]);
-            vdrow[d] = f32_to_f16(vrow[d]);
-        }
-    }
-    cache.append(layer_idx, seq_pos, Kf16.view, Vf16.view);
-
-    // Step 4: Compute attention scores with GQA - each K/V head serves multiple Q heads
-    const int64_t seq_len = seq_pos + 1;
-    Tensor scores = Tensor::empty({n_q_heads, seq_len}, DType::F32);
-    float* scores_ptr = scores.view.ptr<float>();
-
-    // Access cache memory for K,V (stored as F16)  
-    TensorView Kcache = cache.k_view(); // [L, S, KV_H, D], F16
-    TensorView Vcache = cache.v_view();
-    const uint16_t* Kbase = Kcache.ptr<const uint16_t>();
-    const uint16_t* Vbase = Vcache.ptr<const uint16_t>();
-
-    const int64_t L = cache.config().num_layers;
-    const int64_t S = cache.config().max_seq_len;
-    const int64_t KV_H = cache.config().num_kv_heads;  // Number of KV heads (8 for Mistral)
-    const int64_t D = cache.config().head_dim;
-
-    const int64_t stride_L = S * KV_H * D; // elements per layer
-    const int64_t stride_S = KV_H * D;     // elements per time step
-    const int64_t stride_H = D;            // elements per kv head
-    const int64_t layer_base = layer_idx * stride_L;
-
-    const float scale = 1.0f / std::sqrt(static_cast<float>(d_head));
-
-    const float* qptr = q_rot_v.ptr<const float>();
-    auto f16_to_f32 = [](uint16_t h) -> float {
-        uint32_t sign = (h & 0x8000) << 16;
-        uint32_t exp = (h & 0x7C00) >> 10;
-        uint32_t mant = (h & 0x03FF);
-        uint32_t f;
-        if (exp == 0) {
-            if (mant == 0) { f = sign; }
-            else {
-                exp = 127 - 15 + 1;
-                while ((mant & 0x0400) == 0) { mant <<= 1; exp--; }
-                mant &= 0x03FF;
-                f = sign | (exp << 23) | (mant << 13);
-            }
-        } else if (exp == 0x1F) {
-            f = sign | 0x7F800000 | (mant << 13);
-        } else {
-            exp = exp - 15 + 127;
-            f = sign | (exp << 23) | (mant << 13);
-        }
-        union { uint32_t u; float f; } out{f};
-        return out.f;
-    };
-    #ifdef IE_OMP
-    #pragma omp parallel for schedule(static)
-    #endif
-    for (int64_t q_h = 0; q_h < n_q_heads; ++q_h) {
-        // Map Q head to corresponding K/V head (GQA mapping)
-        const int64_t kv_h = q_h / gqa_group_size;
-        
-        const float* qh = qptr + q_h * d_head;
-        for (int64_t t = 0; t < seq_len; ++t) {
-            const uint16_t* kvec = Kbase + layer_base + t * stride_S + kv_h * stride_H;
-            float dot = 0.0f;
-            for (int64_t d = 0; d < d_head; ++d) {
-                dot += qh[d] * f16_to_f32(kvec[d]);
-            }
-            scores_ptr[q_h * seq_len + t] = dot * scale;
+// Step 2: RoPE on q, k rows at positions [pos0, pos0 + n_pos) in place, with
+// cos/sin read from the shared table or, without one, computed for these
+// positions only
+void rotate_qk(const AttentionConfig& config, const QKVRows& r, int64_t pos0, int64_t n_pos) {
+    const int64_t rotary_dim = (config.rope_dim > 0) ? config.rope_dim : config.head_dim;
+    const ops::RopeTable* table = config.rope_table;
+    const bool use_table = table && table->rotary_dim() == rotary_dim &&
+                           table->theta() == config.rope_theta && pos0 + n_pos <= table->size();
+    std::vector<float> cs_local;
+    if (!use_table) {
+        cs_local.resize(static_cast<size_t>(n_pos * rotary_dim));
+        for (int64_t p = 0; p < n_pos; ++p) {
+            ops::RopeTable::compute_row(rotary_dim, config.rope_theta, pos0 + p, cs_local.data() + p * rotary_dim);
         }
     }
+    const float* cs = use_table ? table->row(pos0) : cs_local.data();
+    ops::rope_rotate_inplace(r.q_ptr, n_pos, config.n_q_heads, config.head_dim, rotary_dim, cs, r.q_stride);
+    ops::rope_rotate_inplace(r.k_ptr, n_pos, config.n_kv_heads, config.head_dim, rotary_dim, cs, r.kv_stride);
+}
 
-    // Step 5: softmax over time dim per head
-    Tensor attn = ie::ops::softmax(scores.view, -1);
-    const float* attn_ptr = attn.view.ptr<const float>();
-
-    // Step 6: context = attn @ V (manual matmul with GQA mapping)
-    Tensor ctx = Tensor::empty({n_q_heads, d_head}, DType::F32);
-    float* ctx_ptr = ctx.view.ptr<float>();
-    const uint16_t* Vb = Vcache.ptr<const uint16_t>();
-    #ifdef IE_OMP
-    #pragma omp parallel for schedule(static)
-    #endif
-    for (int64_t q_h = 0; q_h < n_q_heads; ++q_h) {
-        // Map Q head to corresponding K/V head (same mapping as for attention scores)
-        const int64_t kv_h = q_h / gqa_group_size;
-        
-        float* ch = ctx_ptr + q_h * d_head;
-        for (int64_t d = 0; d < d_head; ++d) ch[d] = 0.0f;
-        for (int64_t t = 0; t < seq_len; ++t) {
-            float a = attn_ptr[q_h * seq_len + t];
-            const uint16_t* vvec = Vb + layer_base + t * stride_S + kv_h * stride_H;
-            for (int64_t d = 0; d < d_head; ++d) {
-                ch[d] += a * f16_to_f32(vvec[d]);
-            }
-        }
+// Context buffer of `floats` F32 values, reusing the caller's workspace
+float* workspace_floats(Tensor* workspace, Tensor& local, int64_t floats) {
+    Tensor* buf = workspace ? workspace : &local;
+    if (!buf->view.defined() || buf->view.dt != DType::F32 || buf->view.numel() < floats) {
+        *buf = Tensor::empty({floats}, DType::F32);
     }
+    return buf->view.ptr<float>();
+}
+
+} // namespace
 
-    // Step 7: output projection: flatten context and apply Wo
-    TensorView ctx_flat = make_view(ctx.view.data, ctx.view.dt, {1, n_q_heads * d_head});
-    Tensor out = ie::ops::linear(ctx_flat, weights.Wo, weights.bo);
+Tensor attn_forward(
+    const TensorView& x,
+    const AttentionWeights& weights,
+    const AttentionConfig& config,
+    KVCache& cache,
+    int64_t layer_idx,
+    int64_t seq_pos
+) {
+    Tensor out = Tensor::empty({1, weights.Wo.shape[0]}, DType::F32);
+    attn_forward_into(x, weights, config, cache, layer_idx, seq_pos, out.view, /*accumulate*/ false);
     return out;
 }
 
+void attn_forward_into(
+    const TensorView& x,
+    const AttentionWeights& weights,
+    const AttentionConfig& config,
+    KVCache& cache,
+    int64_t layer_idx,
+    int64_t seq_pos,
+    const TensorView& out,
+    bool accumulate,
+    Tensor* workspace
+) {
+    check_config(config);
+    const int64_t n_q_heads = config.n_q_heads;
+    const int64_t n_kv_heads = config.n_kv_heads;
+    const int64_t d_head = config.head_dim;
+    const int64_t gqa_group_size = n_q_heads / n_kv_heads;
+
+    // Step 1: q, k, v projections
+    // Q: x -> [1, n_q_heads*d_head], K,V: x -> [1, n_kv_heads*d_head]
+    const QKVRows qkv = project_qkv(x, weights, config);
+
+    // Step 2: RoPE on q, k in place
+    rotate_qk(config, qkv, seq_pos, 1);
+
+    // Step 3: Update KV cache; append converts the F32 rows to the cache
+    // dtype (F16, or I8 / F8 codes with a per-head scale). K,V have fewer
+    // heads than Q in GQA
+    cache.append(layer_idx, seq_pos, make_view(qkv.k_ptr, DType::F32, {n_kv_heads, d_head}),
+                 make_view(qkv.v_ptr, DType::F32, {n_kv_heads, d_head}));
+
+    // Steps 4-6: scores, softmax and context over the cached history in one
+    // streaming pass; context [n_q_heads, d_head] and the split-merge scratch
+    // reuse the caller's workspace
+    const KVHistory hist{cache, layer_idx, seq_pos + 1, ops::kernels::select_attend_tile(cache.config().dtype)};
+    const int64_t ctx_floats = n_q_heads * d_head;
+    Tensor local;
+    float* ctx = workspace_floats(workspace, local, ctx_floats + attend_scratch_floats(hist.seq_len, n_q_heads, d_head));
+    float* scratch = ctx + ctx_floats;
+    attend(qkv.q_ptr, hist, n_q_heads, gqa_group_size, ctx, scratch);
+
+    // Step 7: output projection: flatten context and apply Wo straight into out
+    TensorView ctx_flat = make_view(ctx, DType::F32, {1, n_q_heads * d_head});
+    ie::ops::LinearEpilogue ep;
+    ep.bias = weights.bo;
+    ep.accumulate = accumulate;
+    ie::ops::linear_into(ctx_flat, weights.Wo, out, ep);
+}
+
+void attn_prefill_into(
+    const TensorView& x,
+    const AttentionWeights& weights,
+    const AttentionConfig& config,
+    KVCache& cache,
+    int64_t layer_idx,
+    int64_t start_pos,
+    const TensorView& out,
+    bool accumulate,
+    Tensor* workspace
+) {
+    check_config(config);
+    const int64_t n_new = (x.shape.size() == 1) ? 1 : x.shape[0];
+    const int64_t n_q_heads = config.n_q_heads;
+    const int64_t n_kv_heads = config.n_kv_heads;
+    const int64_t d_head = config.head_dim;
+
+    // Steps 1-2: [n_new, d_model] GEMM projections, RoPE over the position range
+    const QKVRows qkv = project_qkv(x, weights, config);
+    rotate_qk(config, qkv, start_pos, n_new);
+
+    // Step 3: all new positions in one bulk append
+    const std::vector<int64_t> kv_shape{n_new, n_kv_heads, d_head}, kv_strides{qkv.kv_stride, d_head, 1};
+    cache.append_range(layer_idx, start_pos, make_view(qkv.k_ptr, DType::F32, kv_shape, kv_strides),
+                       make_view(qkv.v_ptr, DType::F32, kv_shape, kv_strides));
+
+    // Steps 4-6: causal attention of the new rows over the cache
+    const KVHistory hist{cache, layer_idx, start_pos + n_new, ops::kernels::select_attend_tile(cache.config().dtype)};
+    // ctx [n_new, n_q_heads, d_head] followed by the per-task scratch
+    const int64_t gqa_group_size = n_q_heads / n_kv_heads;
+    const int64_t ctx_floats = n_new * n_q_heads * d_head;
+    Tensor local;
+    float* ctx = workspace_floats(workspace, local,
+                                  ctx_floats + attend_causal_scratch_floats(n_new, n_kv_heads, gqa_group_size, d_head));
+    attend_causal(qkv.q_ptr, qkv.q_stride, hist, start_pos, n_new, n_q_heads, gqa_group_size, ctx, ctx + ctx_floats);
+
+    // Step 7: [n_new, n_q_heads * d_head] @ Wo.T straight into out
+    ie::ops::LinearEpilogue ep;
+    ep.bias = weights.bo;
+    ep.accumulate = accumulate;
+    ie::ops::linear_into(make_view(ctx, DType::F32, {n_new, n_q_heads * d_head}), weights.Wo, out, ep);
+}
+
 } // namespace layers
 } // namespace ie
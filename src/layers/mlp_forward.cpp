@@ -1,7 +1,6 @@
 #include "infer_engine/layers/mlp_forward.hpp"
 #include "infer_engine/layers/ops/linear.hpp"
 #include "infer_engine/layers/ops/activations.hpp"
-#include "infer_engine/layers/ops/elementwise.hpp"
 #include <stdexcept>
 
 namespace ie {
@@ -12,46 +11,68 @@ Tensor mlp_forward(
     const MLPWeights& weights,
     const MLPConfig& config
 ) {
-    // Step 1: Gate projection with activation
-    //   gate_linear = linear(x, weights.W1, weights.b1)    // [1, d_ff]
-    //   if (config.use_gelu):
-    //       gate = gelu(gate_linear)
-    //   else:
-    //       gate = silu(gate_linear)
-    //
-    Tensor gate_linear = ie::ops::linear(x, weights.W1, weights.b1);
-    Tensor gate;
-    if(config.use_gelu){
-        gate = ie::ops::gelu(gate_linear.view);
-    }
-    else{
-        gate = ie::ops::silu(gate_linear.view);
+    return mlp_forward(x, weights, config, nullptr);
+}
+
+Tensor mlp_forward(
+    const TensorView& x,
+    const MLPWeights& weights,
+    const MLPConfig& config,
+    Tensor* workspace
+) {
+    const int64_t N = (x.shape.size() == 1) ? 1 : x.shape[0];
+    Tensor out = Tensor::empty({N, weights.W2.shape[0]}, DType::F32);
+    mlp_forward_into(x, weights, config, workspace, out.view, /*accumulate*/ false);
+    return out;
+}
+
+void mlp_forward_into(
+    const TensorView& x,
+    const MLPWeights& weights,
+    const MLPConfig& config,
+    Tensor* workspace,
+    const TensorView& out,
+    bool accumulate
+) {
+    const int64_t N = (x.shape.size() == 1) ? 1 : x.shape[0];
+    const int64_t d_ff = weights.W1.shape[0];
+    const ie::ops::Activation act = config.use_gelu ? ie::ops::Activation::GELU : ie::ops::Activation::SiLU;
+
+    // Hidden activations [N, d_ff]: reuse the caller's workspace when it is big enough
+    Tensor local;
+    Tensor* hidden_buf = workspace ? workspace : &local;
+    if (!hidden_buf->view.defined() || hidden_buf->view.dt != DType::F32 || hidden_buf->view.numel() < N * d_ff) {
+        *hidden_buf = Tensor::empty({N, d_ff}, DType::F32);
     }
-    
-    // Step 2: Up projection (no activation)
-    //   up = linear(x, weights.W3, weights.b3)             // [1, d_ff]
-    //
-    Tensor up = ie::ops::linear(x, weights.W3, weights.b3);
-  
-    // Step 3: Element-wise multiply (gating)
-    //   hidden = gate * up                                 // [1, d_ff]
-    //
-    // Element-wise multiply (gate * up) – implement inplace here for now
-    Tensor hidden = Tensor::empty(gate.view.shape, gate.view.dt);
-    {
+    TensorView hidden = make_view(hidden_buf->view.data, DType::F32, {N, d_ff});
+
+    const bool fusable = !weights.b1 && !weights.b3 &&
+                         weights.W1.dt == weights.W3.dt && weights.W1.layout == weights.W3.layout &&
+                         weights.W1.shape == weights.W3.shape;
+    if (fusable) {
+        // Steps 1-3 fused: hidden = act(x W1^T) * (x W3^T) from one pass over x
+        ie::ops::gated_linear_into(x, weights.W1, weights.W3, act, hidden);
+    } else {
+        // Step 1: Gate projection with activation
+        Tensor gate_linear = ie::ops::linear(x, weights.W1, weights.b1);
+        Tensor gate = config.use_gelu ? ie::ops::gelu(gate_linear.view) : ie::ops::silu(gate_linear.view);
+
+        // Step 2: Up projection (no activation)
+        Tensor up = ie::ops::linear(x, weights.W3, weights.b3);
+
+        // Step 3: Element-wise multiply (gating)
         const float* g = gate.view.ptr<const float>();
         const float* u = up.view.ptr<const float>();
-        float* h = hidden.view.ptr<float>();
-        int64_t N = gate.view.numel();
-        for (int64_t i = 0; i < N; ++i) h[i] = g[i] * u[i];
+        float* h = hidden.ptr<float>();
+        for (int64_t i = 0; i < N * d_ff; ++i) h[i] = g[i] * u[i];
     }
-    
-    // Step 4: Down projection
-    //   output = linear(hidden, weights.W2, weights.b2)    // [1, d_model]
-    //
-    Tensor output = ie::ops::linear(hidden.view, weights.W2, weights.b2);
-    
-    return output;
+
+    // Step 4: Down projection straight from the hidden workspace into out
+    //   out (+)= linear(hidden, W2, b2)    // [N, d_model]
+    ie::ops::LinearEpilogue ep;
+    ep.bias = weights.b2;
+    ep.accumulate = accumulate;
+    ie::ops::linear_into(hidden, weights.W2, out, ep);
 }
 
 } // namespace layers
@@ -18,7 +18,7 @@ Tensor silu(const TensorView& x) {
     int64_t total_elements = x.numel();
 
     for(int64_t i = 0; i < total_elements; i++){
-        float sigmoid_val = 1.0f / (1.0f + std::expf(-input_ptr[i]));
+        float sigmoid_val = 1.0f / (1.0f + std::exp(-input_ptr[i]));
         output_ptr[i] = input_ptr[i] * sigmoid_val;
     }
 
@@ -0,0 +1,263 @@
+#pragma once
+// SIMD traits shared by the per-ISA kernel translation units (linear_kernels_*
+// and kv_kernels_*): Vec widens any weight / KV dtype to F32 lanes in
+// registers at the level selected by IE_KERNEL_LEVEL (0 scalar, 1
+// AVX2+FMA+F16C, 2 AVX-512F). Everything is in an anonymous namespace, so
+// each TU gets its own copy built with its own flags.
+#ifndef IE_KERNEL_LEVEL
+#error "define IE_KERNEL_LEVEL before including kernel_vec.hpp"
+#endif
+
+#include "infer_engine/core/types.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#if IE_KERNEL_LEVEL >= 1
+#include <immintrin.h>
+#else
+#include "infer_engine/core/half.hpp"
+#endif
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+namespace {
+
+template <DType DT> struct Elem;
+template <> struct Elem<DType::F32>  { using type = float; };
+template <> struct Elem<DType::F16>  { using type = uint16_t; };
+template <> struct Elem<DType::BF16> { using type = uint16_t; };
+template <> struct Elem<DType::I8>   { using type = int8_t; };
+template <> struct Elem<DType::F8>   { using type = uint8_t; };  // E4M3 codes
+
+// E4M3 code -> F16 bits of the same value / 256: sign, then exponent and
+// mantissa shifted into place (E4M3 subnormals land on F16 subnormals), so
+// widening is an F16 conversion and one multiply. The NaN codes, which the
+// KV writer never produces, decode as +-480.
+constexpr float kF8Rescale = 256.0f;
+inline uint16_t f8_as_f16(uint8_t v) {
+    return static_cast<uint16_t>(((v & 0x80u) << 8) | ((v & 0x7Fu) << 7));
+}
+
+// F32 -> E4M3 on the bit pattern of |x|: round the mantissa to 3 bits (to
+// nearest even) and rebias the exponent from 127 to 7, saturating at 448
+// (0x7E); below the smallest normal 2^-6 the code is x * 2^9 rounded. NaN
+// inputs are not handled (the KV writer scales finite rows).
+constexpr int32_t kF8RoundBias = 0x7FFFF;
+constexpr int32_t kF8Rebias = (127 - 7) << 3;
+constexpr int32_t kF8MaxCode = 0x7E;
+constexpr float kF8MinNormal = 0.015625f;
+constexpr float kF8SubnormalScale = 512.0f;
+
+template <DType DT>
+inline float load_scalar(const void* p, int64_t i) {
+    const auto* e = static_cast<const typename Elem<DT>::type*>(p) + i;
+    if constexpr (DT == DType::F32 || DT == DType::I8) {
+        return static_cast<float>(*e);
+    } else if constexpr (DT == DType::F8) {
+#if IE_KERNEL_LEVEL >= 1
+        return _cvtsh_ss(f8_as_f16(*e)) * kF8Rescale;
+#else
+        return half::f16_to_f32(f8_as_f16(*e)) * kF8Rescale;
+#endif
+    } else if constexpr (DT == DType::BF16) {
+        const uint32_t u = static_cast<uint32_t>(*e) << 16;
+        float f;
+        std::memcpy(&f, &u, sizeof(f));
+        return f;
+    } else {
+#if IE_KERNEL_LEVEL >= 1
+        return _cvtsh_ss(*e);
+#else
+        return half::f16_to_f32(*e);
+#endif
+    }
+}
+
+// SIMD traits: widen any supported dtype to F32 lanes in registers.
+#if IE_KERNEL_LEVEL == 2
+struct Vec {
+    using reg = __m512;
+    static constexpr int64_t W = 16;
+    static constexpr int MR = 4; // GEMM x rows per tile (16 accumulators)
+    static reg zero() { return _mm512_setzero_ps(); }
+    static reg set1(float v) { return _mm512_set1_ps(v); }
+    static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+    static float hsum(reg a) { return _mm512_reduce_add_ps(a); }
+    static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+    static reg abs(reg a) { return _mm512_abs_ps(a); }
+    static float hmax(reg a) { return _mm512_reduce_max_ps(a); }
+    static void store(float* p, reg a) { _mm512_storeu_ps(p, a); }
+    static void store_f16(uint16_t* p, reg a) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_cvtps_ph(a, _MM_FROUND_TO_NEAREST_INT));
+    }
+    // Lanes rounded to nearest even and saturated to int8
+    static void store_i8(int8_t* p, reg a) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm512_cvtsepi32_epi8(_mm512_cvtps_epi32(a)));
+    }
+    // Lanes encoded as E4M3 codes, bit-identical to half::f32_to_e4m3
+    static void store_f8(uint8_t* p, reg a) {
+        const __m512 x = _mm512_abs_ps(a);
+        const __m512i b = _mm512_castps_si512(x);
+        const __m512i sign = _mm512_srli_epi32(_mm512_andnot_si512(b, _mm512_castps_si512(a)), 24);
+        const __m512i up = _mm512_add_epi32(_mm512_set1_epi32(kF8RoundBias),
+                                            _mm512_and_si512(_mm512_srli_epi32(b, 20), _mm512_set1_epi32(1)));
+        __m512i code = _mm512_sub_epi32(_mm512_srli_epi32(_mm512_add_epi32(b, up), 20), _mm512_set1_epi32(kF8Rebias));
+        code = _mm512_min_epi32(code, _mm512_set1_epi32(kF8MaxCode));
+        const __m512i sub = _mm512_cvtps_epi32(_mm512_mul_ps(x, _mm512_set1_ps(kF8SubnormalScale)));
+        code = _mm512_mask_blend_epi32(_mm512_cmp_ps_mask(x, _mm512_set1_ps(kF8MinNormal), _CMP_LT_OQ), code, sub);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm512_cvtepi32_epi8(_mm512_or_si512(code, sign)));
+    }
+
+    template <DType DT>
+    static reg load(const void* p, int64_t i) {
+        const auto* e = static_cast<const typename Elem<DT>::type*>(p) + i;
+        if constexpr (DT == DType::F32) {
+            return _mm512_loadu_ps(e);
+        } else if constexpr (DT == DType::I8) {
+            return _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(e))));
+        } else if constexpr (DT == DType::F8) {
+            const __m256i w = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(e)));
+            const __m256i h = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(w, _mm256_set1_epi16(0x80)), 8),
+                                              _mm256_slli_epi16(_mm256_and_si256(w, _mm256_set1_epi16(0x7F)), 7));
+            return _mm512_mul_ps(_mm512_cvtph_ps(h), _mm512_set1_ps(kF8Rescale));
+        } else {
+            __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(e));
+            if constexpr (DT == DType::BF16) {
+                return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(h), 16));
+            } else {
+                return _mm512_cvtph_ps(h);
+            }
+        }
+    }
+
+    // One Q4 block (32 nibbles in 16 bytes) -> elements 0..15, 16..31
+    static void q4_block(const uint8_t* b, reg (&q)[2]) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        const __m128i m = _mm_set1_epi8(0x0F);
+        q[0] = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_and_si128(v, m)));
+        q[1] = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_and_si128(_mm_srli_epi16(v, 4), m)));
+    }
+};
+#elif IE_KERNEL_LEVEL == 1
+struct Vec {
+    using reg = __m256;
+    static constexpr int64_t W = 8;
+    static constexpr int MR = 2; // GEMM x rows per tile (8 of 16 ymm as accumulators)
+    static reg zero() { return _mm256_setzero_ps(); }
+    static reg set1(float v) { return _mm256_set1_ps(v); }
+    static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+    static float hsum(reg a) {
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_movehdup_ps(s));
+        return _mm_cvtss_f32(s);
+    }
+    static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+    static reg abs(reg a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static float hmax(reg a) {
+        __m128 s = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+        s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_max_ss(s, _mm_movehdup_ps(s));
+        return _mm_cvtss_f32(s);
+    }
+    static void store(float* p, reg a) { _mm256_storeu_ps(p, a); }
+    static void store_f16(uint16_t* p, reg a) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_cvtps_ph(a, _MM_FROUND_TO_NEAREST_INT));
+    }
+    // Lanes rounded to nearest even and saturated to int8
+    static void store_i8(int8_t* p, reg a) {
+        const __m256i q = _mm256_cvtps_epi32(a);
+        const __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi16(w, w));
+    }
+    // Lanes encoded as E4M3 codes, bit-identical to half::f32_to_e4m3
+    static void store_f8(uint8_t* p, reg a) {
+        const __m256 x = abs(a);
+        const __m256i b = _mm256_castps_si256(x);
+        const __m256i sign = _mm256_srli_epi32(_mm256_andnot_si256(b, _mm256_castps_si256(a)), 24);
+        const __m256i up = _mm256_add_epi32(_mm256_set1_epi32(kF8RoundBias),
+                                            _mm256_and_si256(_mm256_srli_epi32(b, 20), _mm256_set1_epi32(1)));
+        __m256i code = _mm256_sub_epi32(_mm256_srli_epi32(_mm256_add_epi32(b, up), 20), _mm256_set1_epi32(kF8Rebias));
+        code = _mm256_min_epi32(code, _mm256_set1_epi32(kF8MaxCode));
+        const __m256i sub = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(kF8SubnormalScale)));
+        const __m256i tiny = _mm256_castps_si256(_mm256_cmp_ps(x, _mm256_set1_ps(kF8MinNormal), _CMP_LT_OQ));
+        code = _mm256_or_si256(_mm256_blendv_epi8(code, sub, tiny), sign);
+        const __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(code), _mm256_extracti128_si256(code, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(w, w));
+    }
+
+    template <DType DT>
+    static reg load(const void* p, int64_t i) {
+        const auto* e = static_cast<const typename Elem<DT>::type*>(p) + i;
+        if constexpr (DT == DType::F32) {
+            return _mm256_loadu_ps(e);
+        } else if constexpr (DT == DType::I8) {
+            return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(e))));
+        } else if constexpr (DT == DType::F8) {
+            const __m128i w = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(e)));
+            const __m128i h = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(w, _mm_set1_epi16(0x80)), 8),
+                                           _mm_slli_epi16(_mm_and_si128(w, _mm_set1_epi16(0x7F)), 7));
+            return _mm256_mul_ps(_mm256_cvtph_ps(h), _mm256_set1_ps(kF8Rescale));
+        } else {
+            __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(e));
+            if constexpr (DT == DType::BF16) {
+                return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+            } else {
+                return _mm256_cvtph_ps(h);
+            }
+        }
+    }
+
+    // One Q4 block (32 nibbles in 16 bytes) -> elements 0..7, 8..15, 16..23, 24..31
+    static void q4_block(const uint8_t* b, reg (&q)[4]) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        const __m128i m = _mm_set1_epi8(0x0F);
+        const __m128i lo = _mm_and_si128(v, m);
+        const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), m);
+        q[0] = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(lo));
+        q[1] = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+        q[2] = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(hi));
+        q[3] = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+    }
+};
+#else
+// Scalar level: the tail loop in dot_rows does all the work.
+struct Vec {
+    using reg = float;
+    static constexpr int64_t W = 1;
+    static constexpr int MR = 1;
+    static reg zero() { return 0.0f; }
+    static reg set1(float v) { return v; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+    static float hsum(reg a) { return a; }
+    static reg max(reg a, reg b) { return a > b ? a : b; }
+    static reg abs(reg a) { return std::fabs(a); }
+    static float hmax(reg a) { return a; }
+    static void store(float* p, reg a) { *p = a; }
+    static void store_f16(uint16_t* p, reg a) { *p = half::f32_to_f16(a); }
+    static void store_i8(int8_t* p, reg a) { *p = static_cast<int8_t>(std::nearbyint(a)); }
+    static void store_f8(uint8_t* p, reg a) { *p = half::f32_to_e4m3(a); }
+    template <DType DT>
+    static reg load(const void* p, int64_t i) { return load_scalar<DT>(p, i); }
+    static void q4_block(const uint8_t* b, reg (&q)[32]) {
+        for (int i = 0; i < 16; ++i) {
+            q[i] = static_cast<float>(b[i] & 0x0F);
+            q[16 + i] = static_cast<float>(b[i] >> 4);
+        }
+    }
+};
+#endif
+
+} // namespace
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
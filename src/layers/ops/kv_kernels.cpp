@@ -0,0 +1,42 @@
+#include "kv_kernels.hpp"
+#include "linear_kernels.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+namespace {
+
+template <typename Fn>
+Fn pick(Fn const (&fns)[kKVTypes], DType dt) {
+    const auto i = static_cast<size_t>(dt);
+    if (i >= kKVTypes || !fns[i]) {
+        throw std::runtime_error(std::string("KV cache: unsupported dtype ") + dtype_name(dt));
+    }
+    return fns[i];
+}
+
+} // namespace
+
+const KVKernelTable& active_kv_table() {
+    // Follow the linear kernels' level, so IE_ISA / set_active_isa cover both
+    const KVKernelTable* t = nullptr;
+    switch (active_table().isa) {
+        case Isa::AVX512: t = kv_kernel_table_avx512(); break;
+        case Isa::AVX2: t = kv_kernel_table_avx2(); break;
+        case Isa::Scalar: break;
+    }
+    return t ? *t : *kv_kernel_table_scalar();
+}
+
+AttendTileFn select_attend_tile(DType dt) { return pick(active_kv_table().attend_tile, dt); }
+
+StoreRowFn select_store_row(DType dt) { return pick(active_kv_table().store_row, dt); }
+
+LoadRowFn select_load_row(DType dt) { return pick(active_kv_table().load_row, dt); }
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
@@ -0,0 +1,78 @@
+#pragma once
+#include "infer_engine/core/device.hpp"
+#include "infer_engine/core/types.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+/** Most query heads one attention tile scores against a loaded K/V row. */
+constexpr int64_t kMaxTileHeads = 16;
+
+/** Most cached positions in one attention tile. */
+constexpr int64_t kAttnTileRows = 64;
+
+/**
+ * One tile of decode / prefill attention: G query heads q [G, D] that share
+ * a KV head, against the cached rows rows[0, n) of the K and V stores. Row r
+ * of a store starts at base + r * dtype_nbytes(dt, D); the scales are the
+ * per-row scales of I8 / F8 stores and null otherwise.
+ */
+struct AttnTile {
+    const float* q = nullptr;
+    int64_t G = 0;
+    int64_t D = 0;
+    float scale = 1.0f;                  // 1 / sqrt(D)
+    const uint8_t* k = nullptr;
+    const uint8_t* v = nullptr;
+    const float* k_scales = nullptr;
+    const float* v_scales = nullptr;
+    const size_t* rows = nullptr;
+    int64_t n = 0;
+};
+
+/**
+ * Online-softmax step over one tile: per head g, the running max m[g] and sum
+ * l[g] absorb the tile's scores, acc [G, D] is rescaled by exp(m_old - m_new)
+ * and the tile's V rows are added with weights exp(s - m). acc stays
+ * unnormalized; the caller initializes m to -inf, l and acc to 0.
+ */
+using AttendTileFn = void (*)(const AttnTile& t, float* acc, float* m, float* l);
+
+/** Write one F32 head row of D values in the cache dtype; returns its scale (1 when unscaled). */
+using StoreRowFn = float (*)(const float* src, int64_t D, void* dst);
+
+/** Decode one cache row of D values to F32 (scale is ignored for F32 / F16). */
+using LoadRowFn = void (*)(const void* src, int64_t D, float scale, float* dst);
+
+/**
+ * One ISA level's KV kernels, indexed by the cache DType value (F32, F16, I8
+ * and F8 are filled in).
+ */
+constexpr size_t kKVTypes = 6;
+
+struct KVKernelTable {
+    Isa isa = Isa::Scalar;
+    AttendTileFn attend_tile[kKVTypes] = {};
+    StoreRowFn store_row[kKVTypes] = {};
+    LoadRowFn load_row[kKVTypes] = {};
+};
+
+/** Defined by the per-ISA TUs; null when that TU was built without its flags. */
+const KVKernelTable* kv_kernel_table_scalar();
+const KVKernelTable* kv_kernel_table_avx2();
+const KVKernelTable* kv_kernel_table_avx512();
+
+/** Table at the level of active_table() (falls back to scalar). */
+const KVKernelTable& active_kv_table();
+
+/** Pick the kernel for a KV cache dtype; throws for dtypes the cache does not store. */
+AttendTileFn select_attend_tile(DType dt);
+StoreRowFn select_store_row(DType dt);
+LoadRowFn select_load_row(DType dt);
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
@@ -0,0 +1,24 @@
+// AVX-512F KV kernels (compiled with -mavx512f -mavx2 -mfma -mf16c, see CMakeLists.txt).
+#include "kv_kernels.hpp"
+
+#if defined(IE_KERNELS_AVX512) && defined(__AVX512F__) && defined(__FMA__) && defined(__F16C__)
+#define IE_KERNEL_LEVEL 2
+#include "kv_kernels_impl.hpp"
+#endif
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+const KVKernelTable* kv_kernel_table_avx512() {
+#if defined(IE_KERNELS_AVX512) && defined(__AVX512F__) && defined(__FMA__) && defined(__F16C__)
+    static constexpr KVKernelTable table = make_kv_table(Isa::AVX512);
+    return &table;
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
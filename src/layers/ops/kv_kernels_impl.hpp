@@ -0,0 +1,252 @@
+#pragma once
+// KV cache kernel bodies shared by kv_kernels_{scalar,avx2,avx512}.cpp: the
+// attention tile and the row conversions between F32 and the cache dtypes.
+// Same rules as linear_kernels_impl.hpp: the including TU defines
+// IE_KERNEL_LEVEL and is compiled with the matching -m flags, and everything
+// here has internal linkage.
+#ifndef IE_KERNEL_LEVEL
+#error "define IE_KERNEL_LEVEL before including kv_kernels_impl.hpp"
+#endif
+
+#include "kv_kernels.hpp"
+#include "kernel_vec.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+namespace {
+
+// Register blocking of the tile kernel. Scores: heads whose dot products
+// accumulate side by side from one widened K chunk. Context: heads x vector
+// chunks of acc held in registers across all rows of a tile, each V chunk
+// widened once per head block. AVX-512 keeps two heads of D = 128 resident
+// (16 of 32 zmm); AVX2 covers four heads x 16 dims (8 of 16 ymm).
+#if IE_KERNEL_LEVEL == 2
+constexpr int kScoreHeads = 8;
+constexpr int kAccHeads = 2;
+constexpr int kAccChunks = 8;
+#elif IE_KERNEL_LEVEL == 1
+constexpr int kScoreHeads = 4;
+constexpr int kAccHeads = 4;
+constexpr int kAccChunks = 2;
+#else
+constexpr int kScoreHeads = 4;
+constexpr int kAccHeads = 4;
+constexpr int kAccChunks = 4;
+#endif
+
+// Calls f with std::integral_constant<int, n> for a runtime n in [1, N], so
+// partial blocks still get fixed-size register arrays
+template <int N, typename F>
+inline void dispatch_upto(int64_t n, F&& f) {
+    if constexpr (N > 1) {
+        if (n < N) {
+            dispatch_upto<N - 1>(n, f);
+            return;
+        }
+    }
+    f(std::integral_constant<int, N>{});
+}
+
+template <DType DT>
+constexpr size_t kv_row_bytes(int64_t D) {
+    return static_cast<size_t>(D) * sizeof(typename Elem<DT>::type);
+}
+
+// s[g0 + j][i] = scale * k_scale * dot(q[g0 + j], K row i) for j < GN
+template <DType DT, int GN>
+void score_heads(const AttnTile& t, int64_t g0, float (*s)[kAttnTileRows]) {
+    constexpr int64_t W = Vec::W;
+    const int64_t D = t.D, Dv = D / W * W;
+    const float* q = t.q + g0 * D;
+    for (int64_t i = 0; i < t.n; ++i) {
+        const size_t row = t.rows[i];
+        const void* kvec = t.k + row * kv_row_bytes<DT>(D);
+        Vec::reg a[GN];
+        for (int j = 0; j < GN; ++j) a[j] = Vec::zero();
+        for (int64_t d = 0; d < Dv; d += W) {
+            const Vec::reg k = Vec::load<DT>(kvec, d);
+            for (int j = 0; j < GN; ++j) a[j] = Vec::fmadd(Vec::load<DType::F32>(q + j * D, d), k, a[j]);
+        }
+        const float row_scale = t.scale * (t.k_scales ? t.k_scales[row] : 1.0f);
+        for (int j = 0; j < GN; ++j) {
+            float dot = Vec::hsum(a[j]);
+            for (int64_t d = Dv; d < D; ++d) dot += q[j * D + d] * load_scalar<DT>(kvec, d);
+            s[g0 + j][i] = dot * row_scale;
+        }
+    }
+}
+
+// acc[g0 + j][d0, d0 + CN * W) += sum_i w[g0 + j][i] * V row i, for j < GN,
+// with the block of acc in registers for the whole tile
+template <DType DT, int GN, int CN>
+void accumulate_block(const AttnTile& t, const float (*w)[kAttnTileRows], int64_t g0, int64_t d0, float* acc) {
+    constexpr int64_t W = Vec::W;
+    const int64_t D = t.D;
+    Vec::reg a[GN][CN];
+    for (int j = 0; j < GN; ++j) {
+        for (int c = 0; c < CN; ++c) a[j][c] = Vec::load<DType::F32>(acc + (g0 + j) * D, d0 + c * W);
+    }
+    for (int64_t i = 0; i < t.n; ++i) {
+        const void* vvec = t.v + t.rows[i] * kv_row_bytes<DT>(D);
+        Vec::reg v[CN];
+        for (int c = 0; c < CN; ++c) v[c] = Vec::load<DT>(vvec, d0 + c * W);
+        for (int j = 0; j < GN; ++j) {
+            const Vec::reg wj = Vec::set1(w[g0 + j][i]);
+            for (int c = 0; c < CN; ++c) a[j][c] = Vec::fmadd(wj, v[c], a[j][c]);
+        }
+    }
+    for (int j = 0; j < GN; ++j) {
+        for (int c = 0; c < CN; ++c) Vec::store(acc + (g0 + j) * D + d0 + c * W, a[j][c]);
+    }
+}
+
+template <DType DT>
+void attend_tile(const AttnTile& t, float* acc, float* m, float* l) {
+    constexpr int64_t W = Vec::W;
+    const int64_t G = t.G, D = t.D, n = t.n;
+    const int64_t Dv = D / W * W;
+    float s[kMaxTileHeads][kAttnTileRows];
+
+    for (int64_t g0 = 0; g0 < G; g0 += kScoreHeads) {
+        dispatch_upto<kScoreHeads>(std::min<int64_t>(kScoreHeads, G - g0),
+                                   [&](auto gn) { score_heads<DT, decltype(gn)::value>(t, g0, s); });
+    }
+
+    // Online softmax update; the scores become the V weights, with the
+    // per-row V scale folded in
+    float v_scale[kAttnTileRows];
+    for (int64_t i = 0; i < n; ++i) v_scale[i] = t.v_scales ? t.v_scales[t.rows[i]] : 1.0f;
+    for (int64_t g = 0; g < G; ++g) {
+        float tile_max = m[g];
+        for (int64_t i = 0; i < n; ++i) tile_max = std::max(tile_max, s[g][i]);
+        if (tile_max > m[g]) {
+            // New running max: shrink what was accumulated under the old one
+            const float corr = std::exp(m[g] - tile_max);
+            l[g] *= corr;
+            float* ag = acc + g * D;
+            const Vec::reg vc = Vec::set1(corr);
+            for (int64_t d = 0; d < Dv; d += W) Vec::store(ag + d, Vec::mul(Vec::load<DType::F32>(ag, d), vc));
+            for (int64_t d = Dv; d < D; ++d) ag[d] *= corr;
+            m[g] = tile_max;
+        }
+        for (int64_t i = 0; i < n; ++i) {
+            const float e = std::exp(s[g][i] - m[g]);
+            l[g] += e;
+            s[g][i] = e * v_scale[i];
+        }
+    }
+
+    const int64_t C = Dv / W;
+    for (int64_t g0 = 0; g0 < G; g0 += kAccHeads) {
+        dispatch_upto<kAccHeads>(std::min<int64_t>(kAccHeads, G - g0), [&](auto gn) {
+            for (int64_t c0 = 0; c0 < C; c0 += kAccChunks) {
+                dispatch_upto<kAccChunks>(std::min<int64_t>(kAccChunks, C - c0), [&](auto cn) {
+                    accumulate_block<DT, decltype(gn)::value, decltype(cn)::value>(t, s, g0, c0 * W, acc);
+                });
+            }
+        });
+    }
+    // Dims past the last whole vector
+    for (int64_t i = 0; i < n && Dv < D; ++i) {
+        const void* vvec = t.v + t.rows[i] * kv_row_bytes<DT>(D);
+        for (int64_t d = Dv; d < D; ++d) {
+            const float v = load_scalar<DT>(vvec, d);
+            for (int64_t g = 0; g < G; ++g) acc[g * D + d] += s[g][i] * v;
+        }
+    }
+}
+
+// Scalar encoders for the tails of a row that is not a whole number of vectors
+inline uint16_t f16_code(float v) {
+#if IE_KERNEL_LEVEL >= 1
+    return _cvtss_sh(v, _MM_FROUND_TO_NEAREST_INT);
+#else
+    return half::f32_to_f16(v);
+#endif
+}
+
+inline uint8_t f8_code(float v) {
+    const float a = std::fabs(v);
+    uint32_t b;
+    std::memcpy(&b, &a, sizeof(b));
+    const uint32_t sign = std::signbit(v) ? 0x80u : 0u;
+    if (a < kF8MinNormal) return static_cast<uint8_t>(sign | static_cast<uint32_t>(std::nearbyint(a * kF8SubnormalScale)));
+    const int32_t code = static_cast<int32_t>((b + kF8RoundBias + ((b >> 20) & 1u)) >> 20) - kF8Rebias;
+    return static_cast<uint8_t>(sign | static_cast<uint32_t>(std::min(code, kF8MaxCode)));
+}
+
+template <DType DT>
+float store_row(const float* src, int64_t D, void* dst) {
+    constexpr int64_t W = Vec::W;
+    const int64_t Dv = (W > 1) ? D / W * W : 0;
+    if constexpr (DT == DType::F32) {
+        std::memcpy(dst, src, static_cast<size_t>(D) * sizeof(float));
+        return 1.0f;
+    } else if constexpr (DT == DType::F16) {
+        auto* d16 = static_cast<uint16_t*>(dst);
+        for (int64_t d = 0; d < Dv; d += W) Vec::store_f16(d16 + d, Vec::load<DType::F32>(src, d));
+        for (int64_t d = Dv; d < D; ++d) d16[d] = f16_code(src[d]);
+        return 1.0f;
+    } else {
+        // Symmetric per-row scale: amax maps to the largest code (127 / 448)
+        Vec::reg vmax = Vec::zero();
+        for (int64_t d = 0; d < Dv; d += W) vmax = Vec::max(vmax, Vec::abs(Vec::load<DType::F32>(src, d)));
+        float amax = (Dv > 0) ? Vec::hmax(vmax) : 0.0f;
+        for (int64_t d = Dv; d < D; ++d) amax = std::max(amax, std::fabs(src[d]));
+        const float qmax = (DT == DType::I8) ? 127.0f : 448.0f;
+        const float inv = (amax > 0.0f) ? qmax / amax : 0.0f;
+        const Vec::reg vinv = Vec::set1(inv);
+        if constexpr (DT == DType::I8) {
+            auto* q = static_cast<int8_t*>(dst);
+            for (int64_t d = 0; d < Dv; d += W) Vec::store_i8(q + d, Vec::mul(Vec::load<DType::F32>(src, d), vinv));
+            for (int64_t d = Dv; d < D; ++d) {
+                q[d] = static_cast<int8_t>(std::clamp(std::nearbyint(src[d] * inv), -127.0f, 127.0f));
+            }
+        } else {
+            auto* q = static_cast<uint8_t*>(dst);
+            for (int64_t d = 0; d < Dv; d += W) Vec::store_f8(q + d, Vec::mul(Vec::load<DType::F32>(src, d), vinv));
+            for (int64_t d = Dv; d < D; ++d) q[d] = f8_code(src[d] * inv);
+        }
+        return amax / qmax;
+    }
+}
+
+template <DType DT>
+void load_row(const void* src, int64_t D, float scale, float* dst) {
+    constexpr int64_t W = Vec::W;
+    const int64_t Dv = (W > 1) ? D / W * W : 0;
+    const float s = (DT == DType::I8 || DT == DType::F8) ? scale : 1.0f;
+    const Vec::reg vs = Vec::set1(s);
+    for (int64_t d = 0; d < Dv; d += W) Vec::store(dst + d, Vec::mul(vs, Vec::load<DT>(src, d)));
+    for (int64_t d = Dv; d < D; ++d) dst[d] = s * load_scalar<DT>(src, d);
+}
+
+template <DType DT>
+constexpr void fill_kv(KVKernelTable& t) {
+    const auto i = static_cast<size_t>(DT);
+    t.attend_tile[i] = &attend_tile<DT>;
+    t.store_row[i] = &store_row<DT>;
+    t.load_row[i] = &load_row<DT>;
+}
+
+constexpr KVKernelTable make_kv_table(Isa isa) {
+    KVKernelTable t{};
+    t.isa = isa;
+    fill_kv<DType::F32>(t);
+    fill_kv<DType::F16>(t);
+    fill_kv<DType::I8>(t);
+    fill_kv<DType::F8>(t);
+    return t;
+}
+
+} // namespace
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
@@ -0,0 +1,16 @@
+// Scalar KV kernels, built for the baseline target; always available.
+#define IE_KERNEL_LEVEL 0
+#include "kv_kernels_impl.hpp"
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+const KVKernelTable* kv_kernel_table_scalar() {
+    static constexpr KVKernelTable table = make_kv_table(Isa::Scalar);
+    return &table;
+}
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
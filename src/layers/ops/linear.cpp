@@ -1,97 +1,586 @@
 #include "infer_engine/layers/ops/linear.hpp"
 #include "infer_engine/core/tensor.hpp"
-#include <cassert>
+#include "infer_engine/core/half.hpp"
+#include "infer_engine/core/thread_pool.hpp"
+#include "linear_kernels.hpp"
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
-#ifdef IE_OMP
-#include <omp.h>
-#endif
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace ie {
 namespace ops {
 
-static inline float bf16_to_f32(uint16_t h) {
-    union { uint32_t u; float f; } out;
-    out.u = static_cast<uint32_t>(h) << 16;
-    return out.f;
-}
-
-static inline float f16_to_f32(uint16_t h) {
-    uint32_t sign = (h & 0x8000) << 16;
-    uint32_t exp = (h & 0x7C00) >> 10;
-    uint32_t mant = (h & 0x03FF);
-    uint32_t f;
-    if (exp == 0) {
-        if (mant == 0) { f = sign; }
-        else {
-            exp = 127 - 15 + 1;
-            while ((mant & 0x0400) == 0) { mant <<= 1; exp--; }
-            mant &= 0x03FF;
-            f = sign | (exp << 23) | (mant << 13);
+static kernels::WeightArg weight_arg(const TensorView& W) {
+    kernels::WeightArg w;
+    w.data = W.data;
+    w.D_in = W.shape[1];
+    w.packed = (W.layout == Layout::PackedPanels);
+    if (w.packed && W.pack_k != kernels::packed_k()) {
+        // Panels interleave chunks of the depth the kernels had when packing
+        throw std::runtime_error("linear: weight packed with panel depth " + std::to_string(W.pack_k) +
+                                 " but the active kernels use " + std::to_string(kernels::packed_k()) +
+                                 "; repack after changing the ISA");
+    }
+    if (W.dt == DType::I8 || W.dt == DType::Q4) {
+        if (!W.quant.defined()) throw std::invalid_argument("linear: quantized weight has no scales");
+        w.scales = W.quant.scales;
+        w.zeros = W.quant.zeros;
+        w.group_size = W.quant.group_size;
+    }
+    return w;
+}
+
+// View of rows [j0, ...) of W as the kernels see it (j0 a multiple of the
+// panel height when W is packed)
+static kernels::WeightArg offset_rows(const kernels::WeightArg& w, DType dt, int64_t j0) {
+    kernels::WeightArg r = w;
+    r.data = static_cast<const uint8_t*>(w.data) + dtype_nbytes(dt, j0 * w.D_in);
+    const int64_t per_row = (dt == DType::Q4) ? w.D_in / w.group_size : 1;
+    if (r.scales) r.scales += j0 * per_row;
+    if (r.zeros) r.zeros += j0 * per_row;
+    return r;
+}
+
+// Row i of x as F32 (rows of other dtypes are converted into buf)
+static const float* x_row_f32(const TensorView& x, int64_t i, int64_t D_in, std::vector<float>& buf) {
+    const auto* p = static_cast<const uint8_t*>(x.data) + static_cast<size_t>(i * D_in) * x.itemsize();
+    if (x.dt == DType::F32) return reinterpret_cast<const float*>(p);
+    Tensor f = astype_copy(make_view(const_cast<uint8_t*>(p), x.dt, {D_in}), DType::F32);
+    buf.assign(f.view.ptr<float>(), f.view.ptr<float>() + D_in);
+    return buf.data();
+}
+
+// x / smooth as F32, for weights with SmoothQuant scales folded in
+static Tensor smoothed_input(const TensorView& x, int64_t N, int64_t D_in, const float* smooth) {
+    Tensor xs = Tensor::empty({N, D_in}, DType::F32);
+    float* dst = xs.view.ptr<float>();
+    parallel_for(N, [&](int64_t i) {
+        std::vector<float> buf;
+        const float* src = x_row_f32(x, i, D_in, buf);
+        for (int64_t k = 0; k < D_in; ++k) dst[i * D_in + k] = src[k] / smooth[k];
+    });
+    return xs;
+}
+
+static bool use_int8_activations(const TensorView& W) {
+    return W.dt == DType::I8 && W.quant.dynamic_act && W.layout == Layout::RowMajor;
+}
+
+// x as the kernels for one weight consume it: the rows themselves, x / smooth
+// (SmoothQuant), or int8 rows with one scale each (W8A8), with the kernels
+// for that pairing selected once
+struct KernelInput {
+    const void* x = nullptr;
+    DType dt = DType::F32;
+    Tensor smoothed;
+    std::vector<int8_t> xq;
+    std::vector<float> xs;
+    kernels::GemvFn gemv = nullptr;
+    kernels::GemmFn gemm = nullptr;
+    kernels::GemmI8Fn gemm_i8 = nullptr;   // set for W8A8
+};
+
+// W8A8: quantize every row of x (divided by the smooth scales, if any) to
+// int8 with scale max|x| / 127
+static void quantize_rows(const TensorView& x, int64_t N, int64_t D_in, const float* smooth,
+                          std::vector<int8_t>& xq, std::vector<float>& xs) {
+    xq.resize(static_cast<size_t>(N * D_in));
+    xs.resize(static_cast<size_t>(N));
+    parallel_for(N, [&](int64_t i) {
+        std::vector<float> buf;
+        const float* src = x_row_f32(x, i, D_in, buf);
+        float amax = 0.0f;
+        for (int64_t k = 0; k < D_in; ++k) amax = std::max(amax, std::fabs(smooth ? src[k] / smooth[k] : src[k]));
+        const float scale = amax > 0.0f ? amax / 127.0f : 1.0f;
+        const float inv = 1.0f / scale;
+        int8_t* q = xq.data() + i * D_in;
+        for (int64_t k = 0; k < D_in; ++k) {
+            const float v = std::nearbyint((smooth ? src[k] / smooth[k] : src[k]) * inv);
+            q[k] = static_cast<int8_t>(std::max(-127.0f, std::min(127.0f, v)));
         }
-    } else if (exp == 0x1F) {
-        f = sign | 0x7F800000 | (mant << 13);
+        xs[static_cast<size_t>(i)] = scale;
+    });
+}
+
+static KernelInput kernel_input(const TensorView& x, const TensorView& W, int64_t N, int64_t D_in) {
+    KernelInput in;
+    if (use_int8_activations(W)) {
+        quantize_rows(x, N, D_in, W.quant.smooth, in.xq, in.xs);
+        in.gemm_i8 = kernels::select_gemm_i8();
+        return in;
+    }
+    if (W.quant.smooth) {
+        in.smoothed = smoothed_input(x, N, D_in, W.quant.smooth);
+        in.x = in.smoothed.view.data;
+    } else {
+        in.x = x.data;
+        in.dt = x.dt;
+    }
+    if (N == 1) {
+        in.gemv = kernels::select_gemv(in.dt, W.dt);
     } else {
-        exp = exp - 15 + 127;
-        f = sign | (exp << 23) | (mant << 13);
+        in.gemm = kernels::select_gemm(in.dt, W.dt);
     }
-    union { uint32_t u; float f; } out{f};
-    return out.f;
+    return in;
 }
 
-Tensor linear(const TensorView& x, const TensorView& W, const TensorView* bias) {
+// y[i, j] = ep(x[i] . W[j]) for j in [j0, j1), y rows ldy floats apart
+static void project_rows(const KernelInput& in, const kernels::WeightArg& w, float* y, int64_t N,
+                         int64_t j0, int64_t j1, int64_t ldy, const kernels::Epilogue& ep) {
+    if (in.gemm_i8) {
+        in.gemm_i8(in.xq.data(), in.xs.data(), w, y, N, j0, j1, ldy, ep);
+    } else if (in.gemv) {
+        in.gemv(in.x, w, y, j0, j1, ep);
+    } else {
+        in.gemm(in.x, w, y, N, j0, j1, ldy, ep);
+    }
+}
+
+void linear_into(const TensorView& x_in, const TensorView& W, const TensorView& out, const LinearEpilogue& ep) {
     // x: [N, D_in] or [D_in]
     // W: [D_out, D_in]
-    int64_t N = (x.shape.size() == 1) ? 1 : x.shape[0];
-    int64_t D_in = (x.shape.size() == 1) ? x.shape[0] : x.shape[1];
-    assert(W.shape.size() == 2 && "W must be rank-2 [D_out, D_in]");
+    int64_t N = (x_in.shape.size() == 1) ? 1 : x_in.shape[0];
+    int64_t D_in = (x_in.shape.size() == 1) ? x_in.shape[0] : x_in.shape[1];
+    if (W.shape.size() != 2 || W.shape[1] != D_in) {
+        throw std::invalid_argument("linear_into: expects x [N, D_in] and W [D_out, D_in]");
+    }
     int64_t D_out = W.shape[0];
-    int64_t W_Din = W.shape[1];
-    assert(W_Din == D_in && "W.shape[1] must equal D_in");
+    if (out.dt != DType::F32 || out.numel() != N * D_out) {
+        throw std::invalid_argument("linear_into: out must be F32 with N * D_out elements");
+    }
 
     // Always accumulate/output in F32
-    auto output = Tensor::empty({N, D_out}, DType::F32);
-    float* y = output.view.ptr<float>();
-
-    // Read x as F32 (convert if needed per element)
-    auto load_x = [&](int64_t idx) -> float {
-        if (x.dt == DType::F32) return x.ptr<const float>()[idx];
-        if (x.dt == DType::BF16) return bf16_to_f32(x.ptr<const uint16_t>()[idx]);
-        if (x.dt == DType::F16) return f16_to_f32(x.ptr<const uint16_t>()[idx]);
-        // Default, treat as F32
-        return x.ptr<const float>()[idx];
-    };
+    float* y = static_cast<float*>(out.data);
+    const kernels::WeightArg w = weight_arg(W);
 
-    // Read W row element, dt-aware
-    auto load_w = [&](int64_t row, int64_t col) -> float {
-        if (W.dt == DType::F32) return W.ptr<const float>()[row * W_Din + col];
-        if (W.dt == DType::BF16) return bf16_to_f32(W.ptr<const uint16_t>()[row * W_Din + col]);
-        if (W.dt == DType::F16) return f16_to_f32(W.ptr<const uint16_t>()[row * W_Din + col]);
-        return W.ptr<const float>()[row * W_Din + col];
-    };
+    kernels::Epilogue kep;
+    kep.bias = ep.bias ? ep.bias->ptr<const float>() : nullptr; // bias assumed F32
+    kep.scale = ep.scale;
+    kep.accumulate = ep.accumulate;
 
-    for (int64_t i = 0; i < N; ++i) {
-        #ifdef IE_OMP
-        #pragma omp parallel for schedule(static)
-        #endif
-        for (int64_t j = 0; j < D_out; ++j) {
-            float acc = 0.0f;
-            for (int64_t k = 0; k < D_in; ++k) {
-                float xv = load_x((x.shape.size() == 1) ? k : i * D_in + k);
-                float wv = load_w(j, k);
-                acc += xv * wv;
+    // One kernel per call, specialized for the (x, W) dtype pair
+    const KernelInput in = kernel_input(x_in, W, N, D_in);
+
+    // Rows of W handed to one kernel invocation (multiple of its 4-row panel).
+    // GEMM blocks are taller so each thread's W panel is reused across more
+    // columns of output while it is still in L2; the GEMM runs as one
+    // parallel region with W panels reused across all N rows.
+    const int64_t row_block = (N == 1) ? 16 : 64;
+    const int64_t n_blocks = (D_out + row_block - 1) / row_block;
+    parallel_for(n_blocks, [&](int64_t b) {
+        const int64_t j0 = b * row_block;
+        const int64_t j1 = (j0 + row_block < D_out) ? j0 + row_block : D_out;
+        project_rows(in, w, y, N, j0, j1, D_out, kep);
+    });
+}
+
+Tensor linear(const TensorView& x, const TensorView& W, const TensorView* bias) {
+    const int64_t N = (x.shape.size() == 1) ? 1 : x.shape[0];
+    auto output = Tensor::empty({N, W.shape[0]}, DType::F32);
+    LinearEpilogue ep;
+    ep.bias = bias;
+    linear_into(x, W, output.view, ep);
+    return output;
+}
+
+Isa linear_isa() { return kernels::active_table().isa; }
+
+void set_linear_isa(Isa isa) { kernels::set_active_isa(isa); }
+
+// Orders candidates best-first; a heap under this comparator keeps the worst
+// surviving candidate at its front
+static bool topk_better(const TopKEntry& a, const TopKEntry& b) {
+    return a.value > b.value || (a.value == b.value && a.id < b.id);
+}
+
+std::vector<TopKEntry> linear_topk(const TensorView& x_in, const TensorView& W, int64_t k) {
+    const int64_t N = (x_in.shape.size() == 1) ? 1 : x_in.shape[0];
+    const int64_t D_in = x_in.shape.back();
+    if (N != 1 || W.shape.size() != 2 || W.shape[1] != D_in) {
+        throw std::invalid_argument("linear_topk: expects x [1, D_in] and W [D_out, D_in]");
+    }
+    Tensor x_smoothed;
+    if (W.quant.smooth) x_smoothed = smoothed_input(x_in, 1, D_in, W.quant.smooth);
+    const TensorView& x = W.quant.smooth ? x_smoothed.view : x_in;
+    const int64_t D_out = W.shape[0];
+    k = std::max<int64_t>(1, std::min(k, D_out));
+
+    const kernels::GemvFn gemv = kernels::select_gemv(x.dt, W.dt);
+    const kernels::WeightArg w = weight_arg(W);
+
+    // Each task scores one slice of rows into a stack buffer and keeps its
+    // own top-k; the slice is a multiple of the packed panel height so the
+    // shifted weight pointer stays panel aligned.
+    constexpr int64_t kSliceRows = 256;
+    static_assert(kSliceRows % kernels::kPackRows == 0, "slice must cover whole panels");
+    const int64_t n_slices = (D_out + kSliceRows - 1) / kSliceRows;
+    std::vector<std::vector<TopKEntry>> partial(static_cast<size_t>(n_slices));
+
+    parallel_for(n_slices, [&](int64_t s) {
+        const int64_t j0 = s * kSliceRows;
+        const int64_t rows = std::min(kSliceRows, D_out - j0);
+        const kernels::WeightArg ws = offset_rows(w, W.dt, j0);
+        float buf[kSliceRows];
+        gemv(x.data, ws, buf, 0, rows, kernels::Epilogue{});
+
+        std::vector<TopKEntry>& heap = partial[static_cast<size_t>(s)];
+        heap.reserve(static_cast<size_t>(std::min(k, rows)));
+        for (int64_t r = 0; r < rows; ++r) {
+            const TopKEntry e{static_cast<int32_t>(j0 + r), buf[r]};
+            if (static_cast<int64_t>(heap.size()) < k) {
+                heap.push_back(e);
+                std::push_heap(heap.begin(), heap.end(), topk_better);
+            } else if (topk_better(e, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), topk_better);
+                heap.back() = e;
+                std::push_heap(heap.begin(), heap.end(), topk_better);
             }
-            y[i * D_out + j] = acc;
         }
+    });
+
+    std::vector<TopKEntry> out;
+    out.reserve(static_cast<size_t>(n_slices * k));
+    for (const auto& p : partial) out.insert(out.end(), p.begin(), p.end());
+    std::partial_sort(out.begin(), out.begin() + k, out.end(), topk_better);
+    out.resize(static_cast<size_t>(k));
+    return out;
+}
+
+// Per-thread scratch for one block of gate values; grown on demand and kept
+// for later calls, so the gated GEMM allocates nothing per call
+static float* gate_scratch(int64_t n) {
+    thread_local std::vector<float> buf;
+    if (static_cast<int64_t>(buf.size()) < n) buf.resize(static_cast<size_t>(n));
+    return buf.data();
+}
+
+void gated_linear_into(const TensorView& x, const TensorView& W_gate, const TensorView& W_up,
+                       Activation act, const TensorView& out) {
+    const int64_t N = (x.shape.size() == 1) ? 1 : x.shape[0];
+    const int64_t D_in = x.shape.back();
+    if (W_gate.shape.size() != 2 || W_up.shape != W_gate.shape || W_gate.shape[1] != D_in) {
+        throw std::invalid_argument("gated_linear: W_gate/W_up must both be [D_ff, D_in]");
     }
+    if (W_gate.dt != W_up.dt || W_gate.layout != W_up.layout || W_gate.quant.group_size != W_up.quant.group_size) {
+        throw std::invalid_argument("gated_linear: W_gate/W_up must share dtype, layout and quantization groups");
+    }
+    const int64_t D_ff = W_gate.shape[0];
+    if (out.dt != DType::F32 || out.numel() != N * D_ff) {
+        throw std::invalid_argument("gated_linear: out must be F32 with N * D_ff elements");
+    }
+    float* h = static_cast<float*>(out.data);
+    const kernels::WeightArg wg = weight_arg(W_gate);
+    const kernels::WeightArg wu = weight_arg(W_up);
 
-    if (bias) {
-        // Bias assumed F32
-        const float* b = bias->ptr<const float>();
+    const int64_t row_block = (N == 1) ? 16 : 64;
+    const int64_t n_blocks = (D_ff + row_block - 1) / row_block;
+
+    // Smoothed or W8A8 weights scale the input per weight
+    const bool scaled_input = W_gate.quant.smooth || W_up.quant.smooth || use_int8_activations(W_gate) ||
+                              use_int8_activations(W_up);
+    if (N == 1 && !scaled_input) {
+        const kernels::GatedGemvFn gated = kernels::select_gated_gemv(x.dt, W_gate.dt);
+        parallel_for(n_blocks, [&](int64_t b) {
+            const int64_t j0 = b * row_block;
+            const int64_t j1 = (j0 + row_block < D_ff) ? j0 + row_block : D_ff;
+            gated(x.data, wg, wu, h, j0, j1, act);
+        });
+        return;
+    }
+
+    // Per column block: gate rows [j0, j1) into a per-thread [N, j1 - j0]
+    // buffer, up straight into h, then the epilogue while both are in cache
+    const KernelInput in_gate = kernel_input(x, W_gate, N, D_in);
+    const KernelInput in_up = kernel_input(x, W_up, N, D_in);
+    parallel_for(n_blocks, [&](int64_t b) {
+        const int64_t j0 = b * row_block;
+        const int64_t j1 = (j0 + row_block < D_ff) ? j0 + row_block : D_ff;
+        const int64_t rows = j1 - j0;
+        float* g = gate_scratch(N * rows);
+        project_rows(in_gate, offset_rows(wg, W_gate.dt, j0), g, N, 0, rows, rows, kernels::Epilogue{});
+        project_rows(in_up, wu, h, N, j0, j1, D_ff, kernels::Epilogue{});
         for (int64_t i = 0; i < N; ++i) {
-            for (int64_t j = 0; j < D_out; ++j) y[i * D_out + j] += b[j];
+            for (int64_t j = 0; j < rows; ++j) {
+                h[i * D_ff + j0 + j] *= kernels::apply_activation(g[i * rows + j], act);
+            }
         }
+    });
+}
+
+Tensor gated_linear(const TensorView& x, const TensorView& W_gate, const TensorView& W_up, Activation act) {
+    const int64_t N = (x.shape.size() == 1) ? 1 : x.shape[0];
+    Tensor out = Tensor::empty({N, W_gate.shape[0]}, DType::F32);
+    gated_linear_into(x, W_gate, W_up, act, out.view);
+    return out;
+}
+
+bool can_pack_weight(const TensorView& W) {
+    if (W.shape.size() != 2 || W.layout != Layout::RowMajor || !W.is_contiguous()) return false;
+    if (W.dt != DType::F32 && W.dt != DType::F16 && W.dt != DType::BF16 && W.dt != DType::I8) return false;
+    if (W.quant.dynamic_act) return false;
+    return W.shape[1] % kernels::packed_k() == 0;
+}
+
+size_t packed_weight_bytes(const TensorView& W) {
+    const int64_t rows = (W.shape[0] + kernels::kPackRows - 1) / kernels::kPackRows * kernels::kPackRows;
+    return static_cast<size_t>(rows) * static_cast<size_t>(W.shape[1]) * W.itemsize();
+}
+
+TensorView pack_weight(const TensorView& W, void* dst) {
+    if (!can_pack_weight(W)) {
+        throw std::invalid_argument("pack_weight: W must be a row-major [D_out, D_in] float matrix "
+                                    "with D_in a multiple of the kernel panel depth");
+    }
+    kernels::pack_panels(W.data, W.itemsize(), W.shape[0], W.shape[1], dst);
+    TensorView v = make_view(dst, W.dt, W.shape);
+    v.layout = Layout::PackedPanels;
+    v.pack_k = kernels::packed_k();
+    v.quant = W.quant;
+    return v;
+}
+
+static size_t align64(size_t n) { return (n + 63) / 64 * 64; }
+
+// Buffer layout of a quantized weight: values | scales | zeros | smooth, each
+// section cache-line aligned
+struct QuantLayout {
+    size_t values = 0, scales = 0, zeros = 0, smooth = 0, total = 0;
+    int64_t groups_per_row = 1;
+};
+
+static QuantLayout quant_layout(const TensorView& W, const QuantScheme& scheme) {
+    const int64_t D_out = W.shape[0], D_in = W.shape[1];
+    QuantLayout l;
+    l.groups_per_row = (scheme.dt == DType::Q4) ? D_in / scheme.group_size : 1;
+    const size_t n_scales = static_cast<size_t>(D_out * l.groups_per_row) * sizeof(float);
+    l.scales = align64(dtype_nbytes(scheme.dt, D_out * D_in));
+    l.zeros = l.scales + align64(n_scales);
+    l.smooth = l.zeros + align64((scheme.dt == DType::Q4 && scheme.zero_points) ? n_scales : 0);
+    l.total = l.smooth + (scheme.smooth ? static_cast<size_t>(D_in) * sizeof(float) : 0);
+    return l;
+}
+
+bool can_quantize_weight(const TensorView& W, const QuantScheme& scheme) {
+    if (W.shape.size() != 2 || W.layout != Layout::RowMajor || !W.is_contiguous()) return false;
+    if (W.dt != DType::F32 && W.dt != DType::F16 && W.dt != DType::BF16) return false;
+    if (scheme.dt == DType::I8) return true;
+    if (scheme.dt != DType::Q4 || scheme.smooth) return false;
+    const int64_t G = scheme.group_size, D_in = W.shape[1];
+    return G > 0 && G % 32 == 0 && D_in % G == 0 && D_in / G <= kernels::kQ4MaxGroupsPerRow;
+}
+
+size_t quantized_weight_bytes(const TensorView& W, const QuantScheme& scheme) {
+    if (scheme.dt != DType::I8 && scheme.dt != DType::Q4) {
+        throw std::invalid_argument("quantize_weight: unsupported target dtype");
+    }
+    return quant_layout(W, scheme).total;
+}
+
+TensorView quantize_weight(const TensorView& W, const QuantScheme& scheme, void* dst) {
+    if (!can_quantize_weight(W, scheme)) {
+        throw std::invalid_argument("quantize_weight: W must be a row-major F32/F16/BF16 [D_out, D_in] matrix; "
+                                    "targets are I8 (optionally smoothed), or Q4 with a group size that is a "
+                                    "multiple of 32 dividing D_in");
+    }
+    const int64_t D_out = W.shape[0], D_in = W.shape[1];
+    const QuantLayout l = quant_layout(W, scheme);
+    auto* base = static_cast<uint8_t*>(dst);
+    auto* scales = reinterpret_cast<float*>(base + l.scales);
+    auto* zeros = (scheme.dt == DType::Q4 && scheme.zero_points) ? reinterpret_cast<float*>(base + l.zeros) : nullptr;
+
+    Tensor row = Tensor::empty({D_in}, DType::F32);
+    float* rf = row.view.ptr<float>();
+    for (int64_t j = 0; j < D_out; ++j) {
+        TensorView src = make_view(static_cast<uint8_t*>(W.data) + static_cast<size_t>(j * D_in) * W.itemsize(), W.dt, {D_in});
+        if (W.dt == DType::F32) {
+            std::memcpy(rf, src.data, static_cast<size_t>(D_in) * sizeof(float));
+        } else {
+            Tensor f = astype_copy(src, DType::F32);
+            std::memcpy(rf, f.view.data, static_cast<size_t>(D_in) * sizeof(float));
+        }
+        if (scheme.smooth) {
+            for (int64_t k = 0; k < D_in; ++k) rf[k] *= scheme.smooth[k];
+        }
+
+        if (scheme.dt == DType::I8) {
+            // Symmetric per-output-channel: scale = max|w| / 127, q = round(w / scale)
+            float amax = 0.0f;
+            for (int64_t k = 0; k < D_in; ++k) amax = std::max(amax, std::fabs(rf[k]));
+            const float scale = amax > 0.0f ? amax / 127.0f : 1.0f;
+            const float inv = 1.0f / scale;
+            int8_t* qr = reinterpret_cast<int8_t*>(base) + j * D_in;
+            for (int64_t k = 0; k < D_in; ++k) {
+                const float v = std::nearbyint(rf[k] * inv);
+                qr[k] = static_cast<int8_t>(std::max(-127.0f, std::min(127.0f, v)));
+            }
+            scales[j] = scale;
+            continue;
+        }
+
+        // Q4 per group: symmetric (q - 8) * s with s = max|w| / 7, or with a
+        // zero point spanning [min, max] in 16 levels
+        const int64_t G = scheme.group_size;
+        uint8_t* qr = base + static_cast<size_t>(j * D_in) / 2;
+        std::memset(qr, 0, static_cast<size_t>(D_in) / 2);
+        for (int64_t g = 0; g < l.groups_per_row; ++g) {
+            const float* wg = rf + g * G;
+            float scale, zero;
+            if (zeros) {
+                float lo = 0.0f, hi = 0.0f; // range always includes 0
+                for (int64_t k = 0; k < G; ++k) { lo = std::min(lo, wg[k]); hi = std::max(hi, wg[k]); }
+                scale = hi > lo ? (hi - lo) / 15.0f : 1.0f;
+                zero = std::max(0.0f, std::min(15.0f, std::nearbyint(-lo / scale)));
+                zeros[j * l.groups_per_row + g] = zero;
+            } else {
+                float amax = 0.0f;
+                for (int64_t k = 0; k < G; ++k) amax = std::max(amax, std::fabs(wg[k]));
+                scale = amax > 0.0f ? amax / 7.0f : 1.0f;
+                zero = 8.0f;
+            }
+            scales[j * l.groups_per_row + g] = scale;
+            const float inv = 1.0f / scale;
+            for (int64_t k = g * G; k < (g + 1) * G; ++k) {
+                const float v = std::max(0.0f, std::min(15.0f, std::nearbyint(rf[k] * inv) + zero));
+                const auto q = static_cast<uint8_t>(v);
+                // Block of 32: element i in the low nibble of byte i, i + 16 in the high nibble
+                uint8_t& b = qr[(k & ~int64_t(31)) / 2 + (k & 15)];
+                b |= (k & 16) ? static_cast<uint8_t>(q << 4) : q;
+            }
+        }
+    }
+
+    TensorView v = make_view(base, scheme.dt, W.shape);
+    v.quant.scales = scales;
+    v.quant.zeros = zeros;
+    v.quant.group_size = (scheme.dt == DType::Q4) ? scheme.group_size : 0;
+    if (scheme.smooth) {
+        auto* smooth = reinterpret_cast<float*>(base + l.smooth);
+        std::memcpy(smooth, scheme.smooth, static_cast<size_t>(D_in) * sizeof(float));
+        v.quant.smooth = smooth;
+    }
+    return v;
+}
+
+bool can_repack_q4(const PackedQ4Source& src) {
+    const int64_t G = src.group_size;
+    if (!src.qweight || !src.qzeros || !src.scales || src.D_out <= 0 || src.D_out % 8 != 0) return false;
+    if (src.scales_dt != DType::F16 && src.scales_dt != DType::BF16 && src.scales_dt != DType::F32) return false;
+    return G > 0 && G % 32 == 0 && src.D_in % G == 0 && src.D_in / G <= kernels::kQ4MaxGroupsPerRow;
+}
+
+static QuantScheme repack_scheme(const PackedQ4Source& src) {
+    QuantScheme scheme;
+    scheme.dt = DType::Q4;
+    scheme.group_size = src.group_size;
+    scheme.zero_points = true;
+    return scheme;
+}
+
+size_t repacked_q4_bytes(const PackedQ4Source& src) {
+    TensorView shape_only = make_view(nullptr, DType::F32, {src.D_out, src.D_in});
+    return quant_layout(shape_only, repack_scheme(src)).total;
+}
+
+TensorView repack_q4(const PackedQ4Source& src, void* dst) {
+    if (!can_repack_q4(src)) {
+        throw std::invalid_argument("repack_q4: need qweight/qzeros/scales, D_out a multiple of 8 and a group "
+                                    "size that is a multiple of 32 dividing D_in");
+    }
+    const int64_t D_out = src.D_out, D_in = src.D_in, G = src.group_size, n_groups = D_in / G;
+    TensorView shape_only = make_view(nullptr, DType::F32, {D_out, D_in});
+    const QuantLayout l = quant_layout(shape_only, repack_scheme(src));
+    auto* base = static_cast<uint8_t*>(dst);
+    auto* scales = reinterpret_cast<float*>(base + l.scales);
+    auto* zeros = reinterpret_cast<float*>(base + l.zeros);
+    std::memset(base, 0, static_cast<size_t>(D_out * D_in) / 2);
+
+    // Nibble i of an AWQ word holds column kAwqOrder[i] of its 8; this is the inverse
+    static constexpr int kAwqShift[8] = {0, 4, 1, 5, 2, 6, 3, 7};
+    const bool awq = (src.format == PackedQ4Format::AWQ);
+    auto word = [](const int32_t* p, int64_t i) {
+        uint32_t w;
+        std::memcpy(&w, p + i, sizeof(w)); // checkpoint data need not be 4-byte aligned
+        return w;
+    };
+    auto col_nibble = [&](const int32_t* row, int64_t c) {
+        // Packed along D_out: word c / 8, position by format
+        const int shift = awq ? kAwqShift[c % 8] : static_cast<int>(c % 8);
+        return static_cast<uint8_t>((word(row, c / 8) >> (4 * shift)) & 0xF);
+    };
+    auto scale_at = [&](int64_t g, int64_t c) {
+        const int64_t i = g * D_out + c;
+        if (src.scales_dt == DType::F32) return static_cast<const float*>(src.scales)[i];
+        const uint16_t h = static_cast<const uint16_t*>(src.scales)[i];
+        return src.scales_dt == DType::F16 ? half::f16_to_f32(h) : half::bf16_to_f32(h);
+    };
+    auto put = [&](int64_t j, int64_t k, uint8_t q) {
+        // Block of 32: element i in the low nibble of byte i, i + 16 in the high nibble
+        uint8_t& b = base[static_cast<size_t>(j * D_in) / 2 + (k & ~int64_t(31)) / 2 + (k & 15)];
+        b |= (k & 16) ? static_cast<uint8_t>(q << 4) : q;
+    };
+
+    bool all_midpoint = true;
+    const uint8_t zero_bias = (src.format == PackedQ4Format::GPTQ) ? 1 : 0; // v1 stores (z - 1) & 15
+    for (int64_t j = 0; j < D_out; ++j) {
+        const int64_t c = src.row_map ? src.row_map[j] : j;
+        for (int64_t g = 0; g < n_groups; ++g) {
+            scales[j * n_groups + g] = scale_at(g, c);
+            const uint8_t zq = (col_nibble(src.qzeros + g * (D_out / 8), c) + zero_bias) & 0xF;
+            const float z = static_cast<float>(zq);
+            zeros[j * n_groups + g] = z;
+            all_midpoint = all_midpoint && z == 8.0f;
+        }
+    }
+
+    // Row blocks keep the source reads contiguous across columns
+    constexpr int64_t kRows = 64;
+    for (int64_t j0 = 0; j0 < D_out; j0 += kRows) {
+        const int64_t j1 = std::min(j0 + kRows, D_out);
+        if (awq) {
+            for (int64_t k = 0; k < D_in; ++k) {
+                const int32_t* row = src.qweight + k * (D_out / 8);
+                for (int64_t j = j0; j < j1; ++j) put(j, k, col_nibble(row, src.row_map ? src.row_map[j] : j));
+            }
+        } else {
+            for (int64_t k8 = 0; k8 < D_in / 8; ++k8) {
+                const int32_t* row = src.qweight + k8 * D_out;
+                for (int64_t j = j0; j < j1; ++j) {
+                    const uint32_t w = word(row, src.row_map ? src.row_map[j] : j);
+                    for (int64_t i = 0; i < 8; ++i) put(j, k8 * 8 + i, static_cast<uint8_t>((w >> (4 * i)) & 0xF));
+                }
+            }
+        }
+    }
+
+    TensorView v = make_view(base, DType::Q4, {D_out, D_in});
+    v.quant.scales = scales;
+    v.quant.zeros = all_midpoint ? nullptr : zeros;
+    v.quant.group_size = G;
+    return v;
+}
+
+void smooth_quant_scales(const float* act_absmax, const TensorView& W, float alpha, float* smooth) {
+    if (W.shape.size() != 2 || W.layout != Layout::RowMajor || !W.is_contiguous() ||
+        (W.dt != DType::F32 && W.dt != DType::F16 && W.dt != DType::BF16)) {
+        throw std::invalid_argument("smooth_quant_scales: W must be a row-major F32/F16/BF16 matrix");
+    }
+    const int64_t D_out = W.shape[0], D_in = W.shape[1];
+    std::vector<float> wmax(static_cast<size_t>(D_in), 0.0f);
+    Tensor Wf = astype_copy(W, DType::F32);
+    const float* wf = Wf.view.ptr<float>();
+    for (int64_t j = 0; j < D_out; ++j) {
+        for (int64_t k = 0; k < D_in; ++k) wmax[static_cast<size_t>(k)] = std::max(wmax[static_cast<size_t>(k)], std::fabs(wf[j * D_in + k]));
+    }
+    constexpr float kFloor = 1e-5f;
+    for (int64_t k = 0; k < D_in; ++k) {
+        const float a = std::max(act_absmax[k], kFloor);
+        const float w = std::max(wmax[static_cast<size_t>(k)], kFloor);
+        smooth[k] = std::max(std::pow(a, alpha) / std::pow(w, 1.0f - alpha), kFloor);
     }
-    return output;
 }
 
 } // namespace ops
@@ -0,0 +1,132 @@
+#include "linear_kernels.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+namespace {
+
+bool vnni_allowed() {
+    const char* env = std::getenv("IE_VNNI");
+    return !(env && std::strcmp(env, "0") == 0);
+}
+
+const KernelTable* table_for(Isa isa) {
+    const CpuFeatures& f = cpu_features();
+    const bool vnni = vnni_allowed();
+    switch (isa) {
+        case Isa::AVX512:
+            if (vnni && f.avx512_vnni) {
+                if (const KernelTable* t = kernel_table_avx512_vnni()) return t;
+            }
+            return kernel_table_avx512();
+        case Isa::AVX2:
+            if (vnni && f.avx_vnni) {
+                if (const KernelTable* t = kernel_table_avx2_vnni()) return t;
+            }
+            return kernel_table_avx2();
+        case Isa::Scalar: return kernel_table_scalar();
+    }
+    return nullptr;
+}
+
+const KernelTable* default_table() {
+    Isa isa = best_isa();
+    const char* env = std::getenv("IE_ISA");
+    if (env && *env) {
+        try {
+            const Isa want = parse_isa(env);
+            if (isa_supported(want)) {
+                isa = want;
+            } else {
+                std::cerr << "[Kernels] IE_ISA=" << env << " is not supported on this host, using "
+                          << isa_name(isa) << std::endl;
+            }
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "[Kernels] " << e.what() << ", using " << isa_name(isa) << std::endl;
+        }
+    }
+    const KernelTable* t = table_for(isa);
+    return t ? t : kernel_table_scalar();
+}
+
+std::atomic<const KernelTable*> g_active{nullptr};
+
+template <typename Fn>
+Fn pick(Fn const (&grid)[kXTypes][kWTypes], DType x_dt, DType w_dt) {
+    const auto xi = static_cast<size_t>(x_dt), wi = static_cast<size_t>(w_dt);
+    if (xi >= kXTypes || wi >= kWTypes || !grid[xi][wi]) {
+        throw std::runtime_error(std::string("linear: unsupported dtype pair x=") +
+                                 dtype_name(x_dt) + " W=" + dtype_name(w_dt));
+    }
+    return grid[xi][wi];
+}
+
+} // namespace
+
+const KernelTable& active_table() {
+    const KernelTable* t = g_active.load(std::memory_order_acquire);
+    if (!t) {
+        const KernelTable* want = default_table();
+        t = g_active.compare_exchange_strong(t, want, std::memory_order_acq_rel) ? want : t;
+    }
+    return *t;
+}
+
+void set_active_isa(Isa isa) {
+    const KernelTable* t = isa_supported(isa) ? table_for(isa) : nullptr;
+    if (!t) {
+        throw std::runtime_error(std::string("linear: ISA ") + isa_name(isa) + " is not supported on this host");
+    }
+    g_active.store(t, std::memory_order_release);
+}
+
+GemvFn select_gemv(DType x_dt, DType w_dt) {
+    return pick(active_table().gemv, x_dt, w_dt);
+}
+
+GemmFn select_gemm(DType x_dt, DType w_dt) {
+    return pick(active_table().gemm, x_dt, w_dt);
+}
+
+GatedGemvFn select_gated_gemv(DType x_dt, DType w_dt) {
+    return pick(active_table().gated, x_dt, w_dt);
+}
+
+GemmI8Fn select_gemm_i8() { return active_table().gemm_i8; }
+
+float apply_activation(float v, Activation act) { return active_table().activation(v, act); }
+
+int64_t packed_k() { return active_table().pack_k; }
+
+void pack_panels(const void* W, size_t elem_bytes, int64_t D_out, int64_t D_in, void* dst) {
+    const int64_t pack_k = packed_k();
+    const auto* src = static_cast<const uint8_t*>(W);
+    auto* out = static_cast<uint8_t*>(dst);
+    const int64_t panels = (D_out + kPackRows - 1) / kPackRows;
+    const int64_t chunks = D_in / pack_k;
+    const size_t chunk_bytes = static_cast<size_t>(pack_k) * elem_bytes;
+    for (int64_t p = 0; p < panels; ++p) {
+        for (int64_t c = 0; c < chunks; ++c) {
+            for (int64_t r = 0; r < kPackRows; ++r) {
+                const int64_t j = p * kPackRows + r;
+                if (j < D_out) {
+                    std::memcpy(out, src + (static_cast<size_t>(j) * D_in + c * pack_k) * elem_bytes, chunk_bytes);
+                } else {
+                    std::memset(out, 0, chunk_bytes); // pad rows of the last panel
+                }
+                out += chunk_bytes;
+            }
+        }
+    }
+}
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
@@ -0,0 +1,146 @@
+#pragma once
+#include "infer_engine/core/device.hpp"
+#include "infer_engine/core/types.hpp"
+#include "infer_engine/layers/ops/activations.hpp"
+#include <cstdint>
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+/** Rows per packed panel; also the number of W rows one GEMV step covers. */
+constexpr int64_t kPackRows = 4;
+
+/**
+ * Weight operand as the kernels see it: W is logically [D_out, D_in].
+ *
+ * Row-major: row j starts at data + j * D_in.
+ * Packed (Layout::PackedPanels): rows are grouped into panels of kPackRows,
+ * and each panel is stored as [D_in / packed_k()][kPackRows][packed_k()],
+ * i.e. the depth-chunks of its rows interleaved so one GEMV step reads a
+ * single contiguous run.
+ */
+struct WeightArg {
+    const void* data = nullptr;
+    int64_t D_in = 0;
+    bool packed = false;
+    const float* scales = nullptr;   // I8: per-row scale; Q4: [D_out, D_in / group_size]
+    const float* zeros = nullptr;    // Q4 with zero points, same shape as scales
+    int64_t group_size = 0;          // Q4 only
+};
+
+/**
+ * Applied by the kernels as each output element is stored:
+ *   y[j] = (accumulate ? y[j] : 0) + scale * (dot + bias[j])
+ */
+struct Epilogue {
+    const float* bias = nullptr;   // [D_out] or null
+    float scale = 1.0f;
+    bool accumulate = false;
+};
+
+/**
+ * GEMV micro-kernel:
+ *   y[j] = ep(dot(x[0:D_in], W[j, 0:D_in]))   for j in [j0, j1)
+ *
+ * x is a raw pointer in the dtype the kernel was selected for; accumulation
+ * and y are always F32.
+ */
+using GemvFn = void (*)(const void* x, const WeightArg& W, float* y, int64_t j0, int64_t j1,
+                        const Epilogue& ep);
+
+/**
+ * Cache-blocked GEMM micro-kernel for N > 1 input rows:
+ *   y[i, j] = ep(dot(x[i, 0:D_in], W[j, 0:D_in]))   for i in [0, N), j in [j0, j1)
+ *
+ * x is [N, D_in] and y is [N, D_out], both row-major. The kernel tiles over
+ * rows of x, the W rows [j0, j1) and D_in so each W panel stays cache
+ * resident while it is reused across every row of x.
+ */
+using GemmFn = void (*)(const void* x, const WeightArg& W, float* y, int64_t N,
+                        int64_t j0, int64_t j1, int64_t D_out, const Epilogue& ep);
+
+/**
+ * Fused gated-MLP GEMV (SwiGLU/GeGLU):
+ *   h[j] = act(dot(x, Wg[j, :])) * dot(x, Wu[j, :])   for j in [j0, j1)
+ *
+ * Gate and up rows are accumulated side by side from the same x loads, and
+ * the activation and product are applied before h is stored. Wg and Wu must
+ * share dtype, D_in and layout.
+ */
+using GatedGemvFn = void (*)(const void* x, const WeightArg& Wg, const WeightArg& Wu, float* h,
+                             int64_t j0, int64_t j1, Activation act);
+
+/**
+ * Int8 x int8 GEMM for dynamically quantized activations (W8A8):
+ *   y[i, j] = ep(xs[i] * W.scales[j] * sum_k xq[i, k] * w[j, k])
+ *
+ * xq is [N, D_in] int8 (symmetric, |q| <= 127) with one scale per row in xs;
+ * W is row-major I8. The sums are exact in int32 and only the final value is
+ * converted to F32. Rows [j0, j1) of y are written, N may be 1.
+ */
+using GemmI8Fn = void (*)(const int8_t* xq, const float* xs, const WeightArg& W, float* y, int64_t N,
+                          int64_t j0, int64_t j1, int64_t D_out, const Epilogue& ep);
+
+/**
+ * One ISA level's kernels. The grids are indexed [x dtype][W dtype] by the
+ * DType value: x is F32/F16/BF16, W additionally I8 (weight-only quantized,
+ * dequantized in registers and scaled per row) and Q4 (group-wise nibbles,
+ * row-major only). pack_k is that level's packed chunk depth. vnni is set on
+ * the tables built with VNNI, whose gemm_i8 uses vpdpbusd.
+ */
+constexpr size_t kXTypes = 3;
+constexpr size_t kWTypes = 5;
+
+/** Q4 limits of the kernels: groups are whole 32-element blocks, at most this many per row. */
+constexpr int64_t kQ4MaxGroupsPerRow = 1024;
+
+struct KernelTable {
+    Isa isa = Isa::Scalar;
+    int64_t pack_k = 0;
+    GemvFn gemv[kXTypes][kWTypes] = {};
+    GemmFn gemm[kXTypes][kWTypes] = {};
+    GatedGemvFn gated[kXTypes][kWTypes] = {};
+    GemmI8Fn gemm_i8 = nullptr;
+    bool vnni = false;
+    float (*activation)(float, Activation) = nullptr;
+};
+
+/** Defined by the per-ISA TUs; null when that TU was built without its flags. */
+const KernelTable* kernel_table_scalar();
+const KernelTable* kernel_table_avx2();
+const KernelTable* kernel_table_avx512();
+const KernelTable* kernel_table_avx2_vnni();     // AVX2 + AVX-VNNI
+const KernelTable* kernel_table_avx512_vnni();   // AVX-512F + AVX512-VNNI
+
+/**
+ * Table in use. Chosen on first use: IE_ISA from the environment if the host
+ * supports it, else best_isa(); within a level the VNNI build is preferred
+ * when the host has it, unless IE_VNNI=0. set_active_isa overrides the level
+ * and must run before any weights are packed.
+ */
+const KernelTable& active_table();
+void set_active_isa(Isa isa);
+
+/** Pick the specialized kernel for an (activation, weight) dtype pair. */
+GemvFn select_gemv(DType x_dt, DType w_dt);
+GemmFn select_gemm(DType x_dt, DType w_dt);
+GatedGemvFn select_gated_gemv(DType x_dt, DType w_dt);
+GemmI8Fn select_gemm_i8();
+
+/** Scalar epilogue used by the gated kernels, exposed for the N > 1 path. */
+float apply_activation(float v, Activation act);
+
+/** Depth of one packed chunk, matched to the active micro-kernel's step. */
+int64_t packed_k();
+
+/**
+ * Repack row-major W [D_out, D_in] into the panel layout at dst. D_in must be
+ * a multiple of packed_k(); dst holds ceil(D_out / kPackRows) * kPackRows * D_in
+ * elements (the last panel is zero padded).
+ */
+void pack_panels(const void* W, size_t elem_bytes, int64_t D_out, int64_t D_in, void* dst);
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
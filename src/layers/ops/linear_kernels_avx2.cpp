@@ -0,0 +1,24 @@
+// AVX2 + FMA + F16C kernels (compiled with -mavx2 -mfma -mf16c, see CMakeLists.txt).
+#include "linear_kernels.hpp"
+
+#if defined(IE_KERNELS_AVX2) && defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+#define IE_KERNEL_LEVEL 1
+#include "linear_kernels_impl.hpp"
+#endif
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+const KernelTable* kernel_table_avx2() {
+#if defined(IE_KERNELS_AVX2) && defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+    static constexpr KernelTable table = make_table(Isa::AVX2);
+    return &table;
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
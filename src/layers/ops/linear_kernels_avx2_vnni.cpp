@@ -0,0 +1,26 @@
+// AVX2 + AVX-VNNI kernels (compiled with -mavx2 -mfma -mf16c -mavxvnni, see
+// CMakeLists.txt). Same kernels as the AVX2 level; gemm_i8 uses vpdpbusd.
+#include "linear_kernels.hpp"
+
+#if defined(IE_KERNELS_VNNI) && defined(__AVX2__) && defined(__FMA__) && defined(__F16C__) && defined(__AVXVNNI__)
+#define IE_KERNEL_LEVEL 1
+#define IE_KERNEL_VNNI 1
+#include "linear_kernels_impl.hpp"
+#endif
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+const KernelTable* kernel_table_avx2_vnni() {
+#if defined(IE_KERNELS_VNNI) && defined(__AVX2__) && defined(__FMA__) && defined(__F16C__) && defined(__AVXVNNI__)
+    static constexpr KernelTable table = make_table(Isa::AVX2);
+    return &table;
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
@@ -0,0 +1,27 @@
+// AVX-512F + AVX512-VNNI kernels (compiled with -mavx512f -mavx512vnni -mavx2
+// -mfma -mf16c, see CMakeLists.txt). Same kernels as the AVX-512 level;
+// gemm_i8 uses vpdpbusd on zmm registers.
+#include "linear_kernels.hpp"
+
+#if defined(IE_KERNELS_VNNI) && defined(__AVX512F__) && defined(__FMA__) && defined(__F16C__) && defined(__AVX512VNNI__)
+#define IE_KERNEL_LEVEL 2
+#define IE_KERNEL_VNNI 1
+#include "linear_kernels_impl.hpp"
+#endif
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+const KernelTable* kernel_table_avx512_vnni() {
+#if defined(IE_KERNELS_VNNI) && defined(__AVX512F__) && defined(__FMA__) && defined(__F16C__) && defined(__AVX512VNNI__)
+    static constexpr KernelTable table = make_table(Isa::AVX512);
+    return &table;
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
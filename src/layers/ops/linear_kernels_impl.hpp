@@ -0,0 +1,590 @@
+#pragma once
+// Kernel bodies shared by the per-ISA translation units
+// (linear_kernels_{scalar,avx2,avx512}.cpp and the *_vnni variants), built on
+// the Vec traits in kernel_vec.hpp. The including TU defines IE_KERNEL_LEVEL
+// (0 scalar, 1 AVX2+FMA+F16C, 2 AVX-512F), optionally IE_KERNEL_VNNI, and is
+// compiled with the matching -m flags; everything here has internal linkage so
+// no code built for one level can be picked up by the linker for another. For
+// the same reason these TUs should not call shared inline helpers that may be
+// emitted out of line (e.g. the F16 conversion uses _cvtsh_ss above the scalar
+// level).
+#ifndef IE_KERNEL_LEVEL
+#error "define IE_KERNEL_LEVEL before including linear_kernels_impl.hpp"
+#endif
+
+#include "linear_kernels.hpp"
+#include "kernel_vec.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+namespace {
+
+// Element k of a weight row lives at row + (k / kPackK) * cs + k % kPackK,
+// where the chunk stride cs is kPackK for row-major rows and
+// kPackRows * kPackK inside a packed panel. kPackK is the depth consumed per
+// step of dot_rows, so a packed panel is read as one sequential stream.
+constexpr int64_t kPackK = (Vec::W > 1) ? 2 * Vec::W : 16;
+
+inline int64_t w_off(int64_t k, int64_t cs) {
+    return (k / kPackK) * cs + (k % kPackK);
+}
+
+template <DType WT>
+struct WRows {
+    const uint8_t* base;
+    int64_t D_in;
+    bool packed;
+
+    explicit WRows(const WeightArg& W)
+        : base(static_cast<const uint8_t*>(W.data)), D_in(W.D_in), packed(W.packed) {}
+
+    int64_t chunk_stride() const { return packed ? kPackRows * kPackK : kPackK; }
+    const void* row(int64_t j) const {
+        constexpr size_t eb = sizeof(typename Elem<WT>::type);
+        const int64_t off = packed
+            ? (j / kPackRows) * kPackRows * D_in + (j % kPackRows) * kPackK
+            : j * D_in;
+        return base + static_cast<size_t>(off) * eb;
+    }
+};
+
+// R simultaneous dot products against one x vector. Each x chunk is loaded
+// once and reused for all R weight rows; two accumulators per row hide FMA
+// latency.
+template <DType XT, DType WT, int R>
+inline void dot_rows(const void* x, const void* const* w, int64_t cs, int64_t K, float* out) {
+    float s[R];
+    int64_t k = 0;
+    if constexpr (Vec::W > 1) {
+        typename Vec::reg a0[R], a1[R];
+        for (int r = 0; r < R; ++r) { a0[r] = Vec::zero(); a1[r] = Vec::zero(); }
+        for (; k + kPackK <= K; k += kPackK) {
+            const int64_t o = (k / kPackK) * cs;
+            const auto x0 = Vec::template load<XT>(x, k);
+            const auto x1 = Vec::template load<XT>(x, k + Vec::W);
+            for (int r = 0; r < R; ++r) {
+                a0[r] = Vec::fmadd(Vec::template load<WT>(w[r], o), x0, a0[r]);
+                a1[r] = Vec::fmadd(Vec::template load<WT>(w[r], o + Vec::W), x1, a1[r]);
+            }
+        }
+        for (; k + Vec::W <= K; k += Vec::W) {
+            const auto x0 = Vec::template load<XT>(x, k);
+            for (int r = 0; r < R; ++r) {
+                a0[r] = Vec::fmadd(Vec::template load<WT>(w[r], w_off(k, cs)), x0, a0[r]);
+            }
+        }
+        for (int r = 0; r < R; ++r) s[r] = Vec::hsum(Vec::add(a0[r], a1[r]));
+    } else {
+        for (int r = 0; r < R; ++r) s[r] = 0.0f;
+    }
+    for (; k < K; ++k) {
+        const float xv = load_scalar<XT>(x, k);
+        for (int r = 0; r < R; ++r) s[r] += xv * load_scalar<WT>(w[r], w_off(k, cs));
+    }
+    for (int r = 0; r < R; ++r) out[r] = s[r];
+}
+
+// Raw dot product of W row j -> its real value (I8 rows carry a scale)
+template <DType WT>
+inline float dequant(const WeightArg& W, int64_t j, float v) {
+    if constexpr (WT == DType::I8) return v * W.scales[j];
+    else return v;
+}
+
+inline void store(float* y, int64_t j, float v, const Epilogue& ep) {
+    if (ep.bias) v += ep.bias[j];
+    v *= ep.scale;
+    y[j] = ep.accumulate ? y[j] + v : v;
+}
+
+template <DType XT, DType WT>
+void gemv(const void* x, const WeightArg& W, float* y, int64_t j0, int64_t j1, const Epilogue& ep) {
+    constexpr int R = kPackRows;
+    const WRows<WT> w(W);
+    const int64_t cs = w.chunk_stride();
+    int64_t j = j0;
+    for (; j + R <= j1; j += R) {
+        const void* rows[R];
+        for (int r = 0; r < R; ++r) rows[r] = w.row(j + r);
+        float s[R];
+        dot_rows<XT, WT, R>(x, rows, cs, W.D_in, s);
+        for (int r = 0; r < R; ++r) store(y, j + r, dequant<WT>(W, j + r, s[r]), ep);
+    }
+    for (; j < j1; ++j) {
+        const void* row[1] = { w.row(j) };
+        float s;
+        dot_rows<XT, WT, 1>(x, row, cs, W.D_in, &s);
+        store(y, j, dequant<WT>(W, j, s), ep);
+    }
+}
+
+inline float act_fn(float v, Activation act) {
+    if (act == Activation::SiLU) return v / (1.0f + std::exp(-v));
+    const float inner = 0.7978845608028654f * (v + 0.044715f * v * v * v); // sqrt(2/pi)
+    return 0.5f * v * (1.0f + std::tanh(inner));
+}
+
+template <DType XT, DType WT>
+void gated_gemv(const void* x, const WeightArg& Wg, const WeightArg& Wu, float* h,
+                int64_t j0, int64_t j1, Activation act) {
+    // G gate rows + G up rows per step: 2 accumulators each must fit the
+    // register file (16 zmm of 32 on AVX-512, 8 ymm of 16 on AVX2).
+    constexpr int G = (Vec::W >= 16) ? 4 : 2;
+    const WRows<WT> g(Wg), u(Wu);
+    const int64_t cs = g.chunk_stride();
+    int64_t j = j0;
+    for (; j + G <= j1; j += G) {
+        const void* rows[2 * G];
+        for (int r = 0; r < G; ++r) { rows[r] = g.row(j + r); rows[G + r] = u.row(j + r); }
+        float s[2 * G];
+        dot_rows<XT, WT, 2 * G>(x, rows, cs, Wg.D_in, s);
+        for (int r = 0; r < G; ++r) {
+            h[j + r] = act_fn(dequant<WT>(Wg, j + r, s[r]), act) * dequant<WT>(Wu, j + r, s[G + r]);
+        }
+    }
+    for (; j < j1; ++j) {
+        const void* rows[2] = { g.row(j), u.row(j) };
+        float s[2];
+        dot_rows<XT, WT, 2>(x, rows, cs, Wg.D_in, s);
+        h[j] = act_fn(dequant<WT>(Wg, j, s[0]), act) * dequant<WT>(Wu, j, s[1]);
+    }
+}
+
+// MR x NR dot products over k in [k0, k1): every loaded W vector is reused
+// for MR rows of x and every x vector for NR rows of W.
+template <DType XT, DType WT, int MR, int NR>
+inline void dot_tile(const void* const* x, const void* const* w, int64_t cs,
+                     int64_t k0, int64_t k1, float (*out)[NR]) {
+    float s[MR][NR];
+    int64_t k = k0;
+    if constexpr (Vec::W > 1) {
+        typename Vec::reg acc[MR][NR];
+        for (int m = 0; m < MR; ++m)
+            for (int n = 0; n < NR; ++n) acc[m][n] = Vec::zero();
+        for (; k + Vec::W <= k1; k += Vec::W) {
+            const int64_t o = w_off(k, cs);
+            typename Vec::reg wv[NR];
+            for (int n = 0; n < NR; ++n) wv[n] = Vec::template load<WT>(w[n], o);
+            for (int m = 0; m < MR; ++m) {
+                const auto xv = Vec::template load<XT>(x[m], k);
+                for (int n = 0; n < NR; ++n) acc[m][n] = Vec::fmadd(xv, wv[n], acc[m][n]);
+            }
+        }
+        for (int m = 0; m < MR; ++m)
+            for (int n = 0; n < NR; ++n) s[m][n] = Vec::hsum(acc[m][n]);
+    } else {
+        for (int m = 0; m < MR; ++m)
+            for (int n = 0; n < NR; ++n) s[m][n] = 0.0f;
+    }
+    for (; k < k1; ++k) {
+        const int64_t o = w_off(k, cs);
+        float wv[NR];
+        for (int n = 0; n < NR; ++n) wv[n] = load_scalar<WT>(w[n], o);
+        for (int m = 0; m < MR; ++m) {
+            const float xv = load_scalar<XT>(x[m], k);
+            for (int n = 0; n < NR; ++n) s[m][n] += xv * wv[n];
+        }
+    }
+    for (int m = 0; m < MR; ++m)
+        for (int n = 0; n < NR; ++n) out[m][n] = s[m][n];
+}
+
+// Blocking parameters for gemm(). A KC-deep slice of the caller's W rows
+// (e.g. 64 rows x 256 BF16 = 32 KB) stays in L1/L2 while NB rows of x sweep
+// over it, so W is streamed from memory once per call regardless of N.
+// KC is a multiple of kPackK so slices never split a packed chunk.
+constexpr int64_t kGemmKC = 256;
+constexpr int64_t kGemmNB = 64;
+static_assert(kGemmKC % kPackK == 0, "GEMM K block must hold whole packed chunks");
+
+template <DType XT, DType WT>
+void gemm(const void* x, const WeightArg& W, float* y, int64_t N,
+          int64_t j0, int64_t j1, int64_t D_out, const Epilogue& ep) {
+    constexpr int MR = Vec::MR;
+    constexpr int NR = kPackRows;
+    const int64_t D_in = W.D_in;
+    const WRows<WT> w(W);
+    const int64_t cs = w.chunk_stride();
+    const auto* xb = static_cast<const uint8_t*>(x);
+    const size_t x_row_bytes = static_cast<size_t>(D_in) * sizeof(typename Elem<XT>::type);
+    auto x_row = [&](int64_t i) -> const void* { return xb + static_cast<size_t>(i) * x_row_bytes; };
+
+    // The first K slice goes through the epilogue, later slices add in scaled
+    auto emit = [&](int64_t i, int64_t j, float v, bool first) {
+        v = dequant<WT>(W, j, v);
+        if (first) store(y + i * D_out, j, v, ep);
+        else y[i * D_out + j] += ep.scale * v;
+    };
+
+    for (int64_t i0 = 0; i0 < N; i0 += kGemmNB) {
+        const int64_t i1 = (i0 + kGemmNB < N) ? i0 + kGemmNB : N;
+        for (int64_t k0 = 0; k0 < D_in; k0 += kGemmKC) {
+            const int64_t k1 = (k0 + kGemmKC < D_in) ? k0 + kGemmKC : D_in;
+            const bool first = (k0 == 0);
+            int64_t i = i0;
+            for (; i + MR <= i1; i += MR) {
+                const void* xr[MR];
+                for (int m = 0; m < MR; ++m) xr[m] = x_row(i + m);
+                int64_t j = j0;
+                for (; j + NR <= j1; j += NR) {
+                    const void* wr[NR];
+                    for (int n = 0; n < NR; ++n) wr[n] = w.row(j + n);
+                    float out[MR][NR];
+                    dot_tile<XT, WT, MR, NR>(xr, wr, cs, k0, k1, out);
+                    for (int m = 0; m < MR; ++m)
+                        for (int n = 0; n < NR; ++n) emit(i + m, j + n, out[m][n], first);
+                }
+                for (; j < j1; ++j) {
+                    const void* wr[1] = { w.row(j) };
+                    float out[MR][1];
+                    dot_tile<XT, WT, MR, 1>(xr, wr, cs, k0, k1, out);
+                    for (int m = 0; m < MR; ++m) emit(i + m, j, out[m][0], first);
+                }
+            }
+            // Leftover rows of x: one row against NR rows of W at a time
+            for (; i < i1; ++i) {
+                const void* xr[1] = { x_row(i) };
+                int64_t j = j0;
+                for (; j + NR <= j1; j += NR) {
+                    const void* wr[NR];
+                    for (int n = 0; n < NR; ++n) wr[n] = w.row(j + n);
+                    float out[1][NR];
+                    dot_tile<XT, WT, 1, NR>(xr, wr, cs, k0, k1, out);
+                    for (int n = 0; n < NR; ++n) emit(i, j + n, out[0][n], first);
+                }
+                for (; j < j1; ++j) {
+                    const void* wr[1] = { w.row(j) };
+                    float out[1][1];
+                    dot_tile<XT, WT, 1, 1>(xr, wr, cs, k0, k1, out);
+                    emit(i, j, out[0][0], first);
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Q4 group-quantized weights. A row is D_in / 2 bytes of 32-element blocks
+// (see DType::Q4). Per group g of G elements
+//   sum_k w_k x_k = s_g * (sum_k q_k x_k - z_g * sum_k x_k)
+// so the inner loop is an unpack-and-FMA on raw nibbles, each block product
+// is scaled into the row accumulator, and the zero-point term uses per-group
+// sums of x computed once per call.
+
+constexpr int64_t kQ4Block = 32;
+constexpr int64_t kQ4MaxGroups = kQ4MaxGroupsPerRow; // bound for the stack x sums
+
+template <DType XT>
+inline void q4_x_sums(const void* x, int64_t D_in, int64_t G, float* xsum) {
+    for (int64_t g = 0; g * G < D_in; ++g) {
+        float s = 0.0f;
+        for (int64_t k = g * G; k < (g + 1) * G; ++k) s += load_scalar<XT>(x, k);
+        xsum[g] = s;
+    }
+}
+
+template <DType XT, int R>
+inline void q4_dot_rows(const void* x, const float* xsum, const WeightArg& W, const int64_t* js, float* out) {
+    constexpr int NQ = static_cast<int>(kQ4Block / Vec::W);
+    const int64_t D_in = W.D_in, G = W.group_size, n_groups = D_in / G;
+    const auto* base = static_cast<const uint8_t*>(W.data);
+    const uint8_t* rows[R];
+    const float* sc[R];
+    typename Vec::reg acc[R];
+    for (int r = 0; r < R; ++r) {
+        rows[r] = base + static_cast<size_t>(js[r]) * static_cast<size_t>(D_in / 2);
+        sc[r] = W.scales + js[r] * n_groups;
+        acc[r] = Vec::zero();
+    }
+    for (int64_t g = 0; g < n_groups; ++g) {
+        typename Vec::reg sv[R];
+        for (int r = 0; r < R; ++r) sv[r] = Vec::set1(sc[r][g]);
+        for (int64_t k = g * G; k < (g + 1) * G; k += kQ4Block) {
+            typename Vec::reg xv[NQ];
+            for (int q = 0; q < NQ; ++q) xv[q] = Vec::template load<XT>(x, k + q * Vec::W);
+            for (int r = 0; r < R; ++r) {
+                typename Vec::reg qv[NQ];
+                Vec::q4_block(rows[r] + k / 2, qv);
+                auto p = Vec::mul(qv[0], xv[0]);
+                for (int q = 1; q < NQ; ++q) p = Vec::fmadd(qv[q], xv[q], p);
+                acc[r] = Vec::fmadd(p, sv[r], acc[r]);
+            }
+        }
+    }
+    for (int r = 0; r < R; ++r) {
+        const float* zp = W.zeros ? W.zeros + js[r] * n_groups : nullptr;
+        float corr = 0.0f;
+        for (int64_t g = 0; g < n_groups; ++g) corr += sc[r][g] * (zp ? zp[g] : 8.0f) * xsum[g];
+        out[r] = Vec::hsum(acc[r]) - corr;
+    }
+}
+
+template <DType XT>
+void gemv_q4(const void* x, const WeightArg& W, float* y, int64_t j0, int64_t j1, const Epilogue& ep) {
+    constexpr int R = kPackRows;
+    float xsum[kQ4MaxGroups];
+    q4_x_sums<XT>(x, W.D_in, W.group_size, xsum);
+    int64_t j = j0;
+    for (; j + R <= j1; j += R) {
+        const int64_t js[R] = {j, j + 1, j + 2, j + 3};
+        float s[R];
+        q4_dot_rows<XT, R>(x, xsum, W, js, s);
+        for (int r = 0; r < R; ++r) store(y, j + r, s[r], ep);
+    }
+    for (; j < j1; ++j) {
+        float s;
+        q4_dot_rows<XT, 1>(x, xsum, W, &j, &s);
+        store(y, j, s, ep);
+    }
+}
+
+// N > 1: the caller's W row block stays cache resident across the x rows
+template <DType XT>
+void gemm_q4(const void* x, const WeightArg& W, float* y, int64_t N,
+             int64_t j0, int64_t j1, int64_t D_out, const Epilogue& ep) {
+    const size_t x_row_bytes = static_cast<size_t>(W.D_in) * sizeof(typename Elem<XT>::type);
+    for (int64_t i = 0; i < N; ++i) {
+        gemv_q4<XT>(static_cast<const uint8_t*>(x) + static_cast<size_t>(i) * x_row_bytes, W, y + i * D_out, j0, j1, ep);
+    }
+}
+
+template <DType XT>
+void gated_gemv_q4(const void* x, const WeightArg& Wg, const WeightArg& Wu, float* h,
+                   int64_t j0, int64_t j1, Activation act) {
+    constexpr int R = 2;
+    float xsum[kQ4MaxGroups];
+    q4_x_sums<XT>(x, Wg.D_in, Wg.group_size, xsum);
+    int64_t j = j0;
+    for (; j + R <= j1; j += R) {
+        const int64_t js[R] = {j, j + 1};
+        float g[R], u[R];
+        q4_dot_rows<XT, R>(x, xsum, Wg, js, g);
+        q4_dot_rows<XT, R>(x, xsum, Wu, js, u);
+        for (int r = 0; r < R; ++r) h[j + r] = act_fn(g[r], act) * u[r];
+    }
+    for (; j < j1; ++j) {
+        float g, u;
+        q4_dot_rows<XT, 1>(x, xsum, Wg, &j, &g);
+        q4_dot_rows<XT, 1>(x, xsum, Wu, &j, &u);
+        h[j] = act_fn(g, act) * u;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Int8 x int8 GEMM (W8A8). Products accumulate exactly in int32 lanes. VNNI's
+// vpdpbusd multiplies unsigned by signed bytes, so x is offset into u8
+// (xor 0x80 == x + 128) and 128 * sum_k w[j, k] is subtracted per row;
+// without VNNI bytes are widened to int16 and summed pairwise by vpmaddwd.
+
+#if IE_KERNEL_LEVEL == 2 && defined(IE_KERNEL_VNNI)
+struct I8Vec {
+    using reg = __m512i;                    // int32 accumulators
+    using xreg = __m512i;                   // x chunk as u8
+    using wreg = __m512i;
+    static constexpr int64_t W = 64;        // bytes per step
+    static constexpr int32_t kOffset = 128;
+    static constexpr int MR = 4;
+    static reg zero() { return _mm512_setzero_si512(); }
+    static xreg load_x(const int8_t* p) { return _mm512_xor_si512(_mm512_loadu_si512(p), _mm512_set1_epi8(char(0x80))); }
+    static xreg ones() { return _mm512_set1_epi8(1); }
+    static wreg load_w(const int8_t* p) { return _mm512_loadu_si512(p); }
+    static reg dot(reg acc, xreg x, wreg w) { return _mm512_dpbusd_epi32(acc, x, w); }
+    static int32_t hsum(reg a) { return _mm512_reduce_add_epi32(a); }
+};
+#elif IE_KERNEL_LEVEL >= 1
+struct I8Vec {
+    using reg = __m256i;
+    using xreg = __m256i;
+    using wreg = __m256i;
+    static int32_t hsum(reg a) {
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+        return _mm_cvtsi128_si32(s);
+    }
+    static constexpr int MR = 2;
+    static reg zero() { return _mm256_setzero_si256(); }
+#if defined(IE_KERNEL_VNNI)
+    static constexpr int64_t W = 32;
+    static constexpr int32_t kOffset = 128;
+    static xreg load_x(const int8_t* p) {
+        return _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), _mm256_set1_epi8(char(0x80)));
+    }
+    static xreg ones() { return _mm256_set1_epi8(1); }
+    static wreg load_w(const int8_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static reg dot(reg acc, xreg x, wreg w) { return _mm256_dpbusd_avx_epi32(acc, x, w); }
+#else
+    // 16 bytes per step widened to int16 (AVX-512F without VNNI lands here too)
+    static constexpr int64_t W = 16;
+    static constexpr int32_t kOffset = 0;
+    static xreg load_x(const int8_t* p) { return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+    static xreg ones() { return _mm256_set1_epi16(1); }
+    static wreg load_w(const int8_t* p) { return load_x(p); }
+    static reg dot(reg acc, xreg x, wreg w) { return _mm256_add_epi32(acc, _mm256_madd_epi16(x, w)); }
+#endif
+};
+#else
+// Scalar level: the tail loops do all the work.
+struct I8Vec {
+    using reg = int32_t;
+    using xreg = int32_t;
+    using wreg = int32_t;
+    static constexpr int64_t W = 1;
+    static constexpr int32_t kOffset = 0;
+    static constexpr int MR = 1;
+    static reg zero() { return 0; }
+    static xreg load_x(const int8_t* p) { return *p; }
+    static xreg ones() { return 1; }
+    static wreg load_w(const int8_t* p) { return *p; }
+    static reg dot(reg acc, xreg x, wreg w) { return acc + x * w; }
+    static int32_t hsum(reg a) { return a; }
+};
+#endif
+
+// W rows per chunk in gemm_i8; their offset corrections live on the stack
+constexpr int64_t kI8RowChunk = 64;
+
+inline int32_t i8_row_sum(const int8_t* w, int64_t K) {
+    int32_t s = 0;
+    int64_t k = 0;
+    if constexpr (I8Vec::W > 1) {
+        typename I8Vec::reg acc = I8Vec::zero();
+        const auto one = I8Vec::ones();
+        for (; k + I8Vec::W <= K; k += I8Vec::W) acc = I8Vec::dot(acc, one, I8Vec::load_w(w + k));
+        s = I8Vec::hsum(acc);
+    }
+    for (; k < K; ++k) s += w[k];
+    return s;
+}
+
+// MR x NR int32 dot products of offset x rows against W rows over all of K
+template <int MR, int NR>
+inline void i8_dot_tile(const int8_t* const* x, const int8_t* const* w, int64_t K, int32_t (*out)[NR]) {
+    int32_t s[MR][NR];
+    int64_t k = 0;
+    if constexpr (I8Vec::W > 1) {
+        typename I8Vec::reg acc[MR][NR];
+        for (int m = 0; m < MR; ++m)
+            for (int n = 0; n < NR; ++n) acc[m][n] = I8Vec::zero();
+        for (; k + I8Vec::W <= K; k += I8Vec::W) {
+            typename I8Vec::wreg wv[NR];
+            for (int n = 0; n < NR; ++n) wv[n] = I8Vec::load_w(w[n] + k);
+            for (int m = 0; m < MR; ++m) {
+                const auto xv = I8Vec::load_x(x[m] + k);
+                for (int n = 0; n < NR; ++n) acc[m][n] = I8Vec::dot(acc[m][n], xv, wv[n]);
+            }
+        }
+        for (int m = 0; m < MR; ++m)
+            for (int n = 0; n < NR; ++n) s[m][n] = I8Vec::hsum(acc[m][n]);
+    } else {
+        for (int m = 0; m < MR; ++m)
+            for (int n = 0; n < NR; ++n) s[m][n] = 0;
+    }
+    for (; k < K; ++k) {
+        for (int m = 0; m < MR; ++m) {
+            const int32_t xv = static_cast<int32_t>(x[m][k]) + I8Vec::kOffset;
+            for (int n = 0; n < NR; ++n) s[m][n] += xv * static_cast<int32_t>(w[n][k]);
+        }
+    }
+    for (int m = 0; m < MR; ++m)
+        for (int n = 0; n < NR; ++n) out[m][n] = s[m][n];
+}
+
+// x rows [i0, i1) against NR W rows starting at j; corr holds the offset
+// correction of those rows
+template <int NR>
+inline void i8_rows(const int8_t* xq, const float* xs, const WeightArg& W, float* y, int64_t i0, int64_t i1,
+                    int64_t j, int64_t D_out, const int32_t* corr, const Epilogue& ep) {
+    constexpr int MR = I8Vec::MR;
+    const int64_t K = W.D_in;
+    const auto* wb = static_cast<const int8_t*>(W.data);
+    const int8_t* wr[NR];
+    for (int n = 0; n < NR; ++n) wr[n] = wb + (j + n) * K;
+    auto emit = [&](int64_t i, int n, int32_t acc) {
+        store(y + i * D_out, j + n, xs[i] * W.scales[j + n] * static_cast<float>(acc - corr[n]), ep);
+    };
+    int64_t i = i0;
+    for (; i + MR <= i1; i += MR) {
+        const int8_t* xr[MR];
+        for (int m = 0; m < MR; ++m) xr[m] = xq + (i + m) * K;
+        int32_t out[MR][NR];
+        i8_dot_tile<MR, NR>(xr, wr, K, out);
+        for (int m = 0; m < MR; ++m)
+            for (int n = 0; n < NR; ++n) emit(i + m, n, out[m][n]);
+    }
+    for (; i < i1; ++i) {
+        const int8_t* xr[1] = { xq + i * K };
+        int32_t out[1][NR];
+        i8_dot_tile<1, NR>(xr, wr, K, out);
+        for (int n = 0; n < NR; ++n) emit(i, n, out[0][n]);
+    }
+}
+
+void gemm_i8(const int8_t* xq, const float* xs, const WeightArg& W, float* y, int64_t N,
+             int64_t j0, int64_t j1, int64_t D_out, const Epilogue& ep) {
+    constexpr int NR = kPackRows;
+    const int64_t K = W.D_in;
+    const auto* wb = static_cast<const int8_t*>(W.data);
+    int32_t corr[kI8RowChunk];
+    for (int64_t jc = j0; jc < j1; jc += kI8RowChunk) {
+        const int64_t jc1 = (jc + kI8RowChunk < j1) ? jc + kI8RowChunk : j1;
+        for (int64_t j = jc; j < jc1; ++j) {
+            corr[j - jc] = I8Vec::kOffset ? I8Vec::kOffset * i8_row_sum(wb + j * K, K) : 0;
+        }
+        // Each NR-row W tile stays in L1 while a block of x rows sweeps it
+        for (int64_t i0 = 0; i0 < N; i0 += kGemmNB) {
+            const int64_t i1 = (i0 + kGemmNB < N) ? i0 + kGemmNB : N;
+            int64_t j = jc;
+            for (; j + NR <= jc1; j += NR) i8_rows<NR>(xq, xs, W, y, i0, i1, j, D_out, corr + (j - jc), ep);
+            for (; j < jc1; ++j) i8_rows<1>(xq, xs, W, y, i0, i1, j, D_out, corr + (j - jc), ep);
+        }
+    }
+}
+
+template <DType XT, DType WT> struct GemvK { static constexpr GemvFn fn = &gemv<XT, WT>; };
+template <DType XT, DType WT> struct GemmK { static constexpr GemmFn fn = &gemm<XT, WT>; };
+template <DType XT, DType WT> struct GatedK { static constexpr GatedGemvFn fn = &gated_gemv<XT, WT>; };
+template <DType XT> struct GemvK<XT, DType::Q4> { static constexpr GemvFn fn = &gemv_q4<XT>; };
+template <DType XT> struct GemmK<XT, DType::Q4> { static constexpr GemmFn fn = &gemm_q4<XT>; };
+template <DType XT> struct GatedK<XT, DType::Q4> { static constexpr GatedGemvFn fn = &gated_gemv_q4<XT>; };
+
+template <template <DType, DType> class K, DType XT, typename Fn>
+constexpr void fill_row(Fn (&row)[kWTypes]) {
+    row[0] = K<XT, DType::F32>::fn;
+    row[1] = K<XT, DType::F16>::fn;
+    row[2] = K<XT, DType::BF16>::fn;
+    row[3] = K<XT, DType::I8>::fn;
+    row[4] = K<XT, DType::Q4>::fn;
+}
+
+template <template <DType, DType> class K, typename Fn>
+constexpr void fill_grid(Fn (&grid)[kXTypes][kWTypes]) {
+    fill_row<K, DType::F32>(grid[0]);
+    fill_row<K, DType::F16>(grid[1]);
+    fill_row<K, DType::BF16>(grid[2]);
+}
+
+constexpr KernelTable make_table(Isa isa) {
+    KernelTable t{};
+    t.isa = isa;
+    t.pack_k = kPackK;
+    fill_grid<GemvK>(t.gemv);
+    fill_grid<GemmK>(t.gemm);
+    fill_grid<GatedK>(t.gated);
+    t.gemm_i8 = &gemm_i8;
+#if defined(IE_KERNEL_VNNI)
+    t.vnni = true;
+#endif
+    t.activation = &act_fn;
+    return t;
+}
+
+} // namespace
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
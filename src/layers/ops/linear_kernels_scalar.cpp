@@ -0,0 +1,16 @@
+// Scalar kernels, built for the baseline target; always available.
+#define IE_KERNEL_LEVEL 0
+#include "linear_kernels_impl.hpp"
+
+namespace ie {
+namespace ops {
+namespace kernels {
+
+const KernelTable* kernel_table_scalar() {
+    static constexpr KernelTable table = make_table(Isa::Scalar);
+    return &table;
+}
+
+} // namespace kernels
+} // namespace ops
+} // namespace ie
@@ -1,6 +1,8 @@
 #include "infer_engine/layers/ops/rope.hpp"
 #include "infer_engine/core/tensor.hpp"
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
 #include <tuple>
 
 namespace ie {
@@ -71,5 +73,52 @@ std::tuple<Tensor, Tensor> rope_apply(
     return std::make_tuple(std::move(q_out_t), std::move(k_out_t));
 }
 
+RopeTable::RopeTable(int64_t rotary_dim, float theta, int64_t n_pos, int64_t max_pos)
+    : rotary_dim_(rotary_dim), theta_(theta), max_pos_(max_pos) {
+    if (rotary_dim <= 0 || rotary_dim % 2 != 0) {
+        throw std::invalid_argument("RopeTable: rotary_dim must be positive and even");
+    }
+    reserve(n_pos);
+}
+
+void RopeTable::compute_row(int64_t rotary_dim, float theta, int64_t pos, float* out) {
+    for (int64_t i = 0; i < rotary_dim / 2; ++i) {
+        // Angles in double: at long context p * freq needs more than float's 24 bits
+        const double inv_freq = std::pow(static_cast<double>(theta), -2.0 * static_cast<double>(i) / static_cast<double>(rotary_dim));
+        const double angle = static_cast<double>(pos) * inv_freq;
+        out[2 * i + 0] = static_cast<float>(std::cos(angle));
+        out[2 * i + 1] = static_cast<float>(std::sin(angle));
+    }
+}
+
+void RopeTable::reserve(int64_t n_pos) {
+    if (n_pos <= n_pos_) return;
+    if (max_pos_ > 0 && n_pos > max_pos_) {
+        throw std::out_of_range("RopeTable: position past max_pos");
+    }
+    int64_t grown = std::max(n_pos, 2 * n_pos_);
+    if (max_pos_ > 0) grown = std::min(grown, max_pos_);
+    cs_.resize(static_cast<size_t>(grown * rotary_dim_));
+    for (int64_t p = n_pos_; p < grown; ++p) compute_row(rotary_dim_, theta_, p, cs_.data() + p * rotary_dim_);
+    n_pos_ = grown;
+}
+
+void rope_rotate_inplace(float* x, int64_t n_pos, int64_t n_heads, int64_t head_dim,
+                         int64_t rotary_dim, const float* cs, int64_t row_stride) {
+    const int64_t pairs = rotary_dim / 2;
+    if (row_stride == 0) row_stride = n_heads * head_dim;
+    for (int64_t p = 0; p < n_pos; ++p) {
+        const float* c = cs + p * rotary_dim;
+        for (int64_t h = 0; h < n_heads; ++h) {
+            float* v = x + p * row_stride + h * head_dim;
+            for (int64_t i = 0; i < pairs; ++i) {
+                const float a = v[2 * i + 0], b = v[2 * i + 1];
+                v[2 * i + 0] = a * c[2 * i + 0] - b * c[2 * i + 1];
+                v[2 * i + 1] = a * c[2 * i + 1] + b * c[2 * i + 0];
+            }
+        }
+    }
+}
+
 } // namespace ops
 } // namespace ie
@@ -44,13 +44,13 @@ Tensor softmax(const TensorView& x, int axis) {
         float sum_exp = 0.0f;
         for (int64_t col = 0; col < cols; ++col) {
             float shifted = row_input[col] - max_val;
-            sum_exp += std::expf(shifted);
+            sum_exp += std::exp(shifted);
         }
         
         // Step 3: Normalize
         for (int64_t col = 0; col < cols; ++col) {
             float shifted = row_input[col] - max_val;
-            row_output[col] = std::expf(shifted) / sum_exp;
+            row_output[col] = std::exp(shifted) / sum_exp;
         }
     }
     
@@ -1,4 +1,6 @@
 #include "infer_engine/model/weights.hpp"
+#include "infer_engine/layers/ops/rope.hpp"
+#include <mutex>
 #include <stdexcept>
 
 namespace ie {
@@ -31,5 +33,25 @@ LayerWeightsCXX ModelWeights::get_layer_weights(int64_t layer_idx) const {
     return layers_[static_cast<size_t>(layer_idx)];
 }
 
-} // namespace ie
+struct ModelWeights::RopeTables {
+    std::mutex mu;
+    std::vector<std::shared_ptr<const ops::RopeTable>> tables;  // one per (rotary_dim, theta)
+};
+
+std::shared_ptr<ModelWeights::RopeTables> ModelWeights::make_rope_tables() {
+    return std::make_shared<RopeTables>();
+}
 
+std::shared_ptr<const ops::RopeTable> ModelWeights::rope_table(int64_t rotary_dim, float theta, int64_t n_pos) const {
+    std::lock_guard<std::mutex> lock(rope_tables_->mu);
+    for (auto& table : rope_tables_->tables) {
+        if (table->rotary_dim() != rotary_dim || table->theta() != theta) continue;
+        // Tables are never written once shared: holders of a shorter one keep it
+        if (table->size() < n_pos) table = std::make_shared<const ops::RopeTable>(rotary_dim, theta, n_pos, n_pos);
+        return table;
+    }
+    rope_tables_->tables.push_back(std::make_shared<const ops::RopeTable>(rotary_dim, theta, n_pos, n_pos));
+    return rope_tables_->tables.back();
+}
+
+} // namespace ie
@@ -1,37 +1,187 @@
 #include "infer_engine/runtime/kv_cache.hpp"
+#include "infer_engine/core/thread_pool.hpp"
+#include "infer_engine/io/safetensors_reader.hpp"
+#include "infer_engine/io/safetensors_writer.hpp"
+#include "../layers/ops/kv_kernels.hpp"
+#include <algorithm>
 #include <stdexcept>
+#include <cmath>
 #include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <cassert>
+#include <climits>
+#include <string>
 namespace ie {
 
+// K and V stores of `shape` (last dim head_dim) plus, for I8 / F8, F32 scales
+// of the leading dims, each page aligned in one lazily committed region
+static KVStorage make_kv_storage(const std::vector<int64_t>& shape, DType dt, bool huge_pages) {
+    constexpr size_t kAlign = 4096;
+    auto align = [](size_t n) { return (n + kAlign - 1) / kAlign * kAlign; };
+    const std::vector<int64_t> scale_shape(shape.begin(), shape.end() - 1);
+    const size_t store_bytes = align(dtype_nbytes(dt, Shape{shape}.numel()));
+    const size_t scale_bytes = kv_dtype_scaled(dt) ? align(dtype_nbytes(DType::F32, Shape{scale_shape}.numel())) : 0;
+    KVStorage st;
+    st.mem = LazyRegion(2 * (store_bytes + scale_bytes), huge_pages);
+    auto* base = static_cast<uint8_t*>(st.mem.data());
+    st.k = make_view(base, dt, shape);
+    st.v = make_view(base + store_bytes, dt, shape);
+    if (scale_bytes > 0) {
+        st.k_scale = make_view(base + 2 * store_bytes, DType::F32, scale_shape);
+        st.v_scale = make_view(base + 2 * store_bytes + scale_bytes, DType::F32, scale_shape);
+    }
+    return st;
+}
+
 KVCache::KVCache(const KVCacheConfig& cfg) : cfg_(cfg) {
-    // Allocate k_store_ and v_store_ with shape:
-    // [num_layers, max_seq_len, num_kv_heads, head_dim] for GQA support
-    std::vector<int64_t> shape{cfg_.num_layers, cfg_.max_seq_len, cfg_.num_kv_heads, cfg_.head_dim};
-    k_store_ = Tensor::empty(shape, cfg_.dtype);
-    v_store_ = Tensor::empty(shape, cfg_.dtype);
+    if (cfg_.dtype != DType::F32 && cfg_.dtype != DType::F16 && !kv_dtype_scaled(cfg_.dtype)) {
+        throw std::invalid_argument(std::string("KV cache dtype must be F32, F16, I8 or F8, got ") + dtype_name(cfg_.dtype));
+    }
+    // K/V stores with shape [num_layers, max_seq_len, num_kv_heads, head_dim]
+    // for GQA support (head-major: seq and kv_heads swapped), reserved now and
+    // committed as positions are appended
+    const bool head_major = cfg_.layout == KVLayout::HeadMajor;
+    store_ = make_kv_storage({cfg_.num_layers, head_major ? cfg_.num_kv_heads : cfg_.max_seq_len,
+                              head_major ? cfg_.max_seq_len : cfg_.num_kv_heads, cfg_.head_dim},
+                             cfg_.dtype, cfg_.huge_pages);
+    filled_.assign(static_cast<size_t>(cfg_.num_layers), 0);
 
-    // Log expected memory usage
+    // Log expected memory usage (scales add 4 bytes per head row)
     const double elem_bytes = static_cast<double>(dtype_bytes(cfg_.dtype));
+    const double row_bytes = static_cast<double>(cfg_.head_dim) * elem_bytes
+        + (kv_dtype_scaled(cfg_.dtype) ? sizeof(float) : 0.0);
     const double total_bytes = 2.0 * static_cast<double>(cfg_.num_layers)
         * static_cast<double>(cfg_.max_seq_len)
-        * static_cast<double>(cfg_.num_kv_heads)
-        * static_cast<double>(cfg_.head_dim) * elem_bytes;
+        * static_cast<double>(cfg_.num_kv_heads) * row_bytes;
     const double total_gb = total_bytes / (1024.0 * 1024.0 * 1024.0);
     std::cout << std::fixed << std::setprecision(2)
               << "[KVCache] layers=" << cfg_.num_layers
               << " seq=" << cfg_.max_seq_len
               << " kv_heads=" << cfg_.num_kv_heads
               << " head_dim=" << cfg_.head_dim
-              << " dtype=" << (cfg_.dtype == DType::F16 ? "F16" : "F32")
-              << " -> expected ~" << total_gb << " GB" << std::endl;
+              << " dtype=" << dtype_name(cfg_.dtype)
+              << " -> reserved ~" << total_gb << " GB, committed on use" << std::endl;
+}
+
+KVBlockPool::KVBlockPool(const KVCacheConfig& cfg, int64_t block_size, int64_t num_blocks) : cfg_(cfg) {
+    if (cfg_.dtype != DType::F32 && cfg_.dtype != DType::F16 && !kv_dtype_scaled(cfg_.dtype)) {
+        throw std::invalid_argument(std::string("KV cache dtype must be F32, F16, I8 or F8, got ") + dtype_name(cfg_.dtype));
+    }
+    if (block_size <= 0 || num_blocks <= 0 || num_blocks > INT32_MAX) {
+        throw std::invalid_argument("KV block pool needs a positive block_size and num_blocks");
+    }
+    while ((int64_t{1} << block_shift_) < block_size) ++block_shift_;
+    block_size_ = int64_t{1} << block_shift_;
+    num_blocks_ = num_blocks;
+    cfg_.max_seq_len = block_size_;
+
+    const bool head_major = cfg_.layout == KVLayout::HeadMajor;
+    store_ = make_kv_storage({num_blocks_, cfg_.num_layers, head_major ? cfg_.num_kv_heads : block_size_,
+                              head_major ? block_size_ : cfg_.num_kv_heads, cfg_.head_dim},
+                             cfg_.dtype, cfg_.huge_pages);
+    // Handed out lowest id first
+    refs_.assign(static_cast<size_t>(num_blocks_), 0);
+    free_.reserve(static_cast<size_t>(num_blocks_));
+    for (int64_t b = num_blocks_ - 1; b >= 0; --b) free_.push_back(static_cast<int32_t>(b));
+
+    const double bytes = static_cast<double>(store_.mem.reserved_bytes());
+    std::cout << std::fixed << std::setprecision(2)
+              << "[KVBlockPool] blocks=" << num_blocks_ << " x " << block_size_ << " positions"
+              << " layers=" << cfg_.num_layers
+              << " kv_heads=" << cfg_.num_kv_heads
+              << " head_dim=" << cfg_.head_dim
+              << " dtype=" << dtype_name(cfg_.dtype)
+              << " -> reserved ~" << bytes / (1024.0 * 1024.0 * 1024.0) << " GB, committed on use" << std::endl;
+}
+
+int32_t KVBlockPool::allocate() {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (free_.empty()) return -1;
+    const int32_t b = free_.back();
+    free_.pop_back();
+    refs_[static_cast<size_t>(b)] = 1;
+    return b;
+}
+
+void KVBlockPool::retain(int32_t block) {
+    std::lock_guard<std::mutex> lock(mu_);
+    ++refs_[static_cast<size_t>(block)];
+}
+
+void KVBlockPool::release(int32_t block) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (--refs_[static_cast<size_t>(block)] == 0) free_.push_back(block);
+}
+
+int32_t KVBlockPool::ref_count(int32_t block) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return refs_[static_cast<size_t>(block)];
+}
+
+int64_t KVBlockPool::num_free() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return static_cast<int64_t>(free_.size());
+}
+
+KVCache::KVCache(std::shared_ptr<KVBlockPool> pool, int64_t max_seq_len) : pool_(std::move(pool)) {
+    if (!pool_) throw std::invalid_argument("KVCache: null block pool");
+    const int64_t capacity = pool_->num_blocks() * pool_->block_size();
+    cfg_ = pool_->config();
+    cfg_.max_seq_len = (max_seq_len > 0) ? std::min(max_seq_len, capacity) : capacity;
+    filled_.assign(static_cast<size_t>(cfg_.num_layers), 0);
+}
+
+KVCache::~KVCache() {
+    if (pool_) clear();
+}
+
+void KVCache::reserve(int64_t n_pos) {
+    if (!pool_) return;
+    const int64_t B = pool_->block_size();
+    const size_t needed = static_cast<size_t>((n_pos + B - 1) / B);
+    while (block_table_.size() < needed) {
+        const int32_t b = pool_->allocate();
+        if (b < 0) throw std::runtime_error("KV block pool exhausted");
+        block_table_.push_back(b);
+    }
+}
+
+void KVCache::clear() {
+    std::fill(filled_.begin(), filled_.end(), 0);
+    if (!pool_) {
+        store_.mem.decommit();
+        return;
+    }
+    for (int32_t b : block_table_) pool_->release(b);
+    block_table_.clear();
+}
+
+void KVCache::truncate(int64_t n_pos) {
+    n_pos = std::max<int64_t>(n_pos, 0);
+    for (int64_t& filled : filled_) filled = std::min(filled, n_pos);
+    if (!pool_) return;
+    const size_t keep = static_cast<size_t>((n_pos + pool_->block_size() - 1) / pool_->block_size());
+    while (block_table_.size() > keep) {
+        pool_->release(block_table_.back());
+        block_table_.pop_back();
+    }
 }
 
-static inline size_t kv_offset(int64_t L, int64_t S, int64_t KVH, int64_t D,
-                               int64_t l, int64_t pos, int64_t kvh, int64_t d) {
-    return static_cast<size_t>(((((uint64_t)l) * S + pos) * KVH + kvh) * (uint64_t)D + d);
+void KVCache::attach_blocks(const std::vector<int32_t>& blocks) {
+    adopt_blocks(blocks);
+    for (int32_t b : block_table_) pool_->retain(b);
+}
+
+void KVCache::adopt_blocks(const std::vector<int32_t>& blocks) {
+    if (!pool_ || !block_table_.empty()) {
+        throw std::logic_error("attaching blocks needs an empty paged cache");
+    }
+    if (static_cast<int64_t>(blocks.size()) * pool_->block_size() > cfg_.max_seq_len) {
+        throw std::out_of_range("attached blocks exceed max_seq_len");
+    }
+    block_table_ = blocks;
+    std::fill(filled_.begin(), filled_.end(), static_cast<int64_t>(blocks.size()) * pool_->block_size());
 }
 
 void KVCache::append(int64_t layer_idx, int64_t seq_pos, const TensorView& K, const TensorView& V) {
@@ -42,7 +192,7 @@ void KVCache::append(int64_t layer_idx, int64_t seq_pos, const TensorView& K, co
     if (seq_pos < 0 || seq_pos >= cfg_.max_seq_len) {
         throw std::out_of_range("seq_pos out of bounds");
     }
-    
+
     // Shape check - K,V should have kv_heads, not q_heads
     if (K.shape.size() != 2 || K.shape[0] != cfg_.num_kv_heads || K.shape[1] != cfg_.head_dim) {
         throw std::invalid_argument("K shape mismatch");
@@ -50,46 +200,327 @@ void KVCache::append(int64_t layer_idx, int64_t seq_pos, const TensorView& K, co
     if (V.shape.size() != 2 || V.shape[0] != cfg_.num_kv_heads || V.shape[1] != cfg_.head_dim) {
         throw std::invalid_argument("V shape mismatch");
     }
+    write_rows(layer_idx, seq_pos, 1, K, V);
+}
+
+void KVCache::append_range(int64_t layer_idx, int64_t start_pos, const TensorView& K, const TensorView& V) {
+    if (layer_idx < 0 || layer_idx >= cfg_.num_layers) {
+        throw std::out_of_range("layer_idx out of bounds");
+    }
+    if (K.shape.size() != 3 || K.shape[1] != cfg_.num_kv_heads || K.shape[2] != cfg_.head_dim) {
+        throw std::invalid_argument("K shape mismatch");
+    }
+    if (V.shape != K.shape) {
+        throw std::invalid_argument("V shape mismatch");
+    }
+    for (const TensorView* t : {&K, &V}) {
+        if (t->stride.size() != 3 || t->stride[2] != 1 || t->stride[1] != cfg_.head_dim ||
+            t->stride[0] < cfg_.num_kv_heads * cfg_.head_dim) {
+            throw std::invalid_argument("K/V heads must be contiguous within each position");
+        }
+    }
+    const int64_t n_pos = K.shape[0];
+    if (start_pos < 0 || n_pos < 0 || start_pos + n_pos > cfg_.max_seq_len) {
+        throw std::out_of_range("seq_pos out of bounds");
+    }
+    write_rows(layer_idx, start_pos, n_pos, K, V);
+}
+
+void KVCache::unshare_blocks(int64_t start_pos, int64_t n_pos) {
+    if (!pool_ || n_pos <= 0) return;
+    const int64_t B = pool_->block_size();
+    // A block holds every layer's rows for its positions, one contiguous run
+    const size_t block_rows = static_cast<size_t>(cfg_.num_layers * B * cfg_.num_kv_heads);
+    const size_t row_bytes = static_cast<size_t>(cfg_.head_dim) * dtype_bytes(cfg_.dtype);
+    KVStorage& st = pool_->store_;
+    for (int64_t i = start_pos / B; i <= (start_pos + n_pos - 1) / B; ++i) {
+        int32_t& b = block_table_[static_cast<size_t>(i)];
+        if (pool_->ref_count(b) == 1) continue;
+        const int32_t own = pool_->allocate();
+        if (own < 0) throw std::runtime_error("KV block pool exhausted");
+        const size_t src = static_cast<size_t>(b) * block_rows, dst = static_cast<size_t>(own) * block_rows;
+        for (TensorView* t : {&st.k, &st.v}) {
+            auto* base = t->ptr<uint8_t>();
+            std::memcpy(base + dst * row_bytes, base + src * row_bytes, block_rows * row_bytes);
+        }
+        if (kv_dtype_scaled(cfg_.dtype)) {
+            for (TensorView* t : {&st.k_scale, &st.v_scale}) {
+                float* base = t->ptr<float>();
+                std::memcpy(base + dst, base + src, block_rows * sizeof(float));
+            }
+        }
+        pool_->release(b);
+        b = own;
+    }
+}
+
+void KVCache::write_rows(int64_t layer_idx, int64_t start_pos, int64_t n_pos, const TensorView& K, const TensorView& V) {
+    const bool copy = (K.dt == cfg_.dtype && !kv_dtype_scaled(cfg_.dtype));
+    const bool convert = (K.dt == DType::F32 && !copy);
+    if (K.dt != V.dt || !(copy || convert)) {
+        throw std::invalid_argument(std::string("K/V must be F32 or the cache dtype ") + dtype_name(cfg_.dtype));
+    }
 
+    reserve(start_pos + n_pos);
+    unshare_blocks(start_pos, n_pos);
+    int64_t& filled = filled_[static_cast<size_t>(layer_idx)];
+    if (start_pos <= filled) filled = std::max(filled, start_pos + n_pos);
     const int64_t KVH = cfg_.num_kv_heads;
     const int64_t D   = cfg_.head_dim;
-    const int64_t S   = cfg_.max_seq_len;
-
-    assert(seq_pos >= 0 && seq_pos < S);
 
-    auto* kd = k_store_.view.ptr<uint8_t>();
-    auto* vd = v_store_.view.ptr<uint8_t>();
+    auto* kd = k_view().ptr<uint8_t>();
+    auto* vd = v_view().ptr<uint8_t>();
+    float* ksc = kv_dtype_scaled(cfg_.dtype) ? k_scales().ptr<float>() : nullptr;
+    float* vsc = kv_dtype_scaled(cfg_.dtype) ? v_scales().ptr<float>() : nullptr;
     const auto* ks = K.ptr<const uint8_t>();
     const auto* vs = V.ptr<const uint8_t>();
     const size_t elem_b = dtype_bytes(cfg_.dtype); // 2 for F16
     const size_t row_bytes = static_cast<size_t>(D) * elem_b;
+    const size_t src_row_bytes = static_cast<size_t>(D) * dtype_bytes(K.dt);
+    // Source bytes from one position to the next (strided for fused QKV rows)
+    const size_t k_pos_bytes = (K.rank() == 3 ? static_cast<size_t>(K.stride[0]) : static_cast<size_t>(KVH * D)) * dtype_bytes(K.dt);
+    const size_t v_pos_bytes = (V.rank() == 3 ? static_cast<size_t>(V.stride[0]) : static_cast<size_t>(KVH * D)) * dtype_bytes(V.dt);
+    // F32 rows are converted to the cache dtype by the active ISA's kernel
+    const auto store_row = ops::kernels::select_store_row(cfg_.dtype);
+
+    for (int64_t p = 0; p < n_pos; ++p) {
+        for (int64_t kvh = 0; kvh < KVH; ++kvh) {
+            const size_t row = row_index(layer_idx, start_pos + p, kvh);
+            const size_t k_src = static_cast<size_t>(p) * k_pos_bytes + static_cast<size_t>(kvh) * src_row_bytes;
+            const size_t v_src = static_cast<size_t>(p) * v_pos_bytes + static_cast<size_t>(kvh) * src_row_bytes;
+            if (copy) {
+                std::memcpy(kd + row * row_bytes, ks + k_src, row_bytes);
+                std::memcpy(vd + row * row_bytes, vs + v_src, row_bytes);
+                continue;
+            }
+            const float k_scale = store_row(reinterpret_cast<const float*>(ks + k_src), D, kd + row * row_bytes);
+            const float v_scale = store_row(reinterpret_cast<const float*>(vs + v_src), D, vd + row * row_bytes);
+            if (ksc) {
+                ksc[row] = k_scale;
+                vsc[row] = v_scale;
+            }
+        }
+    }
+}
+
+// Safetensors dtype strings of the KV dtypes (F8 is E4M3)
+static const char* snapshot_dtype_name(DType dt) {
+    switch (dt) {
+        case DType::F32: return "F32";
+        case DType::F16: return "F16";
+        case DType::I8: return "I8";
+        case DType::F8: return "F8_E4M3";
+        default: throw std::invalid_argument(std::string("KV snapshot dtype must be F32, F16, I8 or F8, got ") + dtype_name(dt));
+    }
+}
+
+static DType snapshot_dtype(const std::string& name) {
+    if (name == "F32") return DType::F32;
+    if (name == "F16") return DType::F16;
+    if (name == "I8") return DType::I8;
+    if (name == "F8_E4M3") return DType::F8;
+    throw std::runtime_error("KV snapshot: unsupported row dtype " + name);
+}
+
+static std::string snapshot_name(int64_t layer_idx, bool v, bool scale) {
+    return "layers." + std::to_string(layer_idx) + (v ? ".v" : ".k") + (scale ? "_scale" : "");
+}
+
+size_t KVCache::save(const std::string& path, int64_t n_pos, const KVSnapshotOptions& opts) const {
+    if (n_pos < 0 || n_pos > cfg_.max_seq_len) {
+        throw std::out_of_range("KV snapshot: n_pos out of bounds");
+    }
+    if (pool_ && n_pos > static_cast<int64_t>(block_table_.size()) * pool_->block_size()) {
+        throw std::out_of_range("KV snapshot: positions beyond the allocated blocks");
+    }
+    if (opts.quantize && !kv_dtype_scaled(opts.quant_dtype)) {
+        throw std::invalid_argument("KV snapshot: quant_dtype must be I8 or F8");
+    }
+    if (!opts.tokens.empty() && static_cast<int64_t>(opts.tokens.size()) != n_pos) {
+        throw std::invalid_argument("KV snapshot: need one token id per position");
+    }
+    const DType file_dt = opts.quantize ? opts.quant_dtype : cfg_.dtype;
+    const bool copy = (file_dt == cfg_.dtype);
+    const bool scaled = kv_dtype_scaled(file_dt);
+    const int64_t L = cfg_.num_layers;
+    const int64_t KVH = cfg_.num_kv_heads;
+    const int64_t D = cfg_.head_dim;
+    const size_t src_row = static_cast<size_t>(D) * dtype_bytes(cfg_.dtype);
+    const size_t dst_row = static_cast<size_t>(D) * dtype_bytes(file_dt);
+    const size_t n_rows = static_cast<size_t>(n_pos * KVH);
+
+    const auto load_row = ops::kernels::select_load_row(cfg_.dtype);
+    const auto store_row = ops::kernels::select_store_row(file_dt);
 
-    for (int64_t kvh = 0; kvh < KVH; ++kvh) {
-        assert(kvh >= 0 && kvh < KVH);
-        const size_t dst_index = kv_offset(cfg_.num_layers, S, KVH, D, layer_idx, seq_pos, kvh, 0);
-        uint8_t* kdst = kd + dst_index * elem_b;
-        uint8_t* vdst = vd + dst_index * elem_b;
+    // Gather each [layer][K|V] into position order; buffers live until write()
+    std::vector<std::vector<uint8_t>> rows(static_cast<size_t>(2 * L));
+    std::vector<std::vector<float>> scales(static_cast<size_t>(2 * L));
+    parallel_for(2 * L, [&](int64_t i) {
+        const int64_t layer_idx = i / 2;
+        const bool v = (i & 1) != 0;
+        const auto* store = (v ? v_view() : k_view()).ptr<const uint8_t>();
+        const float* sc = kv_dtype_scaled(cfg_.dtype) ? (v ? v_scales() : k_scales()).ptr<const float>() : nullptr;
+        std::vector<uint8_t>& out = rows[static_cast<size_t>(i)];
+        std::vector<float>& out_sc = scales[static_cast<size_t>(i)];
+        out.resize(n_rows * dst_row);
+        out_sc.resize(scaled ? n_rows : 0);
+        std::vector<float> tmp(static_cast<size_t>(D));
+        for (int64_t p = 0; p < n_pos; ++p) {
+            for (int64_t kvh = 0; kvh < KVH; ++kvh) {
+                const size_t row = row_index(layer_idx, p, kvh);
+                const size_t j = static_cast<size_t>(p * KVH + kvh);
+                if (copy) {
+                    std::memcpy(out.data() + j * dst_row, store + row * src_row, src_row);
+                    if (scaled) out_sc[j] = sc[row];
+                    continue;
+                }
+                load_row(store + row * src_row, D, sc ? sc[row] : 1.0f, tmp.data());
+                const float s = store_row(tmp.data(), D, out.data() + j * dst_row);
+                if (scaled) out_sc[j] = s;
+            }
+        }
+    });
 
-        const uint8_t* ksrc = ks + static_cast<size_t>(kvh) * row_bytes;
-        const uint8_t* vsrc = vs + static_cast<size_t>(kvh) * row_bytes;
+    SafeTensorWriter writer;
+    for (int64_t i = 0; i < 2 * L; ++i) {
+        const std::vector<uint8_t>& r = rows[static_cast<size_t>(i)];
+        writer.add_tensor(snapshot_name(i / 2, i & 1, false), snapshot_dtype_name(file_dt), {n_pos, KVH, D}, r.data(), r.size());
+        if (scaled) {
+            const std::vector<float>& s = scales[static_cast<size_t>(i)];
+            writer.add_tensor(snapshot_name(i / 2, i & 1, true), "F32", {n_pos, KVH}, s.data(), s.size() * sizeof(float));
+        }
+    }
+    if (!opts.tokens.empty()) {
+        writer.add_tensor("tokens", "I32", {n_pos}, opts.tokens.data(), opts.tokens.size() * sizeof(int32_t));
+    }
+    writer.set_metadata("format", "kv_snapshot");
+    writer.set_metadata("num_layers", std::to_string(L));
+    writer.set_metadata("num_kv_heads", std::to_string(KVH));
+    writer.set_metadata("head_dim", std::to_string(D));
+    writer.set_metadata("positions", std::to_string(n_pos));
+    return writer.write(path);
+}
 
-        // Debug log for per-step KV write
-        std::cout << "[KVWrite] l=" << layer_idx << " pos=" << seq_pos
-                  << " kvh=" << kvh << " bytes=" << row_bytes << std::endl;
+int64_t KVCache::load(const std::string& path, std::vector<int32_t>* tokens) {
+    SafeTensorReader reader(path);
+    const std::map<std::string, std::string>& meta = reader.metadata();
+    auto field = [&](const std::string& key) -> int64_t {
+        auto it = meta.find(key);
+        if (it == meta.end()) throw std::runtime_error("KV snapshot: missing metadata " + key);
+        return std::stoll(it->second);
+    };
+    auto format = meta.find("format");
+    if (format == meta.end() || format->second != "kv_snapshot") {
+        throw std::runtime_error("Not a KV snapshot: " + path);
+    }
+    const int64_t L = cfg_.num_layers;
+    const int64_t KVH = cfg_.num_kv_heads;
+    const int64_t D = cfg_.head_dim;
+    if (field("num_layers") != L || field("num_kv_heads") != KVH || field("head_dim") != D) {
+        throw std::invalid_argument("KV snapshot shape does not match the cache");
+    }
+    const int64_t n_pos = field("positions");
+    if (n_pos < 0 || n_pos > cfg_.max_seq_len) {
+        throw std::out_of_range("KV snapshot: positions exceed max_seq_len");
+    }
 
-        std::memcpy(kdst, ksrc, row_bytes);
-        std::memcpy(vdst, vsrc, row_bytes);
+    // Resolve and check every tensor before touching the cache
+    struct Source {
+        DType dt;
+        const uint8_t* rows;
+        const float* scales;
+    };
+    std::vector<Source> sources(static_cast<size_t>(2 * L));
+    for (int64_t i = 0; i < 2 * L; ++i) {
+        const std::string name = snapshot_name(i / 2, i & 1, false);
+        const SafeTensorInfo& info = reader.get_tensor_info(name);
+        Source& src = sources[static_cast<size_t>(i)];
+        src.dt = snapshot_dtype(info.dtype);
+        if (info.shape != std::vector<int64_t>{n_pos, KVH, D}) {
+            throw std::runtime_error("KV snapshot: " + name + " has the wrong shape");
+        }
+        src.rows = static_cast<const uint8_t*>(reader.get_tensor_data(name));
+        src.scales = nullptr;
+        if (kv_dtype_scaled(src.dt)) {
+            const std::string scale_name = snapshot_name(i / 2, i & 1, true);
+            const SafeTensorInfo& sinfo = reader.get_tensor_info(scale_name);
+            if (sinfo.dtype != "F32" || sinfo.shape != std::vector<int64_t>{n_pos, KVH}) {
+                throw std::runtime_error("KV snapshot: " + scale_name + " must be F32 [positions, kv_heads]");
+            }
+            src.scales = static_cast<const float*>(reader.get_tensor_data(scale_name));
+        }
     }
+    if (tokens) {
+        tokens->clear();
+        if (reader.has_tensor("tokens")) {
+            const SafeTensorInfo& tinfo = reader.get_tensor_info("tokens");
+            if (tinfo.dtype != "I32" || tinfo.shape != std::vector<int64_t>{n_pos}) {
+                throw std::runtime_error("KV snapshot: tokens must be I32 [positions]");
+            }
+            const auto* ids = static_cast<const int32_t*>(reader.get_tensor_data("tokens"));
+            tokens->assign(ids, ids + n_pos);
+        }
+    }
+
+    if (pool_) clear();
+    reserve(n_pos);
+    const size_t dst_row = static_cast<size_t>(D) * dtype_bytes(cfg_.dtype);
+    const auto store_row = ops::kernels::select_store_row(cfg_.dtype);
+    parallel_for(2 * L, [&](int64_t i) {
+        const int64_t layer_idx = i / 2;
+        const bool v = (i & 1) != 0;
+        const Source& src = sources[static_cast<size_t>(i)];
+        auto* store = (v ? v_view() : k_view()).ptr<uint8_t>();
+        float* sc = kv_dtype_scaled(cfg_.dtype) ? (v ? v_scales() : k_scales()).ptr<float>() : nullptr;
+        const size_t src_row = static_cast<size_t>(D) * dtype_bytes(src.dt);
+        const bool copy = (src.dt == cfg_.dtype);
+        const auto load_row = copy ? nullptr : ops::kernels::select_load_row(src.dt);
+        std::vector<float> tmp(static_cast<size_t>(D));
+        for (int64_t p = 0; p < n_pos; ++p) {
+            for (int64_t kvh = 0; kvh < KVH; ++kvh) {
+                const size_t row = row_index(layer_idx, p, kvh);
+                const size_t j = static_cast<size_t>(p * KVH + kvh);
+                if (copy) {
+                    std::memcpy(store + row * dst_row, src.rows + j * src_row, src_row);
+                    if (sc) sc[row] = src.scales[j];
+                    continue;
+                }
+                load_row(src.rows + j * src_row, D, src.scales ? src.scales[j] : 1.0f, tmp.data());
+                const float s = store_row(tmp.data(), D, store + row * dst_row);
+                if (sc) sc[row] = s;
+            }
+        }
+    });
+    std::fill(filled_.begin(), filled_.end(), n_pos);
+    return n_pos;
 }
 
 TensorView KVCache::k_view() const {
-    return k_store_.view;
+    return pool_ ? pool_->store_.k : store_.k;
 }
 
 TensorView KVCache::v_view() const {
-    return v_store_.view;
+    return pool_ ? pool_->store_.v : store_.v;
 }
 
-} // namespace ie
+TensorView KVCache::k_scales() const {
+    return pool_ ? pool_->store_.k_scale : store_.k_scale;
+}
+
+TensorView KVCache::v_scales() const {
+    return pool_ ? pool_->store_.v_scale : store_.v_scale;
+}
 
+size_t KVCache::reserved_bytes() const {
+    return pool_ ? pool_->reserved_bytes() : store_.mem.reserved_bytes();
+}
+
+int64_t KVCache::filled() const {
+    return filled_.empty() ? 0 : *std::min_element(filled_.begin(), filled_.end());
+}
 
+size_t KVCache::committed_bytes() const {
+    return pool_ ? pool_->committed_bytes() : store_.mem.committed_bytes();
+}
+
+} // namespace ie
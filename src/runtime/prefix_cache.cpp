@@ -0,0 +1,118 @@
+#include "infer_engine/runtime/prefix_cache.hpp"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace ie {
+
+PrefixCache::PrefixCache(std::shared_ptr<KVBlockPool> pool, int64_t max_blocks)
+    : pool_(std::move(pool)), max_blocks_(max_blocks) {
+    if (!pool_) throw std::invalid_argument("PrefixCache: null block pool");
+}
+
+PrefixCache::~PrefixCache() {
+    // Drop the cache's reference to every block
+    std::vector<Node*> stack{&root_};
+    while (!stack.empty()) {
+        Node* n = stack.back();
+        stack.pop_back();
+        if (n->block >= 0) pool_->release(n->block);
+        for (auto& [key, child] : n->children) stack.push_back(child.get());
+    }
+}
+
+int64_t PrefixCache::match(const std::vector<int32_t>& tokens, int64_t max_tokens, std::vector<int32_t>& blocks) {
+    const int64_t B = pool_->block_size();
+    const int64_t limit = std::min<int64_t>(max_tokens, static_cast<int64_t>(tokens.size()));
+    std::lock_guard<std::mutex> lock(mu_);
+    blocks.clear();
+    const uint64_t now = ++tick_;
+    Node* node = &root_;
+    std::vector<int32_t> key(static_cast<size_t>(B));
+    for (int64_t t0 = 0; t0 + B <= limit; t0 += B) {
+        std::copy(tokens.begin() + t0, tokens.begin() + t0 + B, key.begin());
+        auto it = node->children.find(key);
+        if (it == node->children.end()) break;
+        node = it->second.get();
+        node->last_use = now;
+        pool_->retain(node->block);
+        blocks.push_back(node->block);
+    }
+    return static_cast<int64_t>(blocks.size()) * B;
+}
+
+void PrefixCache::insert(const std::vector<int32_t>& tokens, const KVCache& cache) {
+    const int64_t B = pool_->block_size();
+    const std::vector<int32_t>& table = cache.block_table();
+    // Only blocks whose positions were written in every layer: publishing
+    // tokens past what was fed (e.g. the last sampled one) must not cache a
+    // partly written block
+    const int64_t n_full = std::min({static_cast<int64_t>(tokens.size()), cache.filled(),
+                                     static_cast<int64_t>(table.size()) * B}) / B;
+    std::lock_guard<std::mutex> lock(mu_);
+    const uint64_t now = ++tick_;
+    Node* node = &root_;
+    for (int64_t i = 0; i < n_full; ++i) {
+        std::vector<int32_t> key(tokens.begin() + i * B, tokens.begin() + (i + 1) * B);
+        auto it = node->children.find(key);
+        if (it == node->children.end()) {
+            auto child = std::make_unique<Node>();
+            child->block = table[static_cast<size_t>(i)];
+            child->parent = node;
+            pool_->retain(child->block);
+            it = node->children.emplace(std::move(key), std::move(child)).first;
+            ++n_nodes_;
+        }
+        node = it->second.get();
+        node->last_use = now;
+    }
+    if (n_nodes_ > max_blocks_) evict_locked(n_nodes_ - max_blocks_);
+}
+
+int64_t PrefixCache::evict(int64_t n_blocks) {
+    std::lock_guard<std::mutex> lock(mu_);
+    return evict_locked(n_blocks);
+}
+
+int64_t PrefixCache::evict_locked(int64_t n_blocks) {
+    // Min-heap of evictable leaves by last use; a parent whose last child goes
+    // becomes a candidate itself
+    using Entry = std::pair<uint64_t, Node*>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> leaves;
+    auto evictable = [&](const Node* n) {
+        return n != &root_ && n->children.empty() && pool_->ref_count(n->block) == 1;
+    };
+    std::vector<Node*> stack{&root_};
+    while (!stack.empty()) {
+        Node* n = stack.back();
+        stack.pop_back();
+        if (evictable(n)) leaves.push({n->last_use, n});
+        for (auto& [key, child] : n->children) stack.push_back(child.get());
+    }
+    int64_t evicted = 0;
+    while (evicted < n_blocks && !leaves.empty()) {
+        Node* n = leaves.top().second;
+        leaves.pop();
+        Node* parent = n->parent;
+        pool_->release(n->block);
+        for (auto it = parent->children.begin(); it != parent->children.end(); ++it) {
+            if (it->second.get() == n) {
+                parent->children.erase(it);
+                break;
+            }
+        }
+        --n_nodes_;
+        ++evicted;
+        if (evictable(parent)) leaves.push({parent->last_use, parent});
+    }
+    return evicted;
+}
+
+int64_t PrefixCache::cached_blocks() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return n_nodes_;
+}
+
+} // namespace ie
@@ -4,94 +4,141 @@
 #include "infer_engine/layers/ops/rmsnorm.hpp"
 #include "infer_engine/layers/ops/linear.hpp"
 #include "infer_engine/model/weights.hpp"
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <cstdint>
+#include <utility>
 
 namespace ie {
 
-static void init_kv(std::unique_ptr<KVCache>& kv, const ModelCfg& cfg, int64_t max_seq_len) {
+static void init_kv(std::unique_ptr<KVCache>& kv, const ModelCfg& cfg, int64_t max_seq_len,
+                    DType kv_dtype = DType::F16, KVLayout kv_layout = KVLayout::SeqMajor) {
     KVCacheConfig kcfg;
     kcfg.num_layers = cfg.n_layers;
     kcfg.max_seq_len = (max_seq_len > 0 ? max_seq_len : 2048);
     kcfg.num_q_heads = cfg.n_heads;
     kcfg.num_kv_heads = cfg.n_kv_heads;
     kcfg.head_dim = cfg.d_model / cfg.n_heads;
-    kcfg.dtype = DType::F16; // fp16 KV cache
+    kcfg.dtype = kv_dtype; // fp16 by default; I8 / F8 store per-head scaled codes
+    kcfg.layout = kv_layout;
     kv = std::make_unique<KVCache>(kcfg);
     std::cout << "[Runtime] KV configured: L=" << kcfg.num_layers
               << " S=" << kcfg.max_seq_len
               << " KV_H=" << kcfg.num_kv_heads
               << " D=" << kcfg.head_dim
-              << " dtype=F16" << std::endl;
+              << " dtype=" << dtype_name(kcfg.dtype)
+              << " layout=" << (kv_layout == KVLayout::HeadMajor ? "head-major" : "seq-major") << std::endl;
 }
 
 RuntimeCtx::RuntimeCtx(const ModelCfg& cfg, const ModelWeights& weights)
     : cfg_(cfg), weights_(weights) {
     init_kv(kv_, cfg_, 2048);
+    init_rope();
 }
 
 RuntimeCtx::RuntimeCtx(const ModelCfg& cfg, const ModelWeights& weights, int64_t max_seq_len)
     : cfg_(cfg), weights_(weights) {
     init_kv(kv_, cfg_, max_seq_len);
+    init_rope();
 }
 
-Tensor RuntimeCtx::forward_decode(int32_t token_id, int64_t pos) {
-    // 1) Lookup token embedding -> x
-    if (token_id < 0 || token_id >= cfg_.vocab_size) {
-        throw std::out_of_range("Invalid token_id");
+RuntimeCtx::RuntimeCtx(const ModelCfg& cfg, const ModelWeights& weights, int64_t max_seq_len, DType kv_dtype,
+                       KVLayout kv_layout)
+    : cfg_(cfg), weights_(weights) {
+    init_kv(kv_, cfg_, max_seq_len, kv_dtype, kv_layout);
+    init_rope();
+}
+
+RuntimeCtx::RuntimeCtx(const ModelCfg& cfg, const ModelWeights& weights, std::shared_ptr<KVBlockPool> kv_pool,
+                       int64_t max_seq_len)
+    : cfg_(cfg), weights_(weights) {
+    const KVCacheConfig& pcfg = kv_pool->config();
+    if (pcfg.num_layers != cfg_.n_layers || pcfg.num_kv_heads != cfg_.n_kv_heads ||
+        pcfg.head_dim != cfg_.d_model / cfg_.n_heads) {
+        throw std::invalid_argument("KV block pool does not match the model config");
+    }
+    kv_ = std::make_unique<KVCache>(std::move(kv_pool), max_seq_len);
+    init_rope();
+}
+
+// Every position the KV cache can hold, from the table the model shares
+void RuntimeCtx::init_rope() {
+    const int64_t head_dim = cfg_.d_model / cfg_.n_heads;
+    const int64_t rotary_dim = cfg_.rope_dim > 0 ? cfg_.rope_dim : head_dim;
+    rope_ = weights_.rope_table(rotary_dim, cfg_.rope_theta, kv_->config().max_seq_len);
+}
+
+// Prompt tokens per prefill pass: bounds the [T, d_ff] MLP and [T, heads, D]
+// attention workspaces while keeping the projections GEMM-shaped
+static constexpr int64_t kPrefillChunk = 256;
+
+Tensor RuntimeCtx::forward_hidden(const int32_t* tokens, int64_t n_tokens, int64_t pos) {
+    // 1) Lookup token embeddings -> x [n_tokens, d_model]
+    for (int64_t t = 0; t < n_tokens; ++t) {
+        if (tokens[t] < 0 || tokens[t] >= cfg_.vocab_size) {
+            throw std::out_of_range("Invalid token_id");
+        }
+    }
+    if (pos < 0 || pos + n_tokens > kv_->config().max_seq_len) {
+        throw std::out_of_range("Sequence position out of KV cache range");
     }
     
-    // Get embedding for token_id: [d_model]
+    // Get embedding for each token: [d_model]
     TensorView embed_weights = weights_.get_token_embeddings();
-    Tensor x = Tensor::empty({cfg_.d_model}, DType::F32);
+    Tensor x = Tensor::empty({n_tokens, cfg_.d_model}, DType::F32);
     
-    // Copy embedding row for token_id with dtype awareness (F32/BF16)
-    if (embed_weights.dt == DType::F32) {
-        const float* embed_ptr = embed_weights.ptr<float>() + token_id * cfg_.d_model;
-        std::memcpy(x.view.data, embed_ptr, static_cast<size_t>(cfg_.d_model) * sizeof(float));
-    } else if (embed_weights.dt == DType::BF16) {
-        auto bf16_to_f32 = [](uint16_t h) -> float {
-            union { uint32_t u; float f; } out;
-            out.u = static_cast<uint32_t>(h) << 16;
-            return out.f;
-        };
-        const uint16_t* row = embed_weights.ptr<const uint16_t>() + token_id * cfg_.d_model;
-        float* dst = x.view.ptr<float>();
-        for (int64_t d = 0; d < cfg_.d_model; ++d) dst[d] = bf16_to_f32(row[d]);
-    } else if (embed_weights.dt == DType::F16) {
-        // Simple F16->F32 converter (rounding not exact, acceptable for now)
-        auto f16_to_f32 = [](uint16_t h) -> float {
-            uint32_t sign = (h & 0x8000) << 16;
-            uint32_t exp = (h & 0x7C00) >> 10;
-            uint32_t mant = (h & 0x03FF);
-            uint32_t f;
-            if (exp == 0) {
-                if (mant == 0) {
-                    f = sign; // zero
+    // Copy embedding rows with dtype awareness (F32/BF16/F16)
+    for (int64_t t = 0; t < n_tokens; ++t) {
+        const int64_t token_id = tokens[t];
+        float* dst = x.view.ptr<float>() + t * cfg_.d_model;
+        if (embed_weights.dt == DType::F32) {
+            const float* embed_ptr = embed_weights.ptr<float>() + token_id * cfg_.d_model;
+            std::memcpy(dst, embed_ptr, static_cast<size_t>(cfg_.d_model) * sizeof(float));
+        } else if (embed_weights.dt == DType::BF16) {
+            auto bf16_to_f32 = [](uint16_t h) -> float {
+                union { uint32_t u; float f; } out;
+                out.u = static_cast<uint32_t>(h) << 16;
+                return out.f;
+            };
+            const uint16_t* row = embed_weights.ptr<const uint16_t>() + token_id * cfg_.d_model;
+            for (int64_t d = 0; d < cfg_.d_model; ++d) dst[d] = bf16_to_f32(row[d]);
+        } else if (embed_weights.dt == DType::F16) {
+            // Simple F16->F32 converter (rounding not exact, acceptable for now)
+            auto f16_to_f32 = [](uint16_t h) -> float {
+                uint32_t sign = (h & 0x8000) << 16;
+                uint32_t exp = (h & 0x7C00) >> 10;
+                uint32_t mant = (h & 0x03FF);
+                uint32_t f;
+                if (exp == 0) {
+                    if (mant == 0) {
+                        f = sign; // zero
+                    } else {
+                        // subnormal
+                        exp = 127 - 15 + 1;
+                        while ((mant & 0x0400) == 0) { mant <<= 1; exp--; }
+                        mant &= 0x03FF;
+                        f = sign | (exp << 23) | (mant << 13);
+                    }
+                } else if (exp == 0x1F) {
+                    f = sign | 0x7F800000 | (mant << 13); // inf/NaN
                 } else {
-                    // subnormal
-                    exp = 127 - 15 + 1;
-                    while ((mant & 0x0400) == 0) { mant <<= 1; exp--; }
-                    mant &= 0x03FF;
+                    exp = exp - 15 + 127;
                     f = sign | (exp << 23) | (mant << 13);
                 }
-            } else if (exp == 0x1F) {
-                f = sign | 0x7F800000 | (mant << 13); // inf/NaN
-            } else {
-                exp = exp - 15 + 127;
-                f = sign | (exp << 23) | (mant << 13);
-            }
-            union { uint32_t u; float f; } out{f};
-            return out.f;
-        };
-        const uint16_t* row = embed_weights.ptr<const uint16_t>() + token_id * cfg_.d_model;
-        float* dst = x.view.ptr<float>();
-        for (int64_t d = 0; d < cfg_.d_model; ++d) dst[d] = f16_to_f32(row[d]);
-    } else {
-        throw std::runtime_error("Unsupported embedding dtype");
+                union { uint32_t u; float f; } out{f};
+                return out.f;
+            };
+            const uint16_t* row = embed_weights.ptr<const uint16_t>() + token_id * cfg_.d_model;
+            for (int64_t d = 0; d < cfg_.d_model; ++d) dst[d] = f16_to_f32(row[d]);
+        } else {
+            throw std::runtime_error("Unsupported embedding dtype");
+        }
     }
-    
+
+    // RoPE rows come from the model's shared table, which covers max_seq_len
+    const int64_t head_dim = cfg_.d_model / cfg_.n_heads;
+
     // 2) For each layer: rms_norm + attn_forward + rms_norm + mlp_forward
     for (int64_t layer_idx = 0; layer_idx < cfg_.n_layers; ++layer_idx) {
         LayerWeightsCXX layer_weights = weights_.get_layer_weights(layer_idx);
@@ -99,44 +146,97 @@ Tensor RuntimeCtx::forward_decode(int32_t token_id, int64_t pos) {
         // Pre-attention RMS normalization
         Tensor x_norm = ie::ops::rmsnorm(x.view, *layer_weights.input_layernorm);
         
-        // Attention forward pass  
-        ie::layers::AttentionConfig attn_cfg{cfg_.d_model, cfg_.n_heads, cfg_.n_kv_heads, cfg_.d_model / cfg_.n_heads, cfg_.rope_theta, cfg_.rope_dim};
-        Tensor attn_out = ie::layers::attn_forward(x_norm.view, reinterpret_cast<const ie::layers::AttentionWeights&>(layer_weights.attn), attn_cfg, *kv_, layer_idx, pos);
-        
-        // Residual connection: x = x + attn_out
-        float* x_ptr = x.view.ptr<float>();
-        const float* attn_ptr = attn_out.view.ptr<float>();
-        for (int64_t i = 0; i < cfg_.d_model; ++i) {
-            x_ptr[i] += attn_ptr[i];
+        // Attention forward pass; Wo adds straight into the residual stream x
+        ie::layers::AttentionConfig attn_cfg{cfg_.d_model, cfg_.n_heads, cfg_.n_kv_heads, head_dim, cfg_.rope_theta, cfg_.rope_dim, rope_.get()};
+        const auto& attn_weights = reinterpret_cast<const ie::layers::AttentionWeights&>(layer_weights.attn);
+        if (n_tokens == 1) {
+            ie::layers::attn_forward_into(x_norm.view, attn_weights, attn_cfg, *kv_, layer_idx, pos,
+                                          x.view, /*accumulate*/ true, &attn_ctx_);
+        } else {
+            ie::layers::attn_prefill_into(x_norm.view, attn_weights, attn_cfg, *kv_, layer_idx, pos,
+                                          x.view, /*accumulate*/ true, &attn_ctx_);
         }
         
         // Pre-MLP RMS normalization
         Tensor x_norm2 = ie::ops::rmsnorm(x.view, *layer_weights.post_attention_layernorm);
         
-        // MLP forward pass
+        // MLP forward pass; W2 adds straight into the residual stream x
         ie::layers::MLPConfig mlp_cfg{cfg_.d_model, /*d_ff*/ cfg_.d_model * 4, /*use_gelu*/ true};
-        Tensor mlp_out = ie::layers::mlp_forward(x_norm2.view, reinterpret_cast<const ie::layers::MLPWeights&>(layer_weights.mlp), mlp_cfg);
-        
-        // Residual connection: x = x + mlp_out
-        const float* mlp_ptr = mlp_out.view.ptr<float>();
-        for (int64_t i = 0; i < cfg_.d_model; ++i) {
-            x_ptr[i] += mlp_ptr[i];
-        }
+        ie::layers::mlp_forward_into(x_norm2.view, reinterpret_cast<const ie::layers::MLPWeights&>(layer_weights.mlp), mlp_cfg, &mlp_hidden_,
+                                     x.view, /*accumulate*/ true);
     }
     
-    // 3) Final RMS normalization
+    // 3) Final RMS normalization of the last row -> [d_model], ready for the lm_head
     TensorView final_norm_weights = weights_.get_final_norm();
-    Tensor x_final = ie::ops::rmsnorm(x.view, final_norm_weights);
-    
-    // 4) Final projection to logits using linear op (handles BF16 weights safely)
+    TensorView last = make_view(x.view.ptr<float>() + (n_tokens - 1) * cfg_.d_model, DType::F32, {cfg_.d_model});
+    return ie::ops::rmsnorm(last, final_norm_weights);
+}
+
+Tensor RuntimeCtx::prefill_hidden(const std::vector<int32_t>& tokens, int64_t start_pos) {
+    if (tokens.empty()) {
+        throw std::invalid_argument("forward_prefill: empty token list");
+    }
+    Tensor x_final;
+    const int64_t n = static_cast<int64_t>(tokens.size());
+    for (int64_t t0 = 0; t0 < n; t0 += kPrefillChunk) {
+        x_final = forward_hidden(tokens.data() + t0, std::min(kPrefillChunk, n - t0), start_pos + t0);
+    }
+    return x_final;
+}
+
+Tensor RuntimeCtx::forward_decode(int32_t token_id, int64_t pos) {
+    return logits(forward_hidden(&token_id, 1, pos));
+}
+
+std::vector<ops::TopKEntry> RuntimeCtx::forward_decode_topk(int32_t token_id, int64_t pos, int64_t k) {
+    return topk(forward_hidden(&token_id, 1, pos), k);
+}
+
+Tensor RuntimeCtx::forward_prefill(const std::vector<int32_t>& tokens, int64_t start_pos) {
+    return logits(prefill_hidden(tokens, start_pos));
+}
+
+std::vector<ops::TopKEntry> RuntimeCtx::forward_prefill_topk(const std::vector<int32_t>& tokens, int64_t start_pos,
+                                                             int64_t k) {
+    return topk(prefill_hidden(tokens, start_pos), k);
+}
+
+int64_t RuntimeCtx::attach_prefix(PrefixCache& cache, const std::vector<int32_t>& tokens) {
+    if (!kv_->paged() || kv_->pool() != cache.pool()) {
+        throw std::invalid_argument("attach_prefix: context and prefix cache must share one block pool");
+    }
+    std::vector<int32_t> blocks;
+    const int64_t reused = cache.match(tokens, static_cast<int64_t>(tokens.size()) - 1, blocks);
+    try {
+        kv_->adopt_blocks(blocks);  // match() already took the references
+    } catch (...) {
+        for (int32_t b : blocks) kv_->pool()->release(b);
+        throw;
+    }
+    const int64_t B = kv_->pool()->block_size();
+    const int64_t needed = (static_cast<int64_t>(tokens.size()) + B - 1) / B - static_cast<int64_t>(blocks.size());
+    const int64_t short_by = needed - kv_->pool()->num_free();
+    if (short_by > 0) cache.evict(short_by);
+    return reused;
+}
+
+void RuntimeCtx::publish_prefix(PrefixCache& cache, const std::vector<int32_t>& tokens) const {
+    cache.insert(tokens, *kv_);
+}
+
+Tensor RuntimeCtx::logits(const Tensor& x_final) {
+    // Final projection to logits, written straight into the result
     TensorView lm_head_weights = weights_.get_lm_head();
     TensorView x_row = make_view(x_final.view.data, x_final.view.dt, {1, cfg_.d_model});
-    Tensor logits_mat = ie::ops::linear(x_row, lm_head_weights, nullptr); // [1, vocab]
-    Tensor logits = Tensor::empty({cfg_.vocab_size}, DType::F32);
-    std::memcpy(logits.view.data, logits_mat.view.ptr<float>(), static_cast<size_t>(cfg_.vocab_size) * sizeof(float));
-    
-    // 5) Return logits [vocab_size]
-    return logits;
+    Tensor out = Tensor::empty({cfg_.vocab_size}, DType::F32);
+    ie::ops::linear_into(x_row, lm_head_weights, out.view); // [1, vocab] written in place
+    return out;
+}
+
+std::vector<ops::TopKEntry> RuntimeCtx::topk(const Tensor& x_final, int64_t k) {
+    // Vocab-parallel lm_head reduced to k candidates; logits never materialize
+    TensorView x_row = make_view(x_final.view.data, x_final.view.dt, {1, cfg_.d_model});
+    return ie::ops::linear_topk(x_row, weights_.get_lm_head(), k);
 }
 
 } // namespace ie
@@ -0,0 +1,44 @@
+#include "infer_engine/runtime/session.hpp"
+#include <stdexcept>
+#include <utility>
+
+namespace ie {
+
+Session::Session(std::unique_ptr<RuntimeCtx> ctx) : ctx_(std::move(ctx)) {
+    if (!ctx_) throw std::invalid_argument("Session: null runtime context");
+}
+
+std::vector<ops::TopKEntry> Session::feed(const std::vector<int32_t>& tokens, int64_t k) {
+    if (suspended_) throw std::logic_error("Session: resume before feeding a suspended session");
+    std::vector<ops::TopKEntry> next;
+    try {
+        next = ctx_->forward_prefill_topk(tokens, pos(), k);
+    } catch (...) {
+        ctx_->kv().truncate(pos());
+        throw;
+    }
+    tokens_.insert(tokens_.end(), tokens.begin(), tokens.end());
+    return next;
+}
+
+size_t Session::suspend(const std::string& path, const KVSnapshotOptions& opts) {
+    if (suspended_) throw std::logic_error("Session: already suspended");
+    KVSnapshotOptions snap = opts;
+    snap.tokens = tokens_;
+    const size_t bytes = ctx_->kv().save(path, pos(), snap);
+    ctx_->kv().clear();
+    suspended_ = true;
+    return bytes;
+}
+
+void Session::resume(const std::string& path) {
+    std::vector<int32_t> tokens;
+    const int64_t n_pos = ctx_->kv().load(path, &tokens);
+    if (static_cast<int64_t>(tokens.size()) != n_pos) {
+        throw std::runtime_error("Session: snapshot has no token history: " + path);
+    }
+    tokens_ = std::move(tokens);
+    suspended_ = false;
+}
+
+} // namespace ie
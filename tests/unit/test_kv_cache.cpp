@@ -1,7 +1,19 @@
 #include "infer_engine/runtime/kv_cache.hpp"
+#include "infer_engine/runtime/prefix_cache.hpp"
+#include "infer_engine/layers/ops/linear.hpp"
 #include "infer_engine/core/tensor.hpp"
+#include "infer_engine/core/half.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <stdexcept>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
 
 int main() {
     using namespace ie;
@@ -82,6 +94,489 @@ int main() {
     cache.append(1, 2, K.view, V.view);  // layer 1, seq pos 2
     std::cout << "✓ Appended to layer 1, pos 2\n";
 
+    // Quantized caches: F32 rows in, codes plus one scale per (layer, pos, head) out
+    int failures = 0;
+    for (int code = 0; code < 256; ++code) {
+        if ((code & 0x7F) == 0x7F) continue; // NaN
+        const uint8_t c = static_cast<uint8_t>(code);
+        if (half::f32_to_e4m3(half::e4m3_to_f32(c)) != c && (c & 0x7F) != 0) ++failures;
+    }
+    if (half::e4m3_to_f32(0x7E) != 448.0f || half::f32_to_e4m3(1000.0f) != 0x7E || half::e4m3_to_f32(0x01) != std::ldexp(1.0f, -9)) {
+        ++failures;
+    }
+    for (DType dt : {DType::I8, DType::F8}) {
+        KVCacheConfig qcfg = cfg;
+        qcfg.dtype = dt;
+        KVCache qcache(qcfg);
+        Tensor Kf = Tensor::empty({cfg.num_kv_heads, cfg.head_dim}, DType::F32);
+        Tensor Vf = Tensor::empty({cfg.num_kv_heads, cfg.head_dim}, DType::F32);
+        for (int i = 0; i < cfg.num_kv_heads * cfg.head_dim; ++i) {
+            Kf.view.ptr<float>()[i] = std::sin(0.7f * static_cast<float>(i)) * static_cast<float>(1 + i / cfg.head_dim);
+            Vf.view.ptr<float>()[i] = std::cos(0.3f * static_cast<float>(i)) * 0.01f;
+        }
+        const int64_t layer = 1, pos = 3;
+        qcache.append(layer, pos, Kf.view, Vf.view);
+        const float qmax = (dt == DType::I8) ? 127.0f : 448.0f;
+        const float rel_step = (dt == DType::I8) ? 0.5f / 127.0f : 1.0f / 16.0f; // half an int8 step, E4M3 rounding
+        for (int h = 0; h < cfg.num_kv_heads; ++h) {
+            const int64_t row = (layer * cfg.max_seq_len + pos) * cfg.num_kv_heads + h;
+            const TensorView stores[] = {qcache.k_view(), qcache.v_view()};
+            const TensorView scales[] = {qcache.k_scales(), qcache.v_scales()};
+            const float* srcs[] = {Kf.view.ptr<const float>(), Vf.view.ptr<const float>()};
+            for (int kv = 0; kv < 2; ++kv) {
+                const float* src = srcs[kv] + h * cfg.head_dim;
+                float amax = 0.0f;
+                for (int d = 0; d < cfg.head_dim; ++d) amax = std::max(amax, std::fabs(src[d]));
+                const float s = scales[kv].ptr<const float>()[row];
+                if (std::fabs(s - amax / qmax) > 1e-6f * amax) ++failures;
+                const uint8_t* codes = stores[kv].ptr<const uint8_t>() + row * cfg.head_dim;
+                for (int d = 0; d < cfg.head_dim; ++d) {
+                    const float got = (dt == DType::I8) ? s * static_cast<float>(static_cast<int8_t>(codes[d]))
+                                                        : s * half::e4m3_to_f32(codes[d]);
+                    const float tol = (dt == DType::I8) ? rel_step * amax : rel_step * std::fabs(src[d]) + s * std::ldexp(1.0f, -9);
+                    if (std::fabs(got - src[d]) > tol + 1e-7f) ++failures;
+                }
+            }
+        }
+        // Quantized caches only take F32 rows
+        bool threw = false;
+        try { qcache.append(0, 0, K.view, V.view); } catch (const std::invalid_argument&) { threw = true; }
+        if (!threw) ++failures;
+        std::cout << "✓ " << dtype_name(dt) << " cache: per-head scales and codes round trip\n";
+    }
+
+    // Row conversion at every kernel level: codes and scales match the scalar
+    // encoders bit for bit; head_dim 37 covers whole vectors plus a tail
+    for (Isa isa : {Isa::Scalar, Isa::AVX2, Isa::AVX512}) {
+        if (!isa_supported(isa)) continue;
+        ops::set_linear_isa(isa);
+        for (DType dt : {DType::F16, DType::I8, DType::F8}) {
+            KVCacheConfig ccfg = cfg;
+            ccfg.dtype = dt;
+            ccfg.head_dim = 37;
+            KVCache c(ccfg);
+            const int64_t D = ccfg.head_dim, row_elems = ccfg.num_kv_heads * D;
+            Tensor Kf = Tensor::empty({ccfg.num_kv_heads, D}, DType::F32);
+            Tensor Vf = Tensor::empty({ccfg.num_kv_heads, D}, DType::F32);
+            for (int64_t i = 0; i < row_elems; ++i) {
+                // Magnitudes over several decades, so F8 codes include subnormals
+                Kf.view.ptr<float>()[i] = std::sin(1.3f * static_cast<float>(i)) * std::ldexp(1.0f, static_cast<int>(i % 13) - 6);
+                Vf.view.ptr<float>()[i] = -std::cos(0.9f * static_cast<float>(i)) * 3.0f;
+            }
+            c.append(0, 2, Kf.view, Vf.view);
+            const TensorView stores[] = {c.k_view(), c.v_view()};
+            const float* srcs[] = {Kf.view.ptr<const float>(), Vf.view.ptr<const float>()};
+            for (int64_t h = 0; h < ccfg.num_kv_heads; ++h) {
+                const int64_t row = 2 * ccfg.num_kv_heads + h;
+                for (int kv = 0; kv < 2; ++kv) {
+                    const float* src = srcs[kv] + h * D;
+                    if (dt == DType::F16) {
+                        const uint16_t* got = stores[kv].ptr<const uint16_t>() + row * D;
+                        for (int64_t d = 0; d < D; ++d) {
+                            if (got[d] != half::f32_to_f16(src[d])) ++failures;
+                        }
+                        continue;
+                    }
+                    float amax = 0.0f;
+                    for (int64_t d = 0; d < D; ++d) amax = std::max(amax, std::fabs(src[d]));
+                    const float qmax = (dt == DType::I8) ? 127.0f : 448.0f;
+                    const float inv = qmax / amax;
+                    const float* sc = (kv ? c.v_scales() : c.k_scales()).ptr<const float>();
+                    if (sc[row] != amax / qmax) ++failures;
+                    const uint8_t* got = stores[kv].ptr<const uint8_t>() + row * D;
+                    for (int64_t d = 0; d < D; ++d) {
+                        const uint8_t want = (dt == DType::I8)
+                            ? static_cast<uint8_t>(static_cast<int8_t>(std::clamp(std::nearbyint(src[d] * inv), -127.0f, 127.0f)))
+                            : half::f32_to_e4m3(src[d] * inv);
+                        if (got[d] != want) ++failures;
+                    }
+                }
+            }
+        }
+        std::cout << "✓ " << isa_name(isa) << " row conversion matches the scalar encoders\n";
+    }
+    ops::set_linear_isa(best_isa());
+
+    // Bulk append of a position range matches per-position appends, bytes and scales
+    for (DType dt : {DType::F16, DType::I8}) {
+        KVCacheConfig bcfg = cfg;
+        bcfg.dtype = dt;
+        KVCache one(bcfg), bulk(bcfg);
+        const int64_t n_pos = 3, start = 1;
+        Tensor Kr = Tensor::empty({n_pos, cfg.num_kv_heads, cfg.head_dim}, DType::F32);
+        Tensor Vr = Tensor::empty({n_pos, cfg.num_kv_heads, cfg.head_dim}, DType::F32);
+        const int64_t row_elems = cfg.num_kv_heads * cfg.head_dim;
+        for (int64_t i = 0; i < n_pos * row_elems; ++i) {
+            Kr.view.ptr<float>()[i] = std::sin(0.11f * static_cast<float>(i));
+            Vr.view.ptr<float>()[i] = std::cos(0.05f * static_cast<float>(i));
+        }
+        for (int64_t p = 0; p < n_pos; ++p) {
+            one.append(1, start + p, make_view(Kr.view.ptr<float>() + p * row_elems, DType::F32, {cfg.num_kv_heads, cfg.head_dim}),
+                       make_view(Vr.view.ptr<float>() + p * row_elems, DType::F32, {cfg.num_kv_heads, cfg.head_dim}));
+        }
+        bulk.append_range(1, start, Kr.view, Vr.view);
+        if (std::memcmp(one.k_view().data, bulk.k_view().data, one.k_view().nbytes()) != 0 ||
+            std::memcmp(one.v_view().data, bulk.v_view().data, one.v_view().nbytes()) != 0) {
+            ++failures;
+        }
+        if (kv_dtype_scaled(dt) && std::memcmp(one.k_scales().data, bulk.k_scales().data, one.k_scales().nbytes()) != 0) {
+            ++failures;
+        }
+        // Same rows read in place from interleaved [n_pos, K | V] rows (fused QKV output)
+        {
+            KVCache strided(bcfg);
+            std::vector<float> kv(static_cast<size_t>(n_pos * 2 * row_elems));
+            for (int64_t p = 0; p < n_pos; ++p) {
+                std::memcpy(kv.data() + p * 2 * row_elems, Kr.view.ptr<float>() + p * row_elems, row_elems * sizeof(float));
+                std::memcpy(kv.data() + p * 2 * row_elems + row_elems, Vr.view.ptr<float>() + p * row_elems, row_elems * sizeof(float));
+            }
+            const std::vector<int64_t> shape{n_pos, cfg.num_kv_heads, cfg.head_dim}, strides{2 * row_elems, cfg.head_dim, 1};
+            strided.append_range(1, start, make_view(kv.data(), DType::F32, shape, strides),
+                                 make_view(kv.data() + row_elems, DType::F32, shape, strides));
+            if (std::memcmp(strided.k_view().data, bulk.k_view().data, bulk.k_view().nbytes()) != 0 ||
+                std::memcmp(strided.v_view().data, bulk.v_view().data, bulk.v_view().nbytes()) != 0) {
+                ++failures;
+            }
+            // Heads strided within a position are rejected
+            bool threw = false;
+            try {
+                strided.append_range(1, start, make_view(kv.data(), DType::F32, shape, {2 * row_elems, 2 * cfg.head_dim, 1}),
+                                     make_view(kv.data(), DType::F32, shape, strides));
+            } catch (const std::invalid_argument&) { threw = true; }
+            if (!threw) ++failures;
+        }
+        // The range must fit the cache
+        bool threw = false;
+        try { bulk.append_range(1, cfg.max_seq_len - 1, Kr.view, Vr.view); } catch (const std::out_of_range&) { threw = true; }
+        if (!threw) ++failures;
+    }
+    std::cout << "✓ append_range matches per-position appends\n";
+
+    // Paged caches: same rows as a dense cache, found through the block table;
+    // blocks are shared through the pool and returned on clear
+    {
+        KVCacheConfig pcfg = cfg;
+        pcfg.dtype = DType::I8;
+        auto pool = std::make_shared<KVBlockPool>(pcfg, /*block_size*/ 3, /*num_blocks*/ 3);  // rounded to 4
+        if (pool->block_size() != 4) ++failures;
+        KVCache dense(pcfg), a(pool), b(pool);
+        Tensor Kf = Tensor::empty({cfg.num_kv_heads, cfg.head_dim}, DType::F32);
+        Tensor Vf = Tensor::empty({cfg.num_kv_heads, cfg.head_dim}, DType::F32);
+        for (int64_t pos = 0; pos < 6; ++pos) {
+            for (int64_t i = 0; i < cfg.num_kv_heads * cfg.head_dim; ++i) {
+                Kf.view.ptr<float>()[i] = std::sin(0.2f * static_cast<float>(i + 31 * pos));
+                Vf.view.ptr<float>()[i] = std::cos(0.4f * static_cast<float>(i + 17 * pos));
+            }
+            a.append(1, pos, Kf.view, Vf.view);
+            if (pos < 4) dense.append(1, pos, Kf.view, Vf.view);
+            if (pos == 0) b.append(0, 0, Kf.view, Vf.view);   // b's block lands between a's
+        }
+        if (a.block_table().size() != 2 || b.block_table().size() != 1 || pool->num_free() != 0) ++failures;
+        for (int64_t pos = 0; pos < 4; ++pos) {
+            for (int64_t h = 0; h < cfg.num_kv_heads; ++h) {
+                const size_t dr = dense.row_index(1, pos, h), pr = a.row_index(1, pos, h);
+                if (std::memcmp(dense.k_view().ptr<const int8_t>() + dr * cfg.head_dim,
+                                a.k_view().ptr<const int8_t>() + pr * cfg.head_dim, static_cast<size_t>(cfg.head_dim)) != 0 ||
+                    dense.v_scales().ptr<const float>()[dr] != a.v_scales().ptr<const float>()[pr]) {
+                    ++failures;
+                }
+            }
+        }
+        bool threw = false;
+        try { b.append(0, 4, Kf.view, Vf.view); } catch (const std::runtime_error&) { threw = true; }
+        if (!threw) ++failures;
+        a.clear();
+        if (pool->num_free() != 2 || !a.block_table().empty()) ++failures;
+        b.append(0, 4, Kf.view, Vf.view);   // now fits
+        if (b.block_table().size() != 2) ++failures;
+    }
+    std::cout << "✓ Paged cache: block table, shared pool and free list\n";
+
+    // Prefix cache: full blocks of a finished sequence are matched by later
+    // prompts, shared by reference count and evicted least recently used first
+    {
+        auto pool = std::make_shared<KVBlockPool>(cfg, /*block_size*/ 2, /*num_blocks*/ 6);
+        PrefixCache prefixes(pool, /*max_blocks*/ 3);
+        Tensor Kf = Tensor::empty({cfg.num_kv_heads, cfg.head_dim}, DType::F16);
+        auto fill_seq = [&](KVCache& c, int64_t from, int64_t to) {
+            for (int64_t pos = from; pos < to; ++pos) {
+                for (int64_t l = 0; l < cfg.num_layers; ++l) c.append(l, pos, Kf.view, Kf.view);
+            }
+        };
+        const std::vector<int32_t> prompt{5, 6, 7, 8, 9};
+        std::vector<int32_t> blocks;
+        auto drop = [&](const std::vector<int32_t>& held) {  // references match() handed out
+            for (int32_t blk : held) pool->release(blk);
+        };
+        {
+            KVCache a(pool);
+            fill_seq(a, 0, 5);                                       // blocks {0,1} full, 2 partial
+            prefixes.insert(prompt, a);
+            if (prefixes.cached_blocks() != 2 || pool->ref_count(a.block_table()[0]) != 2) ++failures;
+            KVCache b(pool);
+            const std::vector<int32_t> other{5, 6, 7, 1, 2};
+            if (prefixes.match(other, 5, blocks) != 2 || blocks != std::vector<int32_t>{a.block_table()[0]}) ++failures;
+            if (pool->ref_count(blocks[0]) != 3) ++failures;        // a, the cache and the match
+            drop(blocks);
+            if (prefixes.match(prompt, 4, blocks) != 4) ++failures;
+            b.adopt_blocks(blocks);
+            fill_seq(b, 4, 5);                                       // suffix goes to a block of b's own
+            if (b.block_table().size() != 3 || b.block_table()[2] == a.block_table()[2]) ++failures;
+            if (pool->ref_count(blocks[0]) != 3 || prefixes.evict(2) != 0) ++failures;  // still in use
+        }
+        if (pool->num_free() != 4) ++failures;                      // only the cached blocks remain
+        // A third block pushes the cache past max_blocks: the least recently used leaf goes
+        KVCache c(pool);
+        fill_seq(c, 0, 2);
+        prefixes.insert({1, 1}, c);
+        c.clear();
+        if (prefixes.cached_blocks() != 3) ++failures;
+        prefixes.match(prompt, 5, blocks);                           // touch the prompt's chain
+        drop(blocks);
+        KVCache d(pool);
+        fill_seq(d, 0, 2);
+        prefixes.insert({2, 2}, d);
+        if (prefixes.cached_blocks() != 3 || prefixes.match({1, 1}, 2, blocks) != 0 ||
+            prefixes.match(prompt, 5, blocks) != 4) {
+            ++failures;
+        }
+        drop(blocks);
+        // Tokens past the filled positions (never fed) are not published
+        KVCache e(pool);
+        fill_seq(e, 0, 3);
+        e.append(0, 3, Kf.view, Kf.view);                            // position 3 only in layer 0
+        if (e.filled() != 3) ++failures;
+        prefixes.insert({3, 3, 3, 3}, e);
+        if (prefixes.match({3, 3, 3, 3}, 4, blocks) != 2) ++failures;
+        drop(blocks);
+    }
+    std::cout << "✓ Prefix cache: longest match, shared blocks, LRU eviction\n";
+
+    // Matched blocks are referenced before match() returns: a concurrent
+    // evict() cannot hand them to another sequence that overwrites them
+    {
+        KVCacheConfig pcfg = cfg;
+        pcfg.dtype = DType::F32;
+        auto pool = std::make_shared<KVBlockPool>(pcfg, /*block_size*/ 2, /*num_blocks*/ 6);
+        PrefixCache prefixes(pool, /*max_blocks*/ 4);
+        const std::vector<int32_t> prompt{1, 2, 3, 4, 5};
+        auto fill = [&](KVCache& c, int64_t n, float value) {
+            Tensor row = Tensor::empty({cfg.num_kv_heads, cfg.head_dim}, DType::F32);
+            std::fill(row.view.ptr<float>(), row.view.ptr<float>() + row.view.numel(), value);
+            for (int64_t pos = 0; pos < n; ++pos) {
+                for (int64_t l = 0; l < cfg.num_layers; ++l) c.append(l, pos, row.view, row.view);
+            }
+        };
+        auto publish = [&] {
+            try {
+                KVCache p(pool);
+                fill(p, 4, 1.0f);
+                prefixes.insert(prompt, p);
+            } catch (const std::runtime_error&) {}  // pool momentarily exhausted
+        };
+        publish();
+
+        // Deterministic interleaving: evict between match and adopt
+        std::vector<int32_t> held;
+        if (prefixes.match(prompt, 4, held) != 4 || prefixes.evict(4) != 0) ++failures;
+        {
+            KVCache s(pool);
+            s.adopt_blocks(held);
+        }
+        if (prefixes.evict(4) != 2 || pool->num_free() != pool->num_blocks()) ++failures;
+
+        std::atomic<int> corrupted{0};
+        std::atomic<bool> done{false};
+        std::thread evictor([&] {
+            while (!done.load()) {
+                prefixes.evict(4);
+                try {
+                    KVCache o(pool);
+                    fill(o, pool->num_blocks() * pool->block_size(), 2.0f);  // grab and overwrite every free block
+                } catch (const std::runtime_error&) {}
+            }
+        });
+        for (int iter = 0; iter < 2000; ++iter) {
+            std::vector<int32_t> blocks;
+            if (prefixes.match(prompt, 4, blocks) != 4) {
+                publish();
+                continue;
+            }
+            KVCache s(pool);
+            s.adopt_blocks(blocks);
+            for (int64_t pos = 0; pos < 4; ++pos) {
+                if (s.k_view().ptr<const float>()[s.row_index(1, pos, 0) * cfg.head_dim] != 1.0f) ++corrupted;
+            }
+        }
+        done.store(true);
+        evictor.join();
+        if (corrupted.load() != 0) ++failures;
+    }
+    std::cout << "✓ Prefix cache: matched blocks survive concurrent eviction\n";
+
+    // Writing into a block another holder references copies it first: the
+    // other holder keeps its rows, the writer keeps the rest of the block
+    {
+        KVCacheConfig pcfg = cfg;
+        pcfg.dtype = DType::I8;
+        auto pool = std::make_shared<KVBlockPool>(pcfg, /*block_size*/ 2, /*num_blocks*/ 6);
+        Tensor row = Tensor::empty({cfg.num_kv_heads, cfg.head_dim}, DType::F32);
+        auto fill_row = [&](float value) {
+            std::fill(row.view.ptr<float>(), row.view.ptr<float>() + row.view.numel(), value);
+        };
+        auto value = [&](const KVCache& c, int64_t layer, int64_t pos) {
+            const size_t r = c.row_index(layer, pos, 0);
+            return c.k_scales().ptr<const float>()[r] * static_cast<float>(c.k_view().ptr<const int8_t>()[r * cfg.head_dim]);
+        };
+        KVCache a(pool);
+        fill_row(1.0f);
+        for (int64_t pos = 0; pos < 4; ++pos) {
+            for (int64_t l = 0; l < cfg.num_layers; ++l) a.append(l, pos, row.view, row.view);
+        }
+        KVCache b(pool);
+        b.attach_blocks(a.block_table());
+        fill_row(3.0f);
+        b.append(0, 1, row.view, row.view);
+        if (b.block_table()[0] == a.block_table()[0] || b.block_table()[1] != a.block_table()[1] ||
+            pool->ref_count(a.block_table()[0]) != 1 || pool->ref_count(a.block_table()[1]) != 2) {
+            ++failures;
+        }
+        if (std::fabs(value(a, 0, 1) - 1.0f) > 1e-6f || std::fabs(value(b, 0, 1) - 3.0f) > 1e-6f ||
+            std::fabs(value(b, 0, 0) - 1.0f) > 1e-6f || std::fabs(value(b, cfg.num_layers - 1, 1) - 1.0f) > 1e-6f) {
+            ++failures;
+        }
+        // Truncating into a shared block and writing again copies it as well
+        KVCache c(pool);
+        c.attach_blocks(a.block_table());
+        c.truncate(3);
+        c.append(0, 3, row.view, row.view);
+        if (c.block_table()[1] == a.block_table()[1] || std::fabs(value(a, 0, 3) - 1.0f) > 1e-6f ||
+            std::fabs(value(c, 0, 2) - 1.0f) > 1e-6f || std::fabs(value(c, 0, 3) - 3.0f) > 1e-6f) {
+            ++failures;
+        }
+    }
+    std::cout << "✓ Paged cache: shared blocks are copied before they are written\n";
+
+    // Head-major layout: same rows, each KV head's positions contiguous
+    for (bool paged : {false, true}) {
+        KVCacheConfig hcfg = cfg;
+        hcfg.dtype = DType::I8;
+        hcfg.layout = KVLayout::HeadMajor;
+        auto pool = std::make_shared<KVBlockPool>(hcfg, 2, 4);
+        KVCache seq_major(KVCacheConfig{cfg.num_layers, cfg.max_seq_len, cfg.num_q_heads, cfg.num_kv_heads, cfg.head_dim, DType::I8});
+        std::unique_ptr<KVCache> head_major = paged ? std::make_unique<KVCache>(pool, cfg.max_seq_len)
+                                                    : std::make_unique<KVCache>(hcfg);
+        Tensor Kr = Tensor::empty({cfg.max_seq_len, cfg.num_kv_heads, cfg.head_dim}, DType::F32);
+        for (int64_t i = 0; i < Kr.view.numel(); ++i) Kr.view.ptr<float>()[i] = std::sin(0.37f * static_cast<float>(i));
+        seq_major.append_range(1, 0, Kr.view, Kr.view);
+        head_major->append_range(1, 0, Kr.view, Kr.view);
+        if (!paged && head_major->row_index(1, 1, 0) != head_major->row_index(1, 0, 0) + 1) ++failures;
+        for (int64_t pos = 0; pos < cfg.max_seq_len; ++pos) {
+            for (int64_t h = 0; h < cfg.num_kv_heads; ++h) {
+                const size_t a = seq_major.row_index(1, pos, h), b = head_major->row_index(1, pos, h);
+                if (std::memcmp(seq_major.v_view().ptr<const int8_t>() + a * cfg.head_dim,
+                                head_major->v_view().ptr<const int8_t>() + b * cfg.head_dim, static_cast<size_t>(cfg.head_dim)) != 0 ||
+                    seq_major.k_scales().ptr<const float>()[a] != head_major->k_scales().ptr<const float>()[b]) {
+                    ++failures;
+                }
+            }
+        }
+    }
+    std::cout << "✓ Head-major layout stores the same rows\n";
+
+    // Snapshots: positions [0, n) round-trip through a file into any layout,
+    // dense or paged; a quantized snapshot restores within the I8 step
+    {
+        const std::string path = "/tmp/ie_test_kv_snapshot.safetensors";
+        const int64_t n = 3;
+        Tensor Ks = Tensor::empty({n, cfg.num_kv_heads, cfg.head_dim}, DType::F32);
+        Tensor Vs = Tensor::empty({n, cfg.num_kv_heads, cfg.head_dim}, DType::F32);
+        for (int64_t i = 0; i < Ks.view.numel(); ++i) {
+            Ks.view.ptr<float>()[i] = std::sin(0.21f * static_cast<float>(i));
+            Vs.view.ptr<float>()[i] = std::cos(0.13f * static_cast<float>(i));
+        }
+        for (DType dt : {DType::F16, DType::I8}) {
+            KVCacheConfig scfg = cfg;
+            scfg.dtype = dt;
+            KVCache src(scfg);
+            for (int64_t l = 0; l < cfg.num_layers; ++l) src.append_range(l, 0, Ks.view, Vs.view);
+            KVSnapshotOptions opts;
+            opts.tokens = {5, 6, 7};
+            if (src.save(path, n, opts) == 0) ++failures;
+
+            KVCacheConfig hcfg = scfg;
+            hcfg.layout = KVLayout::HeadMajor;
+            KVCache dst(std::make_shared<KVBlockPool>(hcfg, 2, 4));
+            std::vector<int32_t> tokens;
+            if (dst.load(path, &tokens) != n || tokens != opts.tokens || dst.block_table().size() != 2) ++failures;
+            const size_t row_bytes = static_cast<size_t>(cfg.head_dim) * dtype_bytes(dt);
+            for (int64_t l = 0; l < cfg.num_layers; ++l) {
+                for (int64_t pos = 0; pos < n; ++pos) {
+                    for (int64_t h = 0; h < cfg.num_kv_heads; ++h) {
+                        const size_t a = src.row_index(l, pos, h), b = dst.row_index(l, pos, h);
+                        if (std::memcmp(src.v_view().ptr<const uint8_t>() + a * row_bytes,
+                                        dst.v_view().ptr<const uint8_t>() + b * row_bytes, row_bytes) != 0 ||
+                            (dt == DType::I8 && src.k_scales().ptr<const float>()[a] != dst.k_scales().ptr<const float>()[b])) {
+                            ++failures;
+                        }
+                    }
+                }
+            }
+        }
+
+        KVCache f16(cfg);
+        for (int64_t l = 0; l < cfg.num_layers; ++l) f16.append_range(l, 0, Ks.view, Vs.view);
+        KVSnapshotOptions opts;
+        opts.quantize = true;
+        f16.save(path, n, opts);
+        KVCache restored(cfg);
+        if (restored.load(path) != n) ++failures;
+        for (int64_t pos = 0; pos < n; ++pos) {
+            for (int64_t h = 0; h < cfg.num_kv_heads; ++h) {
+                const auto* row = restored.k_view().ptr<const uint16_t>() + restored.row_index(1, pos, h) * cfg.head_dim;
+                const float* ref = Ks.view.ptr<const float>() + (pos * cfg.num_kv_heads + h) * cfg.head_dim;
+                for (int64_t d = 0; d < cfg.head_dim; ++d) {
+                    if (std::fabs(half::f16_to_f32(row[d]) - ref[d]) > 0.5f / 127.0f + 2e-3f) ++failures;
+                }
+            }
+        }
+
+        KVCacheConfig other = cfg;
+        other.num_kv_heads = 1;
+        KVCache mismatched(other);
+        bool threw = false;
+        try { mismatched.load(path); } catch (const std::invalid_argument&) { threw = true; }
+        if (!threw) ++failures;
+
+        // Dropping a dense cache gives its pages back
+        f16.clear();
+        if (f16.committed_bytes() != 0 || f16.k_view().ptr<const uint16_t>()[0] != 0) ++failures;
+        std::remove(path.c_str());
+    }
+    std::cout << "✓ KV snapshot save/load across layouts, paging and quantization\n";
+
+    // A generous max_seq_len only reserves address space; pages are committed
+    // as positions are written
+    {
+        KVCacheConfig big = cfg;
+        big.num_layers = 1;
+        big.max_seq_len = 1 << 15;
+        big.num_kv_heads = 8;
+        big.head_dim = 128;
+        KVCache lazy(big);
+        const size_t store_bytes = size_t(2) * big.max_seq_len * big.num_kv_heads * big.head_dim * 2;
+        Tensor Kb = Tensor::empty({big.num_kv_heads, big.head_dim}, DType::F16);
+        for (int64_t pos = 0; pos < 8; ++pos) lazy.append(0, pos, Kb.view, Kb.view);
+        if (lazy.reserved_bytes() < store_bytes || lazy.committed_bytes() > store_bytes / 16) ++failures;
+        std::cout << "✓ Lazy KV memory: " << lazy.committed_bytes() / 1024 << " KB committed of "
+                  << lazy.reserved_bytes() / (1024 * 1024) << " MB reserved\n";
+    }
+
+    if (failures) {
+        std::cerr << failures << " quantized KV checks failed\n";
+        return 1;
+    }
+
     std::cout << "All KVCache tests passed!\n";
     return 0;
 }
@@ -1,34 +1,278 @@
 #include "infer_engine/runtime/runtime_ctx.hpp"
+#include "infer_engine/runtime/session.hpp"
+#include "infer_engine/runtime/prefix_cache.hpp"
+#include "infer_engine/io/model_loader.hpp"
 #include "infer_engine/model/config.hpp"
 #include "infer_engine/model/weights.hpp"
-#include <cassert>
+#include "infer_engine/layers/ops/rope.hpp"
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
-int main() {
-    using namespace ie;
-    std::cout << "RuntimeCtx forward_decode test skeleton...\n";
+using namespace ie;
 
-    // Minimal cfg
-    ModelCfg cfg{};
-    cfg.d_model = 64;
-    cfg.n_layers = 1;
-    cfg.n_heads = 4;
-    cfg.n_kv_heads = 4;
-    cfg.vocab_size = 32000;
-    cfg.rope_theta = 10000.0f;
-    cfg.rope_dim = 0;
+static int failures = 0;
 
-    // TODO: Construct ModelWeights with small tensors bound to views
-    ModelWeights weights{ /* fill fields with TensorViews */ };
+// Small random model; storage holds every tensor the views point into
+struct TinyModel {
+    ModelCfg cfg;
+    ModelWeights weights;
+    std::vector<std::unique_ptr<Tensor>> storage;
+    std::vector<LayerWeightsCXX> layers;
 
-    RuntimeCtx rt(cfg, weights);
+    TensorView random(const std::vector<int64_t>& shape, std::mt19937& rng, float scale) {
+        std::normal_distribution<float> dist(0.0f, scale);
+        storage.push_back(std::make_unique<Tensor>(Tensor::empty(shape, DType::F32)));
+        TensorView v = storage.back()->view;
+        for (int64_t i = 0; i < v.numel(); ++i) v.ptr<float>()[i] = dist(rng);
+        return v;
+    }
+    TensorView* random_ptr(const std::vector<int64_t>& shape, std::mt19937& rng, float scale) {
+        random(shape, rng, scale);
+        return &storage.back()->view;
+    }
+    TensorView* ones(int64_t n) {
+        storage.push_back(std::make_unique<Tensor>(Tensor::empty({n}, DType::F32)));
+        TensorView* v = &storage.back()->view;
+        for (int64_t i = 0; i < n; ++i) v->ptr<float>()[i] = 1.0f;
+        return v;
+    }
 
-    // TODO: Call forward_decode and compare logits vs reference
-    // Tensor logits = rt.forward_decode(42, /*pos=*/0);
-    // assert(logits.view.shape == std::vector<int64_t>{cfg.vocab_size});
+    // qkv_bias: Q and V projections get biases (K stays without one)
+    explicit TinyModel(bool qkv_bias = false) {
+        cfg.d_model = 32;
+        cfg.n_layers = 2;
+        cfg.n_heads = 4;
+        cfg.n_kv_heads = 2;
+        cfg.vocab_size = 50;
+        std::mt19937 rng(11);
+        const int64_t d = cfg.d_model, kv = cfg.n_kv_heads * cfg.head_dim(), d_ff = 4 * d;
+        const float s = 1.0f / std::sqrt(static_cast<float>(d));
+        weights.set_token_embeddings(random({cfg.vocab_size, d}, rng, 1.0f));
+        weights.set_lm_head(random({cfg.vocab_size, d}, rng, s));
+        weights.set_final_norm(*ones(d));
+        weights.set_num_layers(cfg.n_layers);
+        layers.resize(static_cast<size_t>(cfg.n_layers));
+        for (int64_t l = 0; l < cfg.n_layers; ++l) {
+            LayerWeightsCXX& lw = layers[static_cast<size_t>(l)];
+            lw.attn.Wq = random({d, d}, rng, s);
+            lw.attn.Wk = random({kv, d}, rng, s);
+            lw.attn.Wv = random({kv, d}, rng, s);
+            lw.attn.Wo = random({d, d}, rng, s);
+            if (qkv_bias) {
+                lw.attn.bq = random_ptr({d}, rng, 0.5f);
+                lw.attn.bv = random_ptr({kv}, rng, 0.5f);
+            }
+            lw.mlp.W1 = random({d_ff, d}, rng, s);
+            lw.mlp.W3 = random({d_ff, d}, rng, s);
+            lw.mlp.W2 = random({d, d_ff}, rng, 1.0f / std::sqrt(static_cast<float>(d_ff)));
+            lw.input_layernorm = ones(d);
+            lw.post_attention_layernorm = ones(d);
+            weights.set_layer_weights(l, lw);
+        }
+    }
+};
 
-    std::cout << "RuntimeCtx test skeleton ready\n";
-    return 0;
+static void expect_same(const char* what, const std::vector<ops::TopKEntry>& got,
+                        const std::vector<ops::TopKEntry>& want) {
+    bool same = got.size() == want.size();
+    for (size_t i = 0; same && i < got.size(); ++i) {
+        same = got[i].id == want[i].id && std::fabs(got[i].value - want[i].value) <= 1e-4f;
+    }
+    if (!same) {
+        std::cerr << "FAIL " << what << "\n";
+        ++failures;
+    }
+}
+
+// feed -> suspend -> resume -> feed gives the uninterrupted run's top-k, for
+// dense and paged contexts; suspending frees the sequence's blocks
+static void test_session_suspend_resume(const TinyModel& m) {
+    const std::string path = "/tmp/ie_test_session.safetensors";
+    const std::vector<int32_t> prompt{3, 14, 15, 9, 26, 5, 35};
+    const int64_t k = 5;
+
+    Session ref(std::make_unique<RuntimeCtx>(m.cfg, m.weights, 64));
+    ref.feed(prompt, k);
+    const std::vector<ops::TopKEntry> ref_a = ref.feed({8}, k);
+    const std::vector<ops::TopKEntry> ref_b = ref.feed({42, 7}, k);
+
+    for (bool paged : {false, true}) {
+        auto pool = paged ? std::make_shared<KVBlockPool>(
+                                KVCacheConfig{m.cfg.n_layers, 0, m.cfg.n_heads, m.cfg.n_kv_heads, m.cfg.head_dim(), DType::F16},
+                                /*block_size*/ 4, /*num_blocks*/ 8)
+                          : nullptr;
+        auto make_ctx = [&] {
+            return paged ? std::make_unique<RuntimeCtx>(m.cfg, m.weights, pool, 64)
+                         : std::make_unique<RuntimeCtx>(m.cfg, m.weights, 64);
+        };
+        Session first(make_ctx());
+        first.feed(prompt, k);
+        expect_same("session before suspend", first.feed({8}, k), ref_a);
+        if (first.suspend(path) == 0 || !first.suspended()) ++failures;
+        if (paged && pool->num_free() != pool->num_blocks()) {
+            std::cerr << "FAIL suspend keeps KV blocks\n";
+            ++failures;
+        }
+        bool threw = false;
+        try { first.feed({1}, k); } catch (const std::logic_error&) { threw = true; }
+        if (!threw) ++failures;
+
+        Session resumed(make_ctx());
+        resumed.resume(path);
+        if (resumed.pos() != static_cast<int64_t>(prompt.size()) + 1 || resumed.tokens().back() != 8) ++failures;
+        expect_same(paged ? "paged session after resume" : "session after resume", resumed.feed({42, 7}, k), ref_b);
+    }
+    std::remove(path.c_str());
+    std::cout << "session: suspend / resume matches an uninterrupted run (dense, paged)\n";
+}
+
+// A prefill that fails part way (pool exhausted in its second chunk) leaves
+// the session and its blocks as before the call
+static void test_session_failed_feed(const TinyModel& m) {
+    auto pool = std::make_shared<KVBlockPool>(
+        KVCacheConfig{m.cfg.n_layers, 0, m.cfg.n_heads, m.cfg.n_kv_heads, m.cfg.head_dim(), DType::F16},
+        /*block_size*/ 16, /*num_blocks*/ 20);
+    Session other(std::make_unique<RuntimeCtx>(m.cfg, m.weights, pool));
+    other.feed(std::vector<int32_t>(48, 1), 1);                   // holds 3 blocks
+    Session s(std::make_unique<RuntimeCtx>(m.cfg, m.weights, pool));
+    s.feed({2, 3}, 1);
+    const int64_t free_before = pool->num_free();
+
+    std::vector<int32_t> long_prompt(300);
+    for (size_t i = 0; i < long_prompt.size(); ++i) long_prompt[i] = static_cast<int32_t>(i % 50);
+    bool threw = false;
+    try { s.feed(long_prompt, 1); } catch (const std::runtime_error&) { threw = true; }
+    if (!threw || s.pos() != 2 || pool->num_free() != free_before || s.ctx().kv().filled() != 2) {
+        std::cerr << "FAIL failed feed left the session changed\n";
+        ++failures;
+    }
+
+    Session ref(std::make_unique<RuntimeCtx>(m.cfg, m.weights, 64));
+    ref.feed({2, 3}, 4);
+    expect_same("session after failed feed", s.feed({4, 5}, 4), ref.feed({4, 5}, 4));
+    std::cout << "session: failed feed rolled back\n";
 }
 
+// fuse_qkv_weights folds the Q/K/V biases into the fused projection: prefill
+// and decode match the unfused weights
+static void test_fused_qkv_bias() {
+    TinyModel m(/*qkv_bias*/ true);
+    ModelWeights fused = m.weights;
+    fuse_qkv_weights(fused);
+    const LayerWeightsCXX lw = fused.get_layer_weights(0);
+    if (!lw.attn.Wqkv.defined() || !lw.attn.bqkv) {
+        std::cerr << "FAIL fuse_qkv_weights left a biased layer unfused\n";
+        ++failures;
+        return;
+    }
+    Session plain(std::make_unique<RuntimeCtx>(m.cfg, m.weights, 64));
+    Session fast(std::make_unique<RuntimeCtx>(m.cfg, fused, 64));
+    const std::vector<int32_t> prompt{7, 1, 44, 23, 9, 30};
+    expect_same("fused qkv prefill", fast.feed(prompt, 5), plain.feed(prompt, 5));
+    expect_same("fused qkv decode", fast.feed({12}, 5), plain.feed({12}, 5));
+    std::cout << "fused qkv: biases carried into the fused projection\n";
+}
+
+// One RoPE table per model: copies of the weights share it, a longer request
+// replaces it for later callers without touching the one already handed out
+static void test_shared_rope_table(const TinyModel& m) {
+    const ModelWeights copy = m.weights;
+    const auto a = m.weights.rope_table(8, 10000.0f, 64);
+    const auto b = copy.rope_table(8, 10000.0f, 32);
+    const auto c = m.weights.rope_table(8, 10000.0f, 128);
+    const auto d = copy.rope_table(8, 500000.0f, 16);
+    if (a != b || a->size() != 64 || c == a || c->size() != 128 || copy.rope_table(8, 10000.0f, 64) != c ||
+        d == c || d->theta() != 500000.0f) {
+        std::cerr << "FAIL rope tables not shared per model\n";
+        ++failures;
+    }
+    std::cout << "rope: one table per model, shared by its copies\n";
+}
+
+// Prefix caching through RuntimeCtx: publish -> attach -> prefill of the rest
+// matches an uncached run, attach always leaves a token to compute, evicts
+// cached blocks the pool is short of, and a sequence that rewrites part of a
+// published block (truncate + refeed) leaves the cached copy intact
+static void test_prefix_attach(const TinyModel& m) {
+    const KVCacheConfig kcfg{m.cfg.n_layers, 0, m.cfg.n_heads, m.cfg.n_kv_heads, m.cfg.head_dim(), DType::F16};
+    const std::vector<int32_t> prompt{4, 8, 15, 16, 23, 42, 7, 9, 11, 3};
+    const int64_t k = 5;
+    auto tail = [](const std::vector<int32_t>& t, int64_t from) {
+        return std::vector<int32_t>(t.begin() + from, t.end());
+    };
+    auto uncached = [&](const std::vector<int32_t>& t) {
+        RuntimeCtx ref(m.cfg, m.weights, 64);
+        return ref.forward_prefill_topk(t, 0, k);
+    };
+    {
+        auto pool = std::make_shared<KVBlockPool>(kcfg, /*block_size*/ 4, /*num_blocks*/ 12);
+        PrefixCache prefixes(pool, /*max_blocks*/ 8);
+        RuntimeCtx a(m.cfg, m.weights, pool);
+        if (a.attach_prefix(prefixes, prompt) != 0) ++failures;
+        expect_same("prefix first run", a.forward_prefill_topk(prompt, 0, k), uncached(prompt));
+        a.publish_prefix(prefixes, prompt);
+        if (prefixes.cached_blocks() != 2) ++failures;
+
+        RuntimeCtx b(m.cfg, m.weights, pool);
+        if (b.attach_prefix(prefixes, prompt) != 8) ++failures;
+        expect_same("prefix attached prefill", b.forward_prefill_topk(tail(prompt, 8), 8, k), uncached(prompt));
+
+        // A prompt of exactly two blocks reuses one: its last token still runs
+        const std::vector<int32_t> two_blocks(prompt.begin(), prompt.begin() + 8);
+        RuntimeCtx c(m.cfg, m.weights, pool);
+        if (c.attach_prefix(prefixes, two_blocks) != 4) ++failures;
+        expect_same("prefix keeps a token", c.forward_prefill_topk(tail(two_blocks, 4), 4, k), uncached(two_blocks));
 
+        // a rewrites positions 6.. (inside its second, published block) with other tokens
+        std::vector<int32_t> other = prompt;
+        other[6] = 30;
+        other[7] = 31;
+        a.kv().truncate(6);
+        expect_same("prefix refeed after truncate", a.forward_prefill_topk(tail(other, 6), 6, k), uncached(other));
+        RuntimeCtx d(m.cfg, m.weights, pool);
+        if (d.attach_prefix(prefixes, prompt) != 8) ++failures;
+        expect_same("prefix survives a rewrite", d.forward_prefill_topk(tail(prompt, 8), 8, k), uncached(prompt));
+    }
+    {
+        // Pool of 5 blocks: 2 stay cached after the publisher is gone, and a
+        // 5-block prompt with no match gets them evicted
+        auto pool = std::make_shared<KVBlockPool>(kcfg, /*block_size*/ 4, /*num_blocks*/ 5);
+        PrefixCache prefixes(pool, /*max_blocks*/ 8);
+        {
+            RuntimeCtx a(m.cfg, m.weights, pool);
+            a.forward_prefill_topk(prompt, 0, k);
+            a.publish_prefix(prefixes, prompt);
+        }
+        if (pool->num_free() != 3) ++failures;
+        std::vector<int32_t> long_prompt(17);
+        for (size_t i = 0; i < long_prompt.size(); ++i) long_prompt[i] = static_cast<int32_t>((7 * i + 1) % 50);
+        RuntimeCtx e(m.cfg, m.weights, pool);
+        if (e.attach_prefix(prefixes, long_prompt) != 0 || prefixes.cached_blocks() != 0 || pool->num_free() != 5) {
+            std::cerr << "FAIL attach_prefix did not evict for a short pool\n";
+            ++failures;
+        }
+        expect_same("prefix after eviction", e.forward_prefill_topk(long_prompt, 0, k), uncached(long_prompt));
+    }
+    std::cout << "prefix cache: attach / publish through RuntimeCtx match uncached runs\n";
+}
+
+int main() {
+    TinyModel model;
+    test_prefix_attach(model);
+    test_shared_rope_table(model);
+    test_fused_qkv_bias();
+    test_session_suspend_resume(model);
+    test_session_failed_feed(model);
+    if (failures) {
+        std::cerr << failures << " runtime checks failed\n";
+        return 1;
+    }
+    std::cout << "All RuntimeCtx tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,302 @@
+#include "infer_engine/io/model_loader.hpp"
+#include "infer_engine/io/safetensors_reader.hpp"
+#include "infer_engine/io/safetensors_writer.hpp"
+#include "infer_engine/layers/ops/linear.hpp"
+#include "infer_engine/model/config.hpp"
+#include "infer_engine/model/weights.hpp"
+#include "infer_engine/core/tensor.hpp"
+#include "infer_engine/core/half.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace ie {
+namespace test {
+
+static int failures = 0;
+
+static void expect(bool ok, const char* what) {
+    if (!ok) {
+        std::cerr << "FAIL " << what << "\n";
+        ++failures;
+    }
+}
+
+static Tensor random_tensor(const std::vector<int64_t>& shape, std::mt19937& rng) {
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    Tensor t = Tensor::empty(shape, DType::F32);
+    float* p = t.view.ptr<float>();
+    for (int64_t i = 0; i < t.view.numel(); ++i) p[i] = dist(rng);
+    return t;
+}
+
+// Tiny Mistral-style checkpoint: config.json + model.safetensors
+struct TinyCheckpoint {
+    std::filesystem::path dir;
+    std::vector<std::pair<std::string, Tensor>> tensors;
+
+    TinyCheckpoint() {
+        dir = std::filesystem::temp_directory_path() / ("ie_test_safetensors_" + std::to_string(::getpid()));
+        std::filesystem::create_directories(dir);
+        std::ofstream(dir / "config.json") << "{\"hidden_size\": 64, \"num_hidden_layers\": 1, "
+                                              "\"num_attention_heads\": 2, \"num_key_value_heads\": 2, "
+                                              "\"vocab_size\": 32, \"rope_theta\": 10000.0}";
+        std::mt19937 rng(7);
+        auto add = [&](const std::string& name, std::vector<int64_t> shape) {
+            tensors.emplace_back(name, random_tensor(shape, rng));
+        };
+        add("tok_embeddings.weight", {32, 64});
+        add("output.weight", {32, 64});
+        add("norm.weight", {64});
+        for (const char* w : {"wq", "wk", "wv", "wo"}) add(std::string("layers.0.attention.") + w + ".weight", {64, 64});
+        add("layers.0.feed_forward.w1.weight", {256, 64});
+        add("layers.0.feed_forward.w2.weight", {64, 256});
+        add("layers.0.attention_norm.weight", {64});
+        add("layers.0.ffn_norm.weight", {64});
+
+        SafeTensorWriter writer;
+        writer.set_metadata("format", "pt");
+        for (auto& [name, t] : tensors) writer.add_tensor(name, t.view);
+        writer.write((dir / "model.safetensors").string());
+    }
+    ~TinyCheckpoint() { std::filesystem::remove_all(dir); }
+
+    const TensorView& get(const std::string& name) const {
+        for (auto& [n, t] : tensors) if (n == name) return t.view;
+        throw std::runtime_error("no tensor " + name);
+    }
+};
+
+void test_writer_round_trip(const TinyCheckpoint& ck) {
+    SafeTensorReader reader((ck.dir / "model.safetensors").string());
+    expect(reader.metadata().count("format") && reader.metadata().at("format") == "pt", "metadata round trip");
+    expect(reader.get_tensor_names().size() == ck.tensors.size(), "tensor count");
+    for (auto& [name, t] : ck.tensors) {
+        TensorView v = reader.get_tensor(name);
+        expect(v.shape == t.view.shape && v.dt == DType::F32, "shape and dtype");
+        expect(std::memcmp(v.data, t.view.data, t.view.nbytes()) == 0, "tensor bytes");
+        expect(reinterpret_cast<uintptr_t>(v.data) % sizeof(float) == 0, "F32 data aligned");
+    }
+    std::cout << "safetensors: writer/reader round trip checked\n";
+}
+
+void test_export_and_bind(const TinyCheckpoint& ck, const ops::QuantScheme& scheme, const char* label) {
+    const std::string src = source_safetensors_path(ck.dir.string());
+    const std::string dst = (ck.dir / kQuantizedSafetensors).string();
+    const size_t n = export_quantized_safetensors(src, dst, scheme);
+    expect(n == 6, "every projection quantized");
+
+    ModelCfg cfg;
+    ModelWeights weights;
+    load_mistral_safetensors(ck.dir.string(), cfg, weights);
+    expect(cfg.d_model == 64 && cfg.n_layers == 1, "config parsed");
+    LayerWeightsCXX lw = weights.get_layer_weights(0);
+    expect(weights.get_lm_head().dt == DType::F32, "lm_head kept as stored");
+
+    // Bound views must match quantizing the originals in memory, bit for bit
+    struct { const TensorView* bound; const char* name; } cases[] = {
+        {&lw.attn.Wq, "layers.0.attention.wq.weight"},
+        {&lw.attn.Wo, "layers.0.attention.wo.weight"},
+        {&lw.mlp.W1, "layers.0.feed_forward.w1.weight"},
+        {&lw.mlp.W2, "layers.0.feed_forward.w2.weight"},
+    };
+    for (auto& c : cases) {
+        const TensorView& W = ck.get(c.name);
+        std::vector<uint8_t> buf(ops::quantized_weight_bytes(W, scheme) + 64);
+        void* dst_buf = reinterpret_cast<void*>((reinterpret_cast<uintptr_t>(buf.data()) + 63) & ~uintptr_t(63));
+        TensorView q = ops::quantize_weight(W, scheme, dst_buf);
+        const TensorView& b = *c.bound;
+        expect(b.dt == q.dt && b.shape == q.shape && b.quant.group_size == q.quant.group_size, "bound view params");
+        expect(std::memcmp(b.data, q.data, q.nbytes()) == 0, "bound values");
+        const int64_t groups = q.dt == DType::Q4 ? q.shape[1] / q.quant.group_size : 1;
+        const size_t sb = static_cast<size_t>(q.shape[0] * groups) * sizeof(float);
+        expect(std::memcmp(b.quant.scales, q.quant.scales, sb) == 0, "bound scales");
+        expect((b.quant.zeros == nullptr) == (q.quant.zeros == nullptr), "zeros presence");
+        if (q.quant.zeros) expect(std::memcmp(b.quant.zeros, q.quant.zeros, sb) == 0, "bound zeros");
+
+        std::mt19937 rng(3);
+        Tensor x = random_tensor({2, W.shape[1]}, rng);
+        Tensor yb = ops::linear(x.view, b);
+        Tensor yq = ops::linear(x.view, q);
+        expect(std::memcmp(yb.view.data, yq.view.data, yb.view.nbytes()) == 0, "linear on bound view");
+    }
+
+    // Opting out binds the original checkpoint
+    ModelCfg cfg2;
+    ModelWeights plain;
+    LoadOptions opts;
+    opts.use_prequantized = false;
+    load_mistral_safetensors(ck.dir.string(), cfg2, plain, opts);
+    expect(plain.get_layer_weights(0).attn.Wq.dt == DType::F32, "use_prequantized = false");
+
+    std::filesystem::remove(dst);
+    std::cout << "safetensors: export and zero-copy bind checked (" << label << ")\n";
+}
+
+void test_export_smoothquant(const TinyCheckpoint& ck) {
+    // Calibration stats for one projection: only that one gets smooth scales
+    const std::string wq = "layers.0.attention.wq.weight";
+    std::vector<float> absmax(64);
+    for (size_t k = 0; k < absmax.size(); ++k) absmax[k] = (k == 5) ? 30.0f : 1.0f;
+    SafeTensorWriter calib;
+    calib.add_tensor(wq + ".act_absmax", "F32", {64}, absmax.data(), absmax.size() * sizeof(float));
+    const std::string calib_path = (ck.dir / "calib.safetensors").string();
+    calib.write(calib_path);
+
+    ops::QuantScheme scheme;
+    SmoothQuantStats stats{calib_path, 0.5f};
+    const std::string dst = (ck.dir / kQuantizedSafetensors).string();
+    export_quantized_safetensors(source_safetensors_path(ck.dir.string()), dst, scheme, &stats);
+
+    ModelCfg cfg;
+    ModelWeights weights;
+    LoadOptions opts;
+    opts.quant_activations = true;
+    load_mistral_safetensors(ck.dir.string(), cfg, weights, opts);
+    LayerWeightsCXX lw = weights.get_layer_weights(0);
+    expect(lw.attn.Wq.quant.smooth != nullptr && lw.attn.Wk.quant.smooth == nullptr, "smooth bound where calibrated");
+    expect(lw.attn.Wq.quant.dynamic_act && lw.mlp.W2.quant.dynamic_act, "quant_activations marks I8 projections");
+
+    std::vector<float> want(64);
+    ops::smooth_quant_scales(absmax.data(), ck.get(wq), 0.5f, want.data());
+    expect(std::memcmp(lw.attn.Wq.quant.smooth, want.data(), want.size() * sizeof(float)) == 0, "smooth scales");
+
+    std::filesystem::remove(dst);
+    std::filesystem::remove(calib_path);
+    std::cout << "safetensors: SmoothQuant export checked\n";
+}
+
+// HF-named GPTQ checkpoint: packed q/v/o/up projections, plain k/gate/down,
+// tied lm_head. q and k rows must come out in the interleaved RoPE order.
+void test_load_gptq_hf() {
+    const auto dir = std::filesystem::temp_directory_path() / ("ie_test_gptq_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "config.json") << "{\"hidden_size\": 64, \"num_hidden_layers\": 1, "
+                                          "\"num_attention_heads\": 2, \"num_key_value_heads\": 2, "
+                                          "\"vocab_size\": 32, \"rope_theta\": 10000.0, "
+                                          "\"quantization_config\": {\"quant_method\": \"gptq\", \"bits\": 4, "
+                                          "\"group_size\": 32, \"desc_act\": false}}";
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> nib(0, 15);
+    const int64_t G = 32;
+
+    // One packed projection: q [D_out][D_in] nibbles, zeros [groups][D_out], F16 scales
+    struct Packed {
+        int64_t D_out, D_in;
+        std::vector<uint8_t> q, z;
+        std::vector<uint16_t> s;
+        std::vector<int32_t> qweight, qzeros, g_idx;
+        float at(int64_t j, int64_t k) const {
+            const size_t gi = static_cast<size_t>((k / 32) * D_out + j);
+            return half::f16_to_f32(s[gi]) * (static_cast<float>(q[static_cast<size_t>(j * D_in + k)]) - static_cast<float>(z[gi]));
+        }
+    };
+    auto make_packed = [&](int64_t D_out, int64_t D_in) {
+        Packed p{D_out, D_in, {}, {}, {}, {}, {}, {}};
+        const int64_t groups = D_in / G;
+        p.q.resize(static_cast<size_t>(D_out * D_in));
+        p.z.resize(static_cast<size_t>(groups * D_out));
+        p.s.resize(p.z.size());
+        for (auto& v : p.q) v = static_cast<uint8_t>(nib(rng));
+        for (auto& v : p.z) v = static_cast<uint8_t>(nib(rng));
+        std::uniform_real_distribution<float> sd(0.01f, 0.1f);
+        for (auto& v : p.s) v = half::f32_to_f16(sd(rng));
+        p.qweight.assign(static_cast<size_t>(D_in / 8 * D_out), 0);
+        p.qzeros.assign(static_cast<size_t>(groups * D_out / 8), 0);
+        for (int64_t j = 0; j < D_out; ++j) {
+            for (int64_t k = 0; k < D_in; ++k) {
+                uint32_t& w = reinterpret_cast<uint32_t&>(p.qweight[static_cast<size_t>((k / 8) * D_out + j)]);
+                w |= static_cast<uint32_t>(p.q[static_cast<size_t>(j * D_in + k)]) << (4 * (k % 8));
+            }
+            for (int64_t g = 0; g < groups; ++g) {
+                uint32_t& w = reinterpret_cast<uint32_t&>(p.qzeros[static_cast<size_t>(g * (D_out / 8) + j / 8)]);
+                w |= static_cast<uint32_t>((p.z[static_cast<size_t>(g * D_out + j)] - 1) & 0xF) << (4 * (j % 8)); // GPTQ v1
+            }
+        }
+        for (int64_t k = 0; k < D_in; ++k) p.g_idx.push_back(static_cast<int32_t>(k / G));
+        return p;
+    };
+
+    SafeTensorWriter writer;
+    std::vector<Tensor> plain;
+    auto add_plain = [&](const std::string& name, std::vector<int64_t> shape) {
+        plain.push_back(random_tensor(shape, rng));
+        writer.add_tensor(name, plain.back().view);
+        return plain.back().view;
+    };
+    auto add_packed = [&](const std::string& stem, const Packed& p) {
+        writer.add_tensor(stem + ".qweight", "I32", {p.D_in / 8, p.D_out}, p.qweight.data(), p.qweight.size() * 4);
+        writer.add_tensor(stem + ".qzeros", "I32", {p.D_in / G, p.D_out / 8}, p.qzeros.data(), p.qzeros.size() * 4);
+        writer.add_tensor(stem + ".scales", "F16", {p.D_in / G, p.D_out}, p.s.data(), p.s.size() * 2);
+        writer.add_tensor(stem + ".g_idx", "I32", {p.D_in}, p.g_idx.data(), p.g_idx.size() * 4);
+    };
+    const std::string L = "model.layers.0.";
+    add_plain("model.embed_tokens.weight", {32, 64});
+    add_plain("model.norm.weight", {64});
+    add_plain(L + "input_layernorm.weight", {64});
+    add_plain(L + "post_attention_layernorm.weight", {64});
+    const Packed wq = make_packed(64, 64), wv = make_packed(64, 64), wo = make_packed(64, 64), up = make_packed(256, 64);
+    add_packed(L + "self_attn.q_proj", wq);
+    add_packed(L + "self_attn.v_proj", wv);
+    add_packed(L + "self_attn.o_proj", wo);
+    add_packed(L + "mlp.up_proj", up);
+    TensorView wk = add_plain(L + "self_attn.k_proj.weight", {64, 64});
+    add_plain(L + "mlp.gate_proj.weight", {256, 64});
+    add_plain(L + "mlp.down_proj.weight", {64, 256});
+    writer.write((dir / "model.safetensors").string());
+
+    ModelCfg cfg;
+    ModelWeights weights;
+    load_mistral_safetensors(dir.string(), cfg, weights);
+    LayerWeightsCXX lw = weights.get_layer_weights(0);
+    expect(weights.get_lm_head().data == weights.get_token_embeddings().data, "tied lm_head");
+    expect(lw.attn.Wq.dt == DType::Q4 && lw.attn.Wo.dt == DType::Q4 && lw.mlp.W3.dt == DType::Q4, "packed projections bound as Q4");
+    expect(lw.mlp.W1.dt == DType::F32 && lw.mlp.W3.data != lw.mlp.W1.data, "up_proj bound as W3");
+
+    // Engine row m of head h is HF row h*D + (m%2)*D/2 + (m%D)/2, D = 32
+    auto hf_row = [](int64_t m) { return (m / 32) * 32 + (m % 2) * 16 + (m % 32) / 2; };
+    Tensor q = astype_copy(lw.attn.Wq, DType::F32), o = astype_copy(lw.attn.Wo, DType::F32);
+    bool q_ok = true, o_ok = true, k_ok = true;
+    for (int64_t j = 0; j < 64; ++j) {
+        for (int64_t k = 0; k < 64; ++k) {
+            q_ok = q_ok && q.view.ptr<float>()[j * 64 + k] == wq.at(hf_row(j), k);
+            o_ok = o_ok && o.view.ptr<float>()[j * 64 + k] == wo.at(j, k);
+            k_ok = k_ok && lw.attn.Wk.ptr<float>()[j * 64 + k] == wk.ptr<float>()[hf_row(j) * 64 + k];
+        }
+    }
+    expect(q_ok, "GPTQ q_proj repacked in RoPE row order");
+    expect(o_ok, "GPTQ o_proj repacked");
+    expect(k_ok, "plain k_proj rows permuted");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "safetensors: HF GPTQ checkpoint checked\n";
+}
+
+} // namespace test
+} // namespace ie
+
+int main() {
+    using namespace ie;
+    test::TinyCheckpoint ck;
+    test::test_writer_round_trip(ck);
+
+    ops::QuantScheme i8;
+    test::test_export_and_bind(ck, i8, "i8");
+    ops::QuantScheme q4;
+    q4.dt = DType::Q4;
+    q4.group_size = 32;
+    test::test_export_and_bind(ck, q4, "q4 g32");
+    q4.group_size = 64;
+    q4.zero_points = true;
+    test::test_export_and_bind(ck, q4, "q4 g64 zp");
+    test::test_export_smoothquant(ck);
+    test::test_load_gptq_hf();
+    return test::failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+#include "infer_engine/core/thread_pool.hpp"
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace ie {
+namespace test {
+
+static int failures = 0;
+
+static void expect(bool ok, const char* what) {
+    if (!ok) {
+        std::cerr << "FAIL " << what << "\n";
+        ++failures;
+    }
+}
+
+void test_every_index_once() {
+    // Uneven task counts so the initial shares differ and stealing kicks in
+    ThreadPoolOptions opts;
+    opts.num_threads = 4;
+    opts.spin_us = 10;
+    ThreadPool pool(opts);
+    for (int64_t n : {1, 3, 4, 17, 1000}) {
+        std::vector<std::atomic<int>> hits(static_cast<size_t>(n));
+        for (int rep = 0; rep < 50; ++rep) {
+            for (auto& h : hits) h.store(0);
+            pool.run(n, [](void* ctx, int64_t i) {
+                (*static_cast<std::vector<std::atomic<int>>*>(ctx))[static_cast<size_t>(i)].fetch_add(1);
+            }, &hits);
+            bool ok = true;
+            for (auto& h : hits) ok = ok && h.load() == 1;
+            expect(ok, "every index runs exactly once");
+        }
+    }
+    std::cout << "thread_pool: index coverage checked\n";
+}
+
+void test_nested_and_exceptions() {
+    // Nested regions run inline; an exception in a task reaches the caller
+    ThreadPoolOptions opts;
+    opts.num_threads = 4;
+    ThreadPool pool(opts);
+    std::atomic<int64_t> sum{0};
+    pool.run(8, [](void* ctx, int64_t i) {
+        auto* s = static_cast<std::atomic<int64_t>*>(ctx);
+        parallel_for(8, [&](int64_t j) { s->fetch_add(i * 8 + j); });
+    }, &sum);
+    expect(sum.load() == 63 * 64 / 2, "nested parallel_for");
+
+    bool caught = false;
+    try {
+        pool.run(16, [](void*, int64_t i) {
+            if (i == 5) throw std::runtime_error("task failed");
+        }, nullptr);
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    expect(caught, "exception propagates to caller");
+    std::cout << "thread_pool: nesting and exceptions checked\n";
+}
+
+} // namespace test
+} // namespace ie
+
+int main() {
+    ie::test::test_every_index_once();
+    ie::test::test_nested_and_exceptions();
+    return ie::test::failures == 0 ? 0 : 1;
+}
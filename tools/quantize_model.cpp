@@ -0,0 +1,73 @@
+// Offline weight quantization: writes <model_dir>/quantized.safetensors, which
+// load_mistral_safetensors then binds directly instead of quantizing at startup.
+#include "infer_engine/io/model_loader.hpp"
+#include "infer_engine/layers/ops/linear.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    using namespace ie;
+
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <model_dir> [--quantize i8|q4] [--group_size N] [--zero_points]"
+                  << " [--act_stats calib.safetensors] [--smooth_alpha A] [--out path]\n";
+        return 1;
+    }
+
+    const std::string model_dir = argv[1];
+    std::string out_path = model_dir + "/" + kQuantizedSafetensors;
+    ops::QuantScheme scheme;
+    SmoothQuantStats smooth;
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--quantize" && i + 1 < argc) {
+            const std::string q = argv[++i];
+            if (q == "i8") scheme.dt = DType::I8;
+            else if (q == "q4") scheme.dt = DType::Q4;
+            else { std::cerr << "Unknown --quantize " << q << " (expected i8 or q4)\n"; return 1; }
+        } else if (a == "--group_size" && i + 1 < argc) {
+            scheme.group_size = std::atoll(argv[++i]);
+        } else if (a == "--zero_points") {
+            scheme.zero_points = true;
+        } else if (a == "--act_stats" && i + 1 < argc) {
+            smooth.path = argv[++i];
+        } else if (a == "--smooth_alpha" && i + 1 < argc) {
+            smooth.alpha = static_cast<float>(std::atof(argv[++i]));
+        } else if (a == "--out" && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            std::cerr << "Unknown argument: " << a << "\n";
+            return 1;
+        }
+    }
+
+    try {
+        const std::string src_path = source_safetensors_path(model_dir);
+        std::cout << "Quantizing " << src_path << " to " << dtype_name(scheme.dt);
+        if (scheme.dt == DType::Q4) std::cout << " g" << scheme.group_size << (scheme.zero_points ? " +zp" : "");
+        if (!smooth.path.empty()) {
+            if (scheme.dt != DType::I8) {
+                std::cerr << "--act_stats (SmoothQuant) applies to --quantize i8 only\n";
+                return 1;
+            }
+            std::cout << " smoothed (alpha " << smooth.alpha << ", stats " << smooth.path << ")";
+        }
+        std::cout << std::endl;
+
+        auto t0 = std::chrono::steady_clock::now();
+        const size_t n = export_quantized_safetensors(src_path, out_path, scheme,
+                                                      smooth.path.empty() ? nullptr : &smooth);
+        auto t1 = std::chrono::steady_clock::now();
+        std::cout << "Wrote " << out_path << ": " << n << " projections quantized in "
+                  << std::chrono::duration<double>(t1 - t0).count() << " s" << std::endl;
+        if (n == 0) {
+            std::cerr << "Warning: no projection fits the scheme; the output is a plain copy\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}